@@ -3,53 +3,36 @@
 #undef TAG
 #define TAG "ChameleonApp"
 
-// Callback for UART/BLE data reception
-void chameleon_app_rx_callback(const uint8_t* data, size_t length, void* context) {
-    ChameleonApp* app = context;
-    
-    FURI_LOG_D(TAG, "Received %zu bytes", length);
-    
-    // Acquire mutex
-    furi_mutex_acquire(app->response_mutex, FuriWaitForever);
-    
-    // Validate frame
-    if(length < CHAMELEON_FRAME_OVERHEAD || !chameleon_protocol_validate_frame(data, length)) {
-        FURI_LOG_W(TAG, "Invalid frame received");
-        furi_mutex_release(app->response_mutex);
-        return;
-    }
-    
-    // Parse the frame
-    uint16_t cmd, status;
-    uint16_t data_len;
-    
-    if(chameleon_protocol_parse_frame(
-        app->protocol,
-        data,
-        length,
-        &cmd,
-        &status,
-        app->data_buffer,
-        &data_len)) {
-        
-        FURI_LOG_I(TAG, "Parsed frame - CMD: 0x%04X, Status: 0x%04X, Data len: %u", cmd, status, data_len);
-        
-        // Store response
-        app->response_cmd = cmd;
-        app->response_status = status;
-        app->response_length = data_len;
-        memcpy(app->response_buffer, app->data_buffer, data_len);
-        app->response_ready = true;
-    } else {
-        FURI_LOG_E(TAG, "Failed to parse frame");
-    }
-    
-    furi_mutex_release(app->response_mutex);
-}
+// Last connected BLE device, for reconnecting without a scan
+#define CHAMELEON_APP_BLE_PEER_PATH APP_DATA_PATH("ble_peer.bin")
+#define CHAMELEON_APP_BLE_PEER_MAGIC 0x50454C42 // "BLEP"
+#define CHAMELEON_APP_BLE_PEER_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    BleHandlerPeer peer;
+} ChameleonAppBlePeerFile;
 
 static bool chameleon_app_custom_event_callback(void* context, uint32_t event) {
     furi_assert(context);
     ChameleonApp* app = context;
+
+    // Only a link of the current connection counts, not a scan ending or our
+    // own disconnect. Whatever the scene it leaves nothing to talk to, the
+    // main menu tells the user.
+    if(event == ChameleonCustomEventBleLinkLost) {
+        if(app->connection_type == ChameleonConnectionBLE &&
+           !ble_handler_is_connected(app->ble_handler)) {
+            FURI_LOG_W(TAG, "BLE link lost");
+            chameleon_app_disconnect(app);
+            scene_manager_search_and_switch_to_previous_scene(
+                app->scene_manager, ChameleonSceneMainMenu);
+            scene_manager_handle_custom_event(app->scene_manager, event);
+        }
+        return true;
+    }
+
     return scene_manager_handle_custom_event(app->scene_manager, event);
 }
 
@@ -59,6 +42,18 @@ static bool chameleon_app_back_event_callback(void* context) {
     return scene_manager_handle_back_event(app->scene_manager);
 }
 
+static void chameleon_app_ble_scan_callback(void* context) {
+    ChameleonApp* app = context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, ChameleonCustomEventBleDevicesChanged);
+}
+
+static void chameleon_app_ble_status_callback(BleStatus status, void* context) {
+    ChameleonApp* app = context;
+    if(status == BleStatusDisconnected) {
+        view_dispatcher_send_custom_event(app->view_dispatcher, ChameleonCustomEventBleLinkLost);
+    }
+}
+
 ChameleonApp* chameleon_app_alloc() {
     ChameleonApp* app = malloc(sizeof(ChameleonApp));
     memset(app, 0, sizeof(ChameleonApp));
@@ -69,6 +64,8 @@ ChameleonApp* chameleon_app_alloc() {
     app->dialogs = furi_record_open(RECORD_DIALOGS);
     app->storage = furi_record_open(RECORD_STORAGE);
 
+    app->device_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+
     // Initialize view dispatcher
     app->view_dispatcher = view_dispatcher_alloc();
     view_dispatcher_set_event_callback_context(app->view_dispatcher, app);
@@ -110,22 +107,19 @@ ChameleonApp* chameleon_app_alloc() {
         ChameleonViewAnimation,
         chameleon_animation_view_get_view(app->animation_view));
 
-    // Initialize protocol
-    app->protocol = chameleon_protocol_alloc();
+    // Initialize request engine
+    app->engine = chameleon_engine_alloc();
 
     // Initialize handlers
     app->uart_handler = uart_handler_alloc();
     app->ble_handler = ble_handler_alloc();
+    ble_handler_set_scan_callback(app->ble_handler, chameleon_app_ble_scan_callback, app);
+    ble_handler_set_status_callback(app->ble_handler, chameleon_app_ble_status_callback, app);
 
     // Initialize connection state
     app->connection_type = ChameleonConnectionNone;
     app->connection_status = ChameleonStatusDisconnected;
 
-    // Initialize response handling
-    app->response_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
-    app->response_ready = false;
-    app->response_length = 0;
-
     // Initialize slots
     for(uint8_t i = 0; i < 8; i++) {
         app->slots[i].slot_number = i;
@@ -143,17 +137,15 @@ void chameleon_app_free(ChameleonApp* app) {
     furi_assert(app);
 
     // Disconnect if connected
+    chameleon_app_ble_connect_wait(app);
     chameleon_app_disconnect(app);
 
-    // Free response mutex
-    furi_mutex_free(app->response_mutex);
-
     // Free handlers
     uart_handler_free(app->uart_handler);
     ble_handler_free(app->ble_handler);
 
-    // Free protocol
-    chameleon_protocol_free(app->protocol);
+    // Free request engine
+    chameleon_engine_free(app->engine);
 
     // Free views
     view_dispatcher_remove_view(app->view_dispatcher, ChameleonViewSubmenu);
@@ -189,6 +181,7 @@ void chameleon_app_free(ChameleonApp* app) {
     furi_record_close(RECORD_DIALOGS);
     furi_record_close(RECORD_STORAGE);
 
+    furi_mutex_free(app->device_mutex);
     free(app);
 }
 
@@ -202,18 +195,56 @@ bool chameleon_app_connect_usb(ChameleonApp* app) {
         return false;
     }
 
-    // Set RX callback
-    uart_handler_set_rx_callback(app->uart_handler, chameleon_app_rx_callback, app);
-    
-    uart_handler_start_rx(app->uart_handler);
-
-    app->connection_type = ChameleonConnectionUSB;
-    app->connection_status = ChameleonStatusConnected;
+    chameleon_app_attach_transport(app, ChameleonConnectionUSB);
 
     FURI_LOG_I(TAG, "Connected via USB");
     return true;
 }
 
+static bool chameleon_app_ble_peer_load(ChameleonApp* app, BleHandlerPeer* peer) {
+    ChameleonAppBlePeerFile record;
+    File* file = storage_file_alloc(app->storage);
+
+    bool loaded =
+        storage_file_open(file, CHAMELEON_APP_BLE_PEER_PATH, FSAM_READ, FSOM_OPEN_EXISTING) &&
+        storage_file_read(file, &record, sizeof(record)) == sizeof(record) &&
+        record.magic == CHAMELEON_APP_BLE_PEER_MAGIC &&
+        record.version == CHAMELEON_APP_BLE_PEER_VERSION;
+
+    storage_file_close(file);
+    storage_file_free(file);
+
+    if(loaded) {
+        *peer = record.peer;
+        peer->name[sizeof(peer->name) - 1] = '\0';
+    }
+
+    return loaded;
+}
+
+// Written only when the device or its handles changed, spares the flash
+static void chameleon_app_ble_peer_save(ChameleonApp* app) {
+    ChameleonAppBlePeerFile record;
+    memset(&record, 0, sizeof(record));
+    record.magic = CHAMELEON_APP_BLE_PEER_MAGIC;
+    record.version = CHAMELEON_APP_BLE_PEER_VERSION;
+
+    BleHandlerPeer saved;
+    if(!ble_handler_get_peer(app->ble_handler, &record.peer) ||
+       (chameleon_app_ble_peer_load(app, &saved) &&
+        memcmp(&saved, &record.peer, sizeof(saved)) == 0)) {
+        return;
+    }
+
+    File* file = storage_file_alloc(app->storage);
+    if(!storage_file_open(file, CHAMELEON_APP_BLE_PEER_PATH, FSAM_WRITE, FSOM_CREATE_ALWAYS) ||
+       storage_file_write(file, &record, sizeof(record)) != sizeof(record)) {
+        FURI_LOG_W(TAG, "Failed to save the BLE device");
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+}
+
 bool chameleon_app_connect_ble(ChameleonApp* app) {
     furi_assert(app);
 
@@ -233,11 +264,99 @@ bool chameleon_app_connect_ble(ChameleonApp* app) {
     return true;
 }
 
+static int32_t chameleon_app_ble_connect_worker(void* context) {
+    ChameleonApp* app = context;
+    bool success;
+
+    if(app->ble_reconnect) {
+        FURI_LOG_I(TAG, "Reconnecting via BLE");
+        success = ble_handler_init(app->ble_handler) &&
+                  ble_handler_connect_peer(app->ble_handler, &app->ble_peer);
+        if(!success) {
+            FURI_LOG_W(TAG, "Reconnect failed, scanning");
+        }
+    } else {
+        success = ble_handler_connect(app->ble_handler, app->ble_device_id);
+    }
+
+    if(success) {
+        chameleon_app_attach_transport(app, ChameleonConnectionBLE);
+    }
+
+    app->ble_callback(success, app->ble_context);
+    return 0;
+}
+
+static void chameleon_app_ble_connect_start(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context) {
+    app->ble_callback = callback;
+    app->ble_context = context;
+
+    app->ble_worker = furi_thread_alloc();
+    furi_thread_set_name(app->ble_worker, "ChameleonBleConnect");
+    furi_thread_set_stack_size(app->ble_worker, 2048);
+    furi_thread_set_context(app->ble_worker, app);
+    furi_thread_set_callback(app->ble_worker, chameleon_app_ble_connect_worker);
+    furi_thread_start(app->ble_worker);
+}
+
+void chameleon_app_connect_ble_device_async(
+    ChameleonApp* app,
+    size_t device_id,
+    ChameleonAppCallback callback,
+    void* context) {
+    furi_assert(app);
+    furi_assert(callback);
+
+    chameleon_app_ble_connect_wait(app);
+
+    app->ble_reconnect = false;
+    app->ble_device_id = device_id;
+    chameleon_app_ble_connect_start(app, callback, context);
+}
+
+bool chameleon_app_reconnect_ble_async(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context) {
+    furi_assert(app);
+    furi_assert(callback);
+
+    chameleon_app_ble_connect_wait(app);
+
+    if(!chameleon_app_ble_peer_load(app, &app->ble_peer)) {
+        return false;
+    }
+
+    app->ble_reconnect = true;
+    chameleon_app_ble_connect_start(app, callback, context);
+    return true;
+}
+
+void chameleon_app_ble_connect_wait(ChameleonApp* app) {
+    furi_assert(app);
+
+    if(app->ble_worker) {
+        furi_thread_join(app->ble_worker);
+        furi_thread_free(app->ble_worker);
+        app->ble_worker = NULL;
+    }
+}
+
 void chameleon_app_disconnect(ChameleonApp* app) {
     furi_assert(app);
 
     FURI_LOG_I(TAG, "Disconnecting");
 
+    if(chameleon_transport_is_bound(&app->transport)) {
+        chameleon_transport_stop_rx(&app->transport);
+        chameleon_engine_set_activity_callback(app->engine, NULL, NULL);
+        chameleon_engine_set_transport(app->engine, NULL);
+        chameleon_transport_init(&app->transport, NULL, NULL);
+    }
+
     if(app->connection_type == ChameleonConnectionUSB) {
         uart_handler_deinit(app->uart_handler);
     } else if(app->connection_type == ChameleonConnectionBLE) {
@@ -248,265 +367,595 @@ void chameleon_app_disconnect(ChameleonApp* app) {
     app->connection_type = ChameleonConnectionNone;
     app->connection_status = ChameleonStatusDisconnected;
 
+    chameleon_app_session_reset(app);
+
     FURI_LOG_I(TAG, "Disconnected");
 }
 
-bool chameleon_app_get_device_info(ChameleonApp* app) {
+// Bulk jobs get the shortest connection interval, a quiet link the longest
+static void chameleon_app_activity_callback(ChameleonEngineActivity activity, void* context) {
+    static const BleHandlerProfile profiles[ChameleonEngineActivityNum] = {
+        [ChameleonEngineActivityIdle] = BleHandlerProfileIdle,
+        [ChameleonEngineActivityInteractive] = BleHandlerProfileInteractive,
+        [ChameleonEngineActivityBulk] = BleHandlerProfileBulk,
+    };
+    ChameleonApp* app = context;
+    ble_handler_set_profile(app->ble_handler, profiles[activity]);
+}
+
+void chameleon_app_attach_transport(ChameleonApp* app, ChameleonConnectionType type) {
     furi_assert(app);
+    furi_assert(type == ChameleonConnectionUSB || type == ChameleonConnectionBLE);
 
-    FURI_LOG_I(TAG, "Getting device info");
+    ChameleonEngineLink link;
+    if(type == ChameleonConnectionUSB) {
+        chameleon_transport_init(&app->transport, &uart_handler_transport, app->uart_handler);
+        link = ChameleonEngineLinkUsb;
+    } else {
+        chameleon_transport_init(&app->transport, &ble_handler_transport, app->ble_handler);
+        link = ChameleonEngineLinkBle;
+    }
 
-    // Build GET_APP_VERSION command
-    uint8_t cmd_buffer[CHAMELEON_FRAME_OVERHEAD];
-    size_t cmd_len;
+    chameleon_engine_set_activity_callback(
+        app->engine, type == ChameleonConnectionBLE ? chameleon_app_activity_callback : NULL, app);
 
-    if(!chameleon_protocol_build_cmd_no_data(app->protocol, CMD_GET_APP_VERSION, cmd_buffer, &cmd_len)) {
-        FURI_LOG_E(TAG, "Failed to build GET_APP_VERSION command");
-        return false;
+    if(type == ChameleonConnectionBLE) {
+        chameleon_app_ble_peer_save(app);
     }
 
-    // Send command
-    if(app->connection_type == ChameleonConnectionUSB) {
-        uart_handler_send(app->uart_handler, cmd_buffer, cmd_len);
-    } else if(app->connection_type == ChameleonConnectionBLE) {
-        ble_handler_send(app->ble_handler, cmd_buffer, cmd_len);
+    chameleon_app_session_reset(app);
+    chameleon_engine_set_link(app->engine, link);
+    chameleon_engine_set_transport(app->engine, &app->transport);
+    chameleon_transport_start_rx(&app->transport);
+
+    app->connection_type = type;
+    app->connection_status = ChameleonStatusConnected;
+
+    chameleon_app_fetch_capabilities(app);
+}
+
+void chameleon_app_session_reset(ChameleonApp* app) {
+    furi_assert(app);
+
+    chameleon_engine_reset(app->engine);
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    app->device_info.valid = false;
+    furi_mutex_release(app->device_mutex);
+}
+
+void chameleon_app_copy_device_info(ChameleonApp* app, ChameleonDeviceInfo* info) {
+    furi_assert(app);
+    furi_assert(info);
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    *info = app->device_info;
+    furi_mutex_release(app->device_mutex);
+}
+
+void chameleon_app_copy_slot(ChameleonApp* app, uint8_t index, ChameleonSlot* slot) {
+    furi_assert(app);
+    furi_assert(index < CHAMELEON_SLOT_COUNT);
+    furi_assert(slot);
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    *slot = app->slots[index];
+    furi_mutex_release(app->device_mutex);
+}
+
+uint8_t chameleon_app_get_active_slot(ChameleonApp* app) {
+    furi_assert(app);
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    uint8_t slot = app->active_slot;
+    furi_mutex_release(app->device_mutex);
+
+    return slot;
+}
+
+void chameleon_app_select_slot(ChameleonApp* app, uint8_t slot) {
+    furi_assert(app);
+    furi_assert(slot < CHAMELEON_SLOT_COUNT);
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    app->active_slot = slot;
+    furi_mutex_release(app->device_mutex);
+}
+
+// Single-command asynchronous operation, freed on completion
+typedef struct ChameleonAppOperation ChameleonAppOperation;
+
+// Apply a successful response to the app caches, runs on the RX thread
+typedef bool (*ChameleonAppOperationHandler)(
+    ChameleonAppOperation* operation,
+    const ChameleonFrameView* response);
+
+struct ChameleonAppOperation {
+    ChameleonApp* app;
+    ChameleonAppOperationHandler handler; // NULL for commands that only return a status
+    ChameleonAppCallback callback;
+    void* context;
+
+    // Request parameters needed again on completion
+    uint8_t slot;
+    ChameleonDeviceMode mode;
+    char nickname[CHAMELEON_SLOT_NICK_LEN + 1];
+};
+
+static ChameleonAppOperation* chameleon_app_operation_alloc(
+    ChameleonApp* app,
+    ChameleonAppOperationHandler handler,
+    ChameleonAppCallback callback,
+    void* context) {
+    ChameleonAppOperation* operation = malloc(sizeof(ChameleonAppOperation));
+    memset(operation, 0, sizeof(ChameleonAppOperation));
+
+    operation->app = app;
+    operation->handler = handler;
+    operation->callback = callback;
+    operation->context = context;
+
+    return operation;
+}
+
+static void chameleon_app_operation_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    ChameleonAppOperation* operation = context;
+    bool success = false;
+
+    if(result != ChameleonEngineResultOk) {
+        FURI_LOG_E(TAG, "Operation failed (result %d)", result);
+    } else if(!chameleon_protocol_status_is_success(response->status)) {
+        FURI_LOG_E(
+            TAG,
+            "%s failed with status: 0x%04X",
+            chameleon_protocol_get_command(response->cmd)->name,
+            response->status);
     } else {
-        FURI_LOG_E(TAG, "Not connected");
-        return false;
+        success = operation->handler ? operation->handler(operation, response) : true;
     }
 
-    // TODO: Wait for response and parse it
-    // For now, set dummy data
-    app->device_info.major_version = 1;
-    app->device_info.minor_version = 0;
-    app->device_info.chip_id = 0x123456789ABCDEF0;
-    app->device_info.model = ChameleonModelUltra;
-    app->device_info.mode = ChameleonModeEmulator;
-    app->device_info.connected = true;
+    operation->callback(success, operation->context);
+    free(operation);
+}
+
+// Submit the operation's command, the operation is freed if it cannot be sent
+static bool chameleon_app_operation_submit(
+    ChameleonAppOperation* operation,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len) {
+    if(!chameleon_engine_submit(
+           operation->app->engine,
+           cmd,
+           data,
+           data_len,
+           chameleon_app_operation_callback,
+           operation)) {
+        free(operation);
+        return false;
+    }
 
-    FURI_LOG_I(TAG, "Device info retrieved");
     return true;
 }
 
-bool chameleon_app_get_slots_info(ChameleonApp* app) {
+void chameleon_app_operation_event_callback(bool success, void* context) {
+    ChameleonApp* app = context;
+
+    view_dispatcher_send_custom_event(
+        app->view_dispatcher,
+        success ? ChameleonCustomEventOperationSuccess : ChameleonCustomEventOperationFailure);
+}
+
+static void chameleon_app_popup_callback(void* context) {
+    ChameleonApp* app = context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, ChameleonCustomEventPopupDone);
+}
+
+void chameleon_app_show_popup(
+    ChameleonApp* app,
+    const char* header,
+    const char* text,
+    uint32_t timeout_ms) {
     furi_assert(app);
 
-    FURI_LOG_I(TAG, "Getting slots info");
+    popup_reset(app->popup);
+    popup_set_header(app->popup, header, 64, 10, AlignCenter, AlignTop);
+    popup_set_text(app->popup, text, 64, 32, AlignCenter, AlignCenter);
+    popup_set_context(app->popup, app);
+    popup_set_callback(app->popup, chameleon_app_popup_callback);
+    popup_set_timeout(app->popup, timeout_ms);
+    popup_enable_timeout(app->popup);
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
+}
 
-    // Clear response flag
-    furi_mutex_acquire(app->response_mutex, FuriWaitForever);
-    app->response_ready = false;
-    furi_mutex_release(app->response_mutex);
+// Load the capability set, runs on the RX thread
+static void chameleon_app_capabilities_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    ChameleonApp* app = context;
 
-    // Build GET_SLOT_INFO command
-    uint8_t cmd_buffer[CHAMELEON_FRAME_OVERHEAD];
-    size_t cmd_len;
+    if(result != ChameleonEngineResultOk) {
+        FURI_LOG_W(TAG, "Capabilities unavailable, assuming all commands supported");
+        return;
+    }
 
-    if(!chameleon_protocol_build_cmd_no_data(app->protocol, CMD_GET_SLOT_INFO, cmd_buffer, &cmd_len)) {
-        FURI_LOG_E(TAG, "Failed to build GET_SLOT_INFO command");
-        return false;
+    // Older firmware rejects the command itself, keep accepting everything
+    if(!chameleon_protocol_status_is_success(response->status)) {
+        FURI_LOG_I(TAG, "Capabilities not reported, assuming all commands supported");
+        return;
     }
 
-    // Send command
-    if(app->connection_type == ChameleonConnectionUSB) {
-        uart_handler_send(app->uart_handler, cmd_buffer, cmd_len);
-    } else if(app->connection_type == ChameleonConnectionBLE) {
-        ble_handler_send(app->ble_handler, cmd_buffer, cmd_len);
+    ChameleonCommandSet capabilities;
+    chameleon_command_set_from_list(&capabilities, response->data, response->data_len);
+    chameleon_engine_set_capabilities(app->engine, &capabilities);
+
+    FURI_LOG_I(TAG, "Device reports %u commands", response->data_len / 2);
+
+    // Menus built before the set arrived still offer everything
+    view_dispatcher_send_custom_event(
+        app->view_dispatcher, ChameleonCustomEventCapabilitiesChanged);
+}
+
+bool chameleon_app_fetch_capabilities(ChameleonApp* app) {
+    furi_assert(app);
+
+    return chameleon_engine_submit(
+        app->engine,
+        CMD_GET_DEVICE_CAPABILITIES,
+        NULL,
+        0,
+        chameleon_app_capabilities_callback,
+        app);
+}
+
+bool chameleon_app_supports(ChameleonApp* app, uint16_t cmd) {
+    furi_assert(app);
+    return chameleon_engine_supports(app->engine, cmd);
+}
+
+// Device info queries, submitted together and completed in any order
+typedef enum {
+    ChameleonDeviceInfoQueryAppVersion,
+    ChameleonDeviceInfoQueryChipId,
+    ChameleonDeviceInfoQueryGitVersion,
+    ChameleonDeviceInfoQueryModel,
+    ChameleonDeviceInfoQueryMode,
+    ChameleonDeviceInfoQueryNum,
+} ChameleonDeviceInfoQueryId;
+
+static const uint16_t chameleon_device_info_commands[ChameleonDeviceInfoQueryNum] = {
+    [ChameleonDeviceInfoQueryAppVersion] = CMD_GET_APP_VERSION,
+    [ChameleonDeviceInfoQueryChipId] = CMD_GET_DEVICE_CHIP_ID,
+    [ChameleonDeviceInfoQueryGitVersion] = CMD_GET_GIT_VERSION,
+    [ChameleonDeviceInfoQueryModel] = CMD_GET_DEVICE_MODEL,
+    [ChameleonDeviceInfoQueryMode] = CMD_GET_DEVICE_MODE,
+};
+
+typedef struct ChameleonDeviceInfoBatch ChameleonDeviceInfoBatch;
+
+typedef struct {
+    ChameleonDeviceInfoBatch* batch;
+    ChameleonDeviceInfoQueryId id;
+} ChameleonDeviceInfoQuery;
+
+struct ChameleonDeviceInfoBatch {
+    ChameleonApp* app;
+    ChameleonDeviceInfo info; // Staging copy, published only if every query succeeds
+    uint32_t received; // Bit per ChameleonDeviceInfoQueryId
+    size_t remaining; // Completions still outstanding, guarded by critical section
+    ChameleonAppCallback callback;
+    void* context;
+    ChameleonDeviceInfoQuery queries[ChameleonDeviceInfoQueryNum];
+};
+
+// Drop references to the batch, the last one publishes the result
+static void chameleon_app_device_info_put(ChameleonDeviceInfoBatch* batch, size_t count) {
+    FURI_CRITICAL_ENTER();
+    batch->remaining -= count;
+    bool last = batch->remaining == 0;
+    FURI_CRITICAL_EXIT();
+
+    if(!last) return;
+
+    bool success = batch->received == (1UL << ChameleonDeviceInfoQueryNum) - 1;
+
+    if(success) {
+        batch->info.connected = true;
+        batch->info.valid = true;
+
+        furi_mutex_acquire(batch->app->device_mutex, FuriWaitForever);
+        batch->app->device_info = batch->info;
+        furi_mutex_release(batch->app->device_mutex);
+
+        FURI_LOG_I(
+            TAG,
+            "Device info retrieved: v%d.%d (%s)",
+            batch->info.major_version,
+            batch->info.minor_version,
+            batch->info.git_version);
     } else {
-        FURI_LOG_E(TAG, "Not connected");
-        return false;
+        FURI_LOG_E(TAG, "Device info incomplete (0x%02lX)", batch->received);
     }
 
-    // Wait for response (with timeout)
-    uint32_t timeout_ms = 2000;
-    uint32_t elapsed_ms = 0;
-    bool got_response = false;
-
-    while(elapsed_ms < timeout_ms) {
-        furi_mutex_acquire(app->response_mutex, FuriWaitForever);
-        
-        if(app->response_ready && app->response_cmd == CMD_GET_SLOT_INFO) {
-            got_response = true;
-            
-            // Check status
-            if(app->response_status != STATUS_SUCCESS) {
-                FURI_LOG_E(TAG, "GET_SLOT_INFO failed with status: 0x%04X", app->response_status);
-                furi_mutex_release(app->response_mutex);
-                return false;
-            }
+    batch->callback(success, batch->context);
+    free(batch);
+}
 
-            // Parse slot info
-            // Expected format: For each slot (8 slots):
-            // - 1 byte: slot number
-            // - 1 byte: HF tag type
-            // - 1 byte: LF tag type  
-            // - 1 byte: HF enabled
-            // - 1 byte: LF enabled
-            // - 32 bytes: nickname (UTF-8, may contain null terminator)
-            // Total per slot: 37 bytes
-            // Total for 8 slots: 296 bytes
-            
-            if(app->response_length >= 296) {
-                const uint8_t* data = app->response_buffer;
-                
-                for(uint8_t i = 0; i < 8; i++) {
-                    size_t offset = i * 37;
-                    
-                    app->slots[i].slot_number = data[offset];
-                    app->slots[i].hf_tag_type = (ChameleonTagType)data[offset + 1];
-                    app->slots[i].lf_tag_type = (ChameleonTagType)data[offset + 2];
-                    app->slots[i].hf_enabled = data[offset + 3] != 0;
-                    app->slots[i].lf_enabled = data[offset + 4] != 0;
-                    
-                    // Copy nickname (ensure null termination)
-                    memcpy(app->slots[i].nickname, &data[offset + 5], 32);
-                    app->slots[i].nickname[32] = '\0';
-                    
-                    FURI_LOG_D(TAG, "Slot %d: HF=%d LF=%d Nick='%s'", 
-                        i, 
-                        app->slots[i].hf_tag_type,
-                        app->slots[i].lf_tag_type,
-                        app->slots[i].nickname);
-                }
-                
-                FURI_LOG_I(TAG, "Slots info parsed successfully");
-            } else {
-                FURI_LOG_W(TAG, "Response too short: %zu bytes (expected 296)", app->response_length);
-                
-                // Set placeholder data for empty slots
-                for(uint8_t i = 0; i < 8; i++) {
-                    snprintf(app->slots[i].nickname, sizeof(app->slots[i].nickname), "Slot %d", i);
-                }
+// Decode one response in place, runs on the RX thread
+static void chameleon_app_device_info_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    ChameleonDeviceInfoQuery* query = context;
+    ChameleonDeviceInfoBatch* batch = query->batch;
+    ChameleonDeviceInfo* info = &batch->info;
+
+    if(result == ChameleonEngineResultOk &&
+       chameleon_protocol_status_is_success(response->status)) {
+        const uint8_t* data = response->data;
+
+        switch(query->id) {
+        case ChameleonDeviceInfoQueryAppVersion:
+            info->major_version = data[0];
+            info->minor_version = data[1];
+            break;
+        case ChameleonDeviceInfoQueryChipId:
+            info->chip_id = 0;
+            for(size_t i = 0; i < 8; i++) {
+                info->chip_id = (info->chip_id << 8) | data[i];
             }
-            
-            app->response_ready = false;
-            furi_mutex_release(app->response_mutex);
+            break;
+        case ChameleonDeviceInfoQueryGitVersion: {
+            size_t len = MIN((size_t)response->data_len, sizeof(info->git_version) - 1);
+            memcpy(info->git_version, data, len);
+            info->git_version[len] = '\0';
             break;
         }
-        
-        furi_mutex_release(app->response_mutex);
-        furi_delay_ms(50);
-        elapsed_ms += 50;
+        case ChameleonDeviceInfoQueryModel:
+            info->model = data[0] == 0 ? ChameleonModelUltra : ChameleonModelLite;
+            break;
+        case ChameleonDeviceInfoQueryMode:
+            // Device reports true for reader mode
+            info->mode = data[0] ? ChameleonModeReader : ChameleonModeEmulator;
+            break;
+        default:
+            break;
+        }
+
+        // Queries write distinct bits and fields, the last put publishes them
+        FURI_CRITICAL_ENTER();
+        batch->received |= 1UL << query->id;
+        FURI_CRITICAL_EXIT();
+    } else if(result == ChameleonEngineResultOk) {
+        FURI_LOG_E(
+            TAG,
+            "%s failed with status: 0x%04X",
+            chameleon_protocol_get_command(response->cmd)->name,
+            response->status);
     }
 
-    if(!got_response) {
-        FURI_LOG_E(TAG, "Timeout waiting for GET_SLOT_INFO response");
-        
-        // Set placeholder data
-        for(uint8_t i = 0; i < 8; i++) {
-            snprintf(app->slots[i].nickname, sizeof(app->slots[i].nickname), "Slot %d (No data)", i);
+    chameleon_app_device_info_put(batch, 1);
+}
+
+bool chameleon_app_get_device_info_async(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context) {
+    furi_assert(app);
+    furi_assert(callback);
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    bool cached = app->device_info.valid;
+    furi_mutex_release(app->device_mutex);
+
+    if(cached) {
+        callback(true, context);
+        return true;
+    }
+
+    FURI_LOG_I(TAG, "Getting device info");
+
+    ChameleonDeviceInfoBatch* batch = malloc(sizeof(ChameleonDeviceInfoBatch));
+    memset(batch, 0, sizeof(ChameleonDeviceInfoBatch));
+    batch->app = app;
+    batch->callback = callback;
+    batch->context = context;
+
+    // One reference per query plus one held while submitting
+    batch->remaining = ChameleonDeviceInfoQueryNum + 1;
+
+    // Send all queries back to back, they complete in any order
+    size_t submitted = 0;
+    for(size_t i = 0; i < ChameleonDeviceInfoQueryNum; i++) {
+        batch->queries[i].batch = batch;
+        batch->queries[i].id = i;
+        if(chameleon_engine_submit(
+               app->engine,
+               chameleon_device_info_commands[i],
+               NULL,
+               0,
+               chameleon_app_device_info_callback,
+               &batch->queries[i])) {
+            submitted++;
         }
-        
+    }
+
+    if(submitted == 0) {
+        free(batch);
         return false;
     }
 
+    chameleon_app_device_info_put(batch, 1 + ChameleonDeviceInfoQueryNum - submitted);
+    return true;
+}
+
+// GET_SLOT_INFO response, read in place from the receive buffer.
+// Layout: CHAMELEON_SLOT_COUNT entries of CHAMELEON_SLOT_INFO_ENTRY_LEN bytes.
+static bool chameleon_app_slots_info_handler(
+    ChameleonAppOperation* operation,
+    const ChameleonFrameView* response) {
+    ChameleonApp* app = operation->app;
+    const uint8_t* data = response->data;
+
+    // Decoded aside and published at once, the GUI reads slots meanwhile
+    ChameleonSlot slots[CHAMELEON_SLOT_COUNT];
+    for(uint8_t i = 0; i < CHAMELEON_SLOT_COUNT; i++) {
+        const uint8_t* entry = &data[i * CHAMELEON_SLOT_INFO_ENTRY_LEN];
+
+        slots[i].slot_number = entry[0];
+        slots[i].hf_tag_type = (ChameleonTagType)entry[1];
+        slots[i].lf_tag_type = (ChameleonTagType)entry[2];
+        slots[i].hf_enabled = entry[3] != 0;
+        slots[i].lf_enabled = entry[4] != 0;
+
+        // Copy nickname (ensure null termination)
+        memcpy(slots[i].nickname, &entry[5], CHAMELEON_SLOT_NICK_LEN);
+        slots[i].nickname[CHAMELEON_SLOT_NICK_LEN] = '\0';
+
+        FURI_LOG_D(TAG, "Slot %d: HF=%d LF=%d Nick='%s'",
+            i,
+            slots[i].hf_tag_type,
+            slots[i].lf_tag_type,
+            slots[i].nickname);
+    }
+
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    memcpy(app->slots, slots, sizeof(app->slots));
+    furi_mutex_release(app->device_mutex);
+
     FURI_LOG_I(TAG, "Slots info retrieved");
     return true;
 }
 
-bool chameleon_app_set_active_slot(ChameleonApp* app, uint8_t slot) {
+bool chameleon_app_get_slots_info_async(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context) {
     furi_assert(app);
-    furi_assert(slot < 8);
+    furi_assert(callback);
 
-    FURI_LOG_I(TAG, "Setting active slot to %d", slot);
+    FURI_LOG_I(TAG, "Getting slots info");
 
-    // Build SET_ACTIVE_SLOT command
-    uint8_t cmd_buffer[CHAMELEON_FRAME_OVERHEAD + 1];
-    size_t cmd_len;
+    ChameleonAppOperation* operation =
+        chameleon_app_operation_alloc(app, chameleon_app_slots_info_handler, callback, context);
 
-    if(!chameleon_protocol_build_cmd_with_data(app->protocol, CMD_SET_ACTIVE_SLOT, &slot, 1, cmd_buffer, &cmd_len)) {
-        FURI_LOG_E(TAG, "Failed to build SET_ACTIVE_SLOT command");
-        return false;
-    }
+    return chameleon_app_operation_submit(operation, CMD_GET_SLOT_INFO, NULL, 0);
+}
 
-    // Send command
-    if(app->connection_type == ChameleonConnectionUSB) {
-        uart_handler_send(app->uart_handler, cmd_buffer, cmd_len);
-    } else if(app->connection_type == ChameleonConnectionBLE) {
-        ble_handler_send(app->ble_handler, cmd_buffer, cmd_len);
-    } else {
-        FURI_LOG_E(TAG, "Not connected");
-        return false;
-    }
+static bool chameleon_app_active_slot_handler(
+    ChameleonAppOperation* operation,
+    const ChameleonFrameView* response) {
+    UNUSED(response);
 
-    app->active_slot = slot;
+    chameleon_app_select_slot(operation->app, operation->slot);
 
-    FURI_LOG_I(TAG, "Active slot set to %d", slot);
+    FURI_LOG_I(TAG, "Active slot set to %d", operation->slot);
     return true;
 }
 
-bool chameleon_app_set_slot_nickname(ChameleonApp* app, uint8_t slot, const char* nickname) {
+bool chameleon_app_set_active_slot_async(
+    ChameleonApp* app,
+    uint8_t slot,
+    ChameleonAppCallback callback,
+    void* context) {
     furi_assert(app);
     furi_assert(slot < 8);
-    furi_assert(nickname);
+    furi_assert(callback);
 
-    FURI_LOG_I(TAG, "Setting slot %d nickname to: %s", slot, nickname);
+    FURI_LOG_I(TAG, "Setting active slot to %d", slot);
 
-    // Build SET_SLOT_TAG_NICK command
-    uint8_t data[33];
-    data[0] = slot;
-    size_t nick_len = strlen(nickname);
-    if(nick_len > 32) nick_len = 32;
-    memcpy(&data[1], nickname, nick_len);
+    ChameleonAppOperation* operation =
+        chameleon_app_operation_alloc(app, chameleon_app_active_slot_handler, callback, context);
+    operation->slot = slot;
 
-    uint8_t cmd_buffer[CHAMELEON_FRAME_OVERHEAD + 33];
-    size_t cmd_len;
+    // Send SET_ACTIVE_SLOT command
+    return chameleon_app_operation_submit(operation, CMD_SET_ACTIVE_SLOT, &slot, 1);
+}
 
-    if(!chameleon_protocol_build_cmd_with_data(
-           app->protocol, CMD_SET_SLOT_TAG_NICK, data, 1 + nick_len, cmd_buffer, &cmd_len)) {
-        FURI_LOG_E(TAG, "Failed to build SET_SLOT_TAG_NICK command");
-        return false;
-    }
-
-    // Send command
-    if(app->connection_type == ChameleonConnectionUSB) {
-        uart_handler_send(app->uart_handler, cmd_buffer, cmd_len);
-    } else if(app->connection_type == ChameleonConnectionBLE) {
-        ble_handler_send(app->ble_handler, cmd_buffer, cmd_len);
-    } else {
-        FURI_LOG_E(TAG, "Not connected");
-        return false;
-    }
+static bool chameleon_app_slot_nickname_handler(
+    ChameleonAppOperation* operation,
+    const ChameleonFrameView* response) {
+    UNUSED(response);
 
     // Update local cache
-    strncpy(app->slots[slot].nickname, nickname, sizeof(app->slots[slot].nickname) - 1);
+    ChameleonApp* app = operation->app;
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    ChameleonSlot* slot = &app->slots[operation->slot];
+    memcpy(slot->nickname, operation->nickname, sizeof(slot->nickname));
+    furi_mutex_release(app->device_mutex);
 
     FURI_LOG_I(TAG, "Slot nickname updated");
     return true;
 }
 
-bool chameleon_app_change_device_mode(ChameleonApp* app, ChameleonDeviceMode mode) {
+bool chameleon_app_set_slot_nickname_async(
+    ChameleonApp* app,
+    uint8_t slot,
+    const char* nickname,
+    ChameleonAppCallback callback,
+    void* context) {
     furi_assert(app);
+    furi_assert(slot < 8);
+    furi_assert(nickname);
+    furi_assert(callback);
 
-    FURI_LOG_I(TAG, "Changing device mode to %d", mode);
+    FURI_LOG_I(TAG, "Setting slot %d nickname to: %s", slot, nickname);
 
-    uint8_t mode_byte = (uint8_t)mode;
+    ChameleonAppOperation* operation =
+        chameleon_app_operation_alloc(app, chameleon_app_slot_nickname_handler, callback, context);
+    operation->slot = slot;
+    strncpy(operation->nickname, nickname, sizeof(operation->nickname) - 1);
 
-    uint8_t cmd_buffer[CHAMELEON_FRAME_OVERHEAD + 1];
-    size_t cmd_len;
+    // Build SET_SLOT_TAG_NICK command
+    uint8_t data[1 + CHAMELEON_SLOT_NICK_LEN];
+    data[0] = slot;
+    size_t nick_len = strlen(operation->nickname);
+    memcpy(&data[1], operation->nickname, nick_len);
 
-    if(!chameleon_protocol_build_cmd_with_data(
-           app->protocol, CMD_CHANGE_DEVICE_MODE, &mode_byte, 1, cmd_buffer, &cmd_len)) {
-        FURI_LOG_E(TAG, "Failed to build CHANGE_DEVICE_MODE command");
-        return false;
-    }
+    return chameleon_app_operation_submit(operation, CMD_SET_SLOT_TAG_NICK, data, 1 + nick_len);
+}
 
-    // Send command
-    if(app->connection_type == ChameleonConnectionUSB) {
-        uart_handler_send(app->uart_handler, cmd_buffer, cmd_len);
-    } else if(app->connection_type == ChameleonConnectionBLE) {
-        ble_handler_send(app->ble_handler, cmd_buffer, cmd_len);
-    } else {
-        FURI_LOG_E(TAG, "Not connected");
-        return false;
-    }
+static bool chameleon_app_device_mode_handler(
+    ChameleonAppOperation* operation,
+    const ChameleonFrameView* response) {
+    UNUSED(response);
+    ChameleonApp* app = operation->app;
 
-    app->device_info.mode = mode;
+    // Mode affects other device state, refetch on next use
+    furi_mutex_acquire(app->device_mutex, FuriWaitForever);
+    app->device_info.valid = false;
+    app->device_info.mode = operation->mode;
+    furi_mutex_release(app->device_mutex);
 
     FURI_LOG_I(TAG, "Device mode changed");
     return true;
 }
 
+bool chameleon_app_change_device_mode_async(
+    ChameleonApp* app,
+    ChameleonDeviceMode mode,
+    ChameleonAppCallback callback,
+    void* context) {
+    furi_assert(app);
+    furi_assert(callback);
+
+    FURI_LOG_I(TAG, "Changing device mode to %d", mode);
+
+    ChameleonAppOperation* operation =
+        chameleon_app_operation_alloc(app, chameleon_app_device_mode_handler, callback, context);
+    operation->mode = mode;
+
+    // Device expects true for reader mode
+    uint8_t mode_byte = mode == ChameleonModeReader ? 1 : 0;
+
+    return chameleon_app_operation_submit(operation, CMD_CHANGE_DEVICE_MODE, &mode_byte, 1);
+}
+
 int32_t chameleon_ultra_app(void* p) {
     UNUSED(p);
 
@@ -535,3 +984,11 @@ int32_t chameleon_ultra_app(void* p) {
 #include "lib/ble_handler/ble_handler.c"
 #undef TAG
 #include "lib/chameleon_protocol/chameleon_protocol.c"
+#undef TAG
+#include "lib/chameleon_transport/chameleon_transport.c"
+#undef TAG
+#include "lib/chameleon_transport/chameleon_rx_queue.c"
+#undef TAG
+#include "lib/chameleon_engine/chameleon_engine.c"
+#undef TAG
+#include "lib/chameleon_bench/chameleon_bench.c"
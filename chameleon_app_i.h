@@ -16,6 +16,8 @@
 
 #include "scenes/chameleon_scene.h"
 #include "lib/chameleon_protocol/chameleon_protocol.h"
+#include "lib/chameleon_engine/chameleon_engine.h"
+#include "lib/chameleon_bench/chameleon_bench.h"
 #include "lib/uart_handler/uart_handler.h"
 #include "lib/ble_handler/ble_handler.h"
 #include "views/chameleon_animation_view.h"
@@ -69,7 +71,7 @@ typedef struct {
     ChameleonTagType lf_tag_type;
     bool hf_enabled;
     bool lf_enabled;
-    char nickname[33]; // 32 bytes + null terminator
+    char nickname[CHAMELEON_SLOT_NICK_LEN + 1]; // 32 bytes + null terminator
 } ChameleonSlot;
 
 // Device information
@@ -81,8 +83,19 @@ typedef struct {
     ChameleonModel model;
     ChameleonDeviceMode mode;
     bool connected;
+    bool valid; // Cached for the session, cleared on (re)connect and mode change
 } ChameleonDeviceInfo;
 
+// Custom events shared by scenes, kept clear of scene-local event values
+typedef enum {
+    ChameleonCustomEventOperationSuccess = 0x10000, // Asynchronous operation completed
+    ChameleonCustomEventOperationFailure,
+    ChameleonCustomEventPopupDone, // Popup timeout expired
+    ChameleonCustomEventBleDevicesChanged, // BLE scan found a device or reordered them
+    ChameleonCustomEventCapabilitiesChanged, // Device reported its command set
+    ChameleonCustomEventBleLinkLost, // BLE link dropped, handled by the app first
+} ChameleonCustomEvent;
+
 // Views
 typedef enum {
     ChameleonViewSubmenu,
@@ -94,6 +107,11 @@ typedef enum {
     ChameleonViewAnimation,
 } ChameleonView;
 
+// Completion callback of asynchronous device operations. Runs on the receive,
+// engine or BLE connect thread, or before the call returns when no round trip
+// is needed.
+typedef void (*ChameleonAppCallback)(bool success, void* context);
+
 // Main application structure
 typedef struct {
     Gui* gui;
@@ -117,43 +135,111 @@ typedef struct {
     ChameleonStatus connection_status;
     UartHandler* uart_handler;
     BleHandler* ble_handler;
+    ChameleonTransport transport; // Bound to the handler of the active connection
+    FuriThread* ble_worker; // Connects BLE off the GUI thread, joined before reuse
+    bool ble_reconnect; // To ble_peer rather than to ble_device_id
+    size_t ble_device_id;
+    BleHandlerPeer ble_peer;
+    ChameleonAppCallback ble_callback;
+    void* ble_context;
 
     // Device data
+    FuriMutex* device_mutex; // Guards the device data below, published on the RX thread
     ChameleonDeviceInfo device_info;
-    ChameleonSlot slots[8]; // 8 slots (0-7)
+    ChameleonSlot slots[CHAMELEON_SLOT_COUNT]; // 8 slots (0-7)
     uint8_t active_slot;
 
     // Temporary buffers
     char text_buffer[64];
-    uint8_t data_buffer[512];
-
-    // Protocol handler
-    ChameleonProtocol* protocol;
-
-    // Response handling
-    FuriMutex* response_mutex;
-    uint8_t response_buffer[CHAMELEON_MAX_DATA_LEN + CHAMELEON_FRAME_OVERHEAD];
-    size_t response_length;
-    uint16_t response_cmd;
-    uint16_t response_status;
-    bool response_ready;
+
+    // Request engine, matches responses to pending requests
+    ChameleonEngine* engine;
+
+    // Link benchmark, alive while its scene is shown. Each case runs with one
+    // request in flight and with a full window.
+    ChameleonBench* bench;
+    ChameleonBenchResult bench_results[ChameleonBenchCaseNum * 2];
 } ChameleonApp;
 
 // Application lifecycle
 ChameleonApp* chameleon_app_alloc();
 void chameleon_app_free(ChameleonApp* app);
 
-// RX callback for UART/BLE (used by connection scenes)
-void chameleon_app_rx_callback(const uint8_t* data, size_t length, void* context);
+// Bind a connected handler to the request engine and start the device
+// session (used by connection scenes)
+void chameleon_app_attach_transport(ChameleonApp* app, ChameleonConnectionType type);
 
 // Connection management
 bool chameleon_app_connect_usb(ChameleonApp* app);
 bool chameleon_app_connect_ble(ChameleonApp* app);
+// Connect to a device listed by the scan on a worker thread, attaching the
+// transport on success. The callback runs on the worker once it is done.
+void chameleon_app_connect_ble_device_async(
+    ChameleonApp* app,
+    size_t device_id,
+    ChameleonAppCallback callback,
+    void* context);
+// Reconnect to the last BLE device the same way but without scanning, false
+// without calling the callback when no device was saved
+bool chameleon_app_reconnect_ble_async(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context);
+// Wait for a connect started above, done before leaving its scene
+void chameleon_app_ble_connect_wait(ChameleonApp* app);
 void chameleon_app_disconnect(ChameleonApp* app);
 
-// Device operations
-bool chameleon_app_get_device_info(ChameleonApp* app);
-bool chameleon_app_get_slots_info(ChameleonApp* app);
-bool chameleon_app_set_active_slot(ChameleonApp* app, uint8_t slot);
-bool chameleon_app_set_slot_nickname(ChameleonApp* app, uint8_t slot, const char* nickname);
-bool chameleon_app_change_device_mode(ChameleonApp* app, ChameleonDeviceMode mode);
+// Start a fresh device session: drop partial frames and cached device data
+void chameleon_app_session_reset(ChameleonApp* app);
+
+// Device capabilities, fetched once per connection in the background
+bool chameleon_app_fetch_capabilities(ChameleonApp* app);
+bool chameleon_app_supports(ChameleonApp* app, uint16_t cmd);
+
+// Completion callback reporting to the current scene as
+// ChameleonCustomEventOperationSuccess/Failure, context is the app
+void chameleon_app_operation_event_callback(bool success, void* context);
+
+// Show popup, ChameleonCustomEventPopupDone is sent once timeout_ms expires
+void chameleon_app_show_popup(
+    ChameleonApp* app,
+    const char* header,
+    const char* text,
+    uint32_t timeout_ms);
+
+// Copy the cached device info, valid is false until it has been fetched
+void chameleon_app_copy_device_info(ChameleonApp* app, ChameleonDeviceInfo* info);
+
+// Copy a cached slot, filled in by chameleon_app_get_slots_info_async
+void chameleon_app_copy_slot(ChameleonApp* app, uint8_t index, ChameleonSlot* slot);
+
+// Slot the slot scenes work on, also set once the device activated one
+uint8_t chameleon_app_get_active_slot(ChameleonApp* app);
+void chameleon_app_select_slot(ChameleonApp* app, uint8_t slot);
+
+// Device operations, return false without calling the callback if the
+// command could not be sent
+bool chameleon_app_get_device_info_async(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context);
+bool chameleon_app_get_slots_info_async(
+    ChameleonApp* app,
+    ChameleonAppCallback callback,
+    void* context);
+bool chameleon_app_set_active_slot_async(
+    ChameleonApp* app,
+    uint8_t slot,
+    ChameleonAppCallback callback,
+    void* context);
+bool chameleon_app_set_slot_nickname_async(
+    ChameleonApp* app,
+    uint8_t slot,
+    const char* nickname,
+    ChameleonAppCallback callback,
+    void* context);
+bool chameleon_app_change_device_mode_async(
+    ChameleonApp* app,
+    ChameleonDeviceMode mode,
+    ChameleonAppCallback callback,
+    void* context);
@@ -0,0 +1,256 @@
+#include "chameleon_engine.h"
+#include "chameleon_sim.h"
+#include "loopback_handler.h"
+#include <furi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_TIME_NS 200000000ULL // Run each case for at least 200 ms
+#define BENCH_LATENCY_SAMPLES 50
+#define BENCH_BULK_DEPTH 12 // Bulk requests kept queued by the load generator
+
+typedef struct {
+    ChameleonEngine* engine;
+    volatile bool running;
+    volatile uint32_t completed;
+    bool bulk; // Submit load as bulk instead of interactive
+} BenchLoad;
+
+typedef struct {
+    LoopbackHandler* loopback;
+    volatile uint32_t drop; // Responses to lose before delivering again
+} BenchDevice;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Client bytes go to the simulator, its responses come back as received data
+static void bench_device_rx_callback(const uint8_t* data, size_t length, void* context) {
+    chameleon_sim_feed(context, data, length);
+}
+
+static void bench_device_output_callback(const uint8_t* data, size_t length, void* context) {
+    BenchDevice* device = context;
+
+    // The simulator outputs whole frames on an ideal link
+    if(device->drop) {
+        device->drop--;
+        return;
+    }
+    loopback_handler_inject(device->loopback, data, length);
+}
+
+static void bench_report(const char* name, uint64_t iterations, uint64_t elapsed_ns) {
+    double seconds = (double)elapsed_ns / 1e9;
+    printf(
+        "%-28s %10.0f req/s %10.1f us/req\n",
+        name,
+        (double)iterations / seconds,
+        (double)elapsed_ns / 1e3 / (double)iterations);
+}
+
+static void bench_request(ChameleonEngine* engine) {
+    ChameleonFrameView response;
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    do {
+        if(!chameleon_engine_request(engine, CMD_GET_APP_VERSION, NULL, 0, &response)) {
+            fprintf(stderr, "request failed\n");
+            exit(1);
+        }
+        chameleon_engine_release(engine, &response);
+        iterations++;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    bench_report("request (blocking)", iterations, elapsed);
+}
+
+static void bench_count_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    UNUSED(response);
+    volatile uint32_t* completed = context;
+
+    if(result != ChameleonEngineResultOk) {
+        fprintf(stderr, "pipelined request failed: %d\n", result);
+        exit(1);
+    }
+    (*completed)++;
+}
+
+static void bench_submit_pipelined(ChameleonEngine* engine) {
+    volatile uint32_t completed = 0;
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    // Fill the request table, the engine keeps the window full from it
+    do {
+        for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+            if(!chameleon_engine_submit(
+                   engine, CMD_GET_APP_VERSION, NULL, 0, bench_count_callback, (void*)&completed)) {
+                fprintf(stderr, "submit failed\n");
+                exit(1);
+            }
+        }
+        chameleon_engine_wait_idle(engine, FuriWaitForever);
+        iterations += CHAMELEON_ENGINE_MAX_REQUESTS;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    if(completed != iterations) {
+        fprintf(stderr, "lost completions: %u of %llu\n", completed, (unsigned long long)iterations);
+        exit(1);
+    }
+
+    bench_report("submit (pipelined)", iterations, elapsed);
+}
+
+static bool bench_load_submit(BenchLoad* load);
+
+static void bench_load_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    UNUSED(result);
+    UNUSED(response);
+    BenchLoad* load = context;
+
+    load->completed++;
+    if(load->running) {
+        bench_load_submit(load);
+    }
+}
+
+static bool bench_load_submit(BenchLoad* load) {
+    if(load->bulk) {
+        return chameleon_engine_submit_bulk(
+            load->engine, CMD_GET_DEVICE_MODE, NULL, 0, bench_load_callback, load);
+    }
+
+    return chameleon_engine_submit(
+        load->engine, CMD_GET_DEVICE_MODE, NULL, 0, bench_load_callback, load);
+}
+
+// Latency of blocking requests while a load generator keeps the queue full
+static void bench_latency_under_load(ChameleonEngine* engine, ChameleonSim* sim, bool bulk) {
+    BenchLoad load = {
+        .engine = engine,
+        .running = true,
+        .bulk = bulk,
+    };
+
+    ChameleonSimLink link = {.service_us = 500};
+    chameleon_sim_set_link(sim, &link);
+
+    for(size_t i = 0; i < BENCH_BULK_DEPTH; i++) {
+        bench_load_submit(&load);
+    }
+
+    uint64_t total = 0;
+    uint64_t worst = 0;
+    for(size_t i = 0; i < BENCH_LATENCY_SAMPLES; i++) {
+        ChameleonFrameView response;
+        uint64_t start = bench_now_ns();
+
+        if(!chameleon_engine_request(engine, CMD_GET_APP_VERSION, NULL, 0, &response)) {
+            fprintf(stderr, "request under load failed\n");
+            exit(1);
+        }
+        chameleon_engine_release(engine, &response);
+
+        uint64_t latency = bench_now_ns() - start;
+        total += latency;
+        worst = MAX(worst, latency);
+    }
+
+    load.running = false;
+    chameleon_engine_wait_idle(engine, FuriWaitForever);
+    chameleon_sim_set_link(sim, &(ChameleonSimLink){0});
+
+    printf(
+        "%-28s %10.1f us avg %8.1f us max %6u load done\n",
+        bulk ? "latency, bulk load" : "latency, interactive load",
+        (double)total / 1e3 / BENCH_LATENCY_SAMPLES,
+        (double)worst / 1e3,
+        load.completed);
+}
+
+// A lost response holds back the next request with its CMD until the copy
+// counts as lost, rather than completing it and failing the one after
+static void bench_lost_response(ChameleonEngine* engine, BenchDevice* device) {
+    ChameleonFrameView response;
+    ChameleonEngineStats before;
+    ChameleonEngineStats after;
+
+    device->drop = 1;
+    if(!chameleon_engine_request(engine, CMD_GET_APP_VERSION, NULL, 0, &response)) {
+        fprintf(stderr, "request with lost response failed\n");
+        exit(1);
+    }
+    chameleon_engine_release(engine, &response);
+
+    chameleon_engine_get_stats(engine, &before);
+    uint64_t start = bench_now_ns();
+    if(!chameleon_engine_request(engine, CMD_GET_APP_VERSION, NULL, 0, &response)) {
+        fprintf(stderr, "request after lost response failed\n");
+        exit(1);
+    }
+    chameleon_engine_release(engine, &response);
+    uint64_t elapsed = bench_now_ns() - start;
+    chameleon_engine_get_stats(engine, &after);
+
+    if(after.retransmits != before.retransmits) {
+        fprintf(stderr, "request after lost response was retransmitted\n");
+        exit(1);
+    }
+
+    printf("%-28s %10.1f ms next request\n", "lost response", (double)elapsed / 1e6);
+}
+
+int main(void) {
+    LoopbackHandler* loopback = loopback_handler_alloc();
+    BenchDevice device = {.loopback = loopback};
+    ChameleonSim* sim = chameleon_sim_alloc();
+    chameleon_sim_set_output_callback(sim, bench_device_output_callback, &device);
+    loopback_handler_set_device_callback(loopback, bench_device_rx_callback, sim);
+
+    ChameleonTransport transport;
+    chameleon_transport_init(&transport, &loopback_handler_transport, loopback);
+
+    ChameleonEngine* engine = chameleon_engine_alloc();
+    chameleon_engine_set_transport(engine, &transport);
+    chameleon_transport_start_rx(&transport);
+
+    bench_request(engine);
+    bench_submit_pipelined(engine);
+    bench_latency_under_load(engine, sim, false);
+    bench_latency_under_load(engine, sim, true);
+    bench_lost_response(engine, &device);
+
+    ChameleonEngineStats stats;
+    chameleon_engine_get_stats(engine, &stats);
+    if(stats.timeouts || stats.unexpected) {
+        fprintf(stderr, "timeouts %u, unexpected %u\n", stats.timeouts, stats.unexpected);
+        return 1;
+    }
+
+    // The simulator delivers from its own thread, stop it before the engine goes
+    chameleon_transport_stop_rx(&transport);
+    chameleon_sim_free(sim);
+    chameleon_engine_set_transport(engine, NULL);
+    chameleon_engine_free(engine);
+    loopback_handler_free(loopback);
+
+    return 0;
+}
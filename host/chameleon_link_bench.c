@@ -0,0 +1,364 @@
+// End to end link benchmark
+//
+// Runs the benchmark cases of the app's Link Benchmark scene on the host,
+// against the simulator behind links shaped like USB and BLE, or against a
+// real device or chameleon_simd over a serial port. The BLE GATT runs go
+// through ble_handler to a simulated peripheral and report how many packets
+// and notifications frames took, how long connection parameter profile
+// switches take, what each profile does to the round trip and how much a
+// reconnect to the remembered device saves over a scan. Each case runs
+// once with a single request in flight (round trip) and once with a full
+// window (throughput).
+
+#include "chameleon_bench.h"
+#include "chameleon_engine.h"
+#include "chameleon_sim.h"
+#include "chameleon_sim_gatt.h"
+#include "ble_handler.h"
+#include "loopback_handler.h"
+#include "serial_handler.h"
+#include <furi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define LINK_BENCH_DEFAULT_ITERATIONS 100
+
+// Round trips timed per link profile
+#define LINK_BENCH_PROFILE_ITERATIONS 20
+
+#define LINK_BENCH_PROFILE_TIMEOUT_MS 5000
+
+typedef struct {
+    const char* name;
+    ChameleonEngineLink link;
+    ChameleonSimLink sim_link;
+} LinkBenchPreset;
+
+// Responses are delayed per frame, link bandwidth is not modelled. USB polls
+// the CDC endpoint once per 1 ms frame, BLE answers on a connection event
+// every 15 to 30 ms in notifications of 20 bytes at the default ATT MTU.
+static const LinkBenchPreset link_bench_presets[] = {
+    {"Loopback", ChameleonEngineLinkUsb, {0}},
+    {"USB (simulated)", ChameleonEngineLinkUsb, {.service_us = 100, .latency_us = 1000}},
+    {"BLE (simulated)",
+     ChameleonEngineLinkBle,
+     {.service_us = 100, .latency_us = 15000, .jitter_us = 15000, .fragment_max = 20}},
+};
+
+// Shortest connection interval, at the default and the largest MTU
+static const uint16_t link_bench_gatt_mtus[] = {
+    BLE_HANDLER_ATT_MTU_DEFAULT,
+    BLE_HANDLER_ATT_MTU_MAX,
+};
+static const ChameleonSimLink link_bench_gatt_link = {.service_us = 100, .latency_us = 7500};
+
+static void link_bench_device_rx_callback(const uint8_t* data, size_t length, void* context) {
+    chameleon_sim_feed(context, data, length);
+}
+
+static void link_bench_device_output_callback(const uint8_t* data, size_t length, void* context) {
+    loopback_handler_inject(context, data, length);
+}
+
+static void link_bench_done_callback(bool success, void* context) {
+    UNUSED(success);
+    furi_semaphore_release(context);
+}
+
+// Same mapping as the app
+static void link_bench_activity_callback(ChameleonEngineActivity activity, void* context) {
+    static const BleHandlerProfile profiles[ChameleonEngineActivityNum] = {
+        [ChameleonEngineActivityIdle] = BleHandlerProfileIdle,
+        [ChameleonEngineActivityInteractive] = BleHandlerProfileInteractive,
+        [ChameleonEngineActivityBulk] = BleHandlerProfileBulk,
+    };
+    ble_handler_set_profile(context, profiles[activity]);
+}
+
+static bool link_bench_wait_profile(BleHandler* ble, BleHandlerProfile profile) {
+    for(uint32_t waited = 0; waited < LINK_BENCH_PROFILE_TIMEOUT_MS; waited += 5) {
+        if(ble_handler_get_profile(ble) == profile) return true;
+        furi_delay_ms(5);
+    }
+    return false;
+}
+
+// Time to the first response, what the user waits for after picking BLE
+static bool link_bench_first_command(ChameleonEngine* engine) {
+    ChameleonFrameView response;
+    if(!chameleon_engine_request(engine, CMD_GET_APP_VERSION, NULL, 0, &response)) {
+        return false;
+    }
+    chameleon_engine_release(engine, &response);
+    return true;
+}
+
+static void link_bench_run(ChameleonEngine* engine, const char* name, uint32_t iterations) {
+    ChameleonBench* bench = chameleon_bench_alloc(engine);
+    FuriSemaphore* done = furi_semaphore_alloc(1, 0);
+    const uint8_t depths[] = {1, CHAMELEON_ENGINE_WINDOW};
+
+    printf("%s\n", name);
+    printf(
+        "%-10s %5s %5s %5s %8s %8s %8s %8s %8s %8s %9s\n",
+        "case",
+        "depth",
+        "ok",
+        "err",
+        "min us",
+        "avg us",
+        "p50 us",
+        "p99 us",
+        "max us",
+        "req/s",
+        "B/s");
+
+    for(size_t i = 0; i < ChameleonBenchCaseNum; i++) {
+        for(size_t j = 0; j < COUNT_OF(depths); j++) {
+            if(!chameleon_bench_start(
+                   bench, i, iterations, depths[j], link_bench_done_callback, done)) {
+                printf("%-10s %5u not supported\n", chameleon_bench_case_name(i), depths[j]);
+                continue;
+            }
+            furi_semaphore_acquire(done, FuriWaitForever);
+
+            ChameleonBenchResult result;
+            chameleon_bench_get_result(bench, &result);
+            printf(
+                "%-10s %5u %5u %5u %8u %8u %8u %8u %8u %8u %9u\n",
+                chameleon_bench_case_name(i),
+                depths[j],
+                result.requests,
+                result.errors,
+                result.min_us,
+                result.avg_us,
+                result.p50_us,
+                result.p99_us,
+                result.max_us,
+                result.requests_per_s,
+                result.bytes_per_s);
+        }
+    }
+    printf("\n");
+
+    chameleon_bench_free(bench);
+    furi_semaphore_free(done);
+}
+
+static void link_bench_simulated(const LinkBenchPreset* preset, uint32_t iterations) {
+    LoopbackHandler* loopback = loopback_handler_alloc();
+    ChameleonSim* sim = chameleon_sim_alloc();
+    chameleon_sim_set_output_callback(sim, link_bench_device_output_callback, loopback);
+    chameleon_sim_set_link(sim, &preset->sim_link);
+    loopback_handler_set_device_callback(loopback, link_bench_device_rx_callback, sim);
+
+    ChameleonTransport transport;
+    chameleon_transport_init(&transport, &loopback_handler_transport, loopback);
+
+    ChameleonEngine* engine = chameleon_engine_alloc();
+    chameleon_engine_set_link(engine, preset->link);
+    chameleon_engine_set_transport(engine, &transport);
+    chameleon_transport_start_rx(&transport);
+
+    link_bench_run(engine, preset->name, iterations);
+
+    // The simulator delivers from its own thread, stop it before the engine goes
+    chameleon_transport_stop_rx(&transport);
+    chameleon_sim_free(sim);
+    chameleon_engine_set_transport(engine, NULL);
+    chameleon_engine_free(engine);
+    loopback_handler_free(loopback);
+}
+
+static void link_bench_gatt(uint16_t att_mtu, uint32_t iterations) {
+    ChameleonSim* sim = chameleon_sim_alloc();
+    chameleon_sim_set_link(sim, &link_bench_gatt_link);
+    ChameleonSimGatt* gatt = chameleon_sim_gatt_alloc(sim, att_mtu);
+
+    BleHandler* ble = ble_handler_alloc();
+    ble_handler_set_backend(ble, &chameleon_sim_gatt_backend, gatt);
+    uint32_t cold_start = furi_get_tick();
+    BleHandlerDevice device;
+    if(!ble_handler_init(ble) || !ble_handler_start_scan(ble) ||
+       !ble_handler_get_device(ble, 0, &device) || !ble_handler_connect(ble, device.id)) {
+        fprintf(stderr, "GATT connection failed\n");
+        exit(1);
+    }
+
+    ChameleonTransport transport;
+    chameleon_transport_init(&transport, &ble_handler_transport, ble);
+
+    ChameleonEngine* engine = chameleon_engine_alloc();
+    chameleon_engine_set_link(engine, ChameleonEngineLinkBle);
+    chameleon_engine_set_transport(engine, &transport);
+    chameleon_transport_start_rx(&transport);
+    bool cold_ok = link_bench_first_command(engine);
+    uint32_t cold_ms = furi_get_tick() - cold_start;
+
+    printf("BLE GATT link profiles (simulated, ATT MTU %u)\n", ble_handler_get_att_mtu(ble));
+    printf("%-12s %9s %11s\n", "profile", "switch ms", "ping p50 us");
+
+    // Profiles are switched by hand here, from the engine's activity below
+    ChameleonBench* bench = chameleon_bench_alloc(engine);
+    FuriSemaphore* done = furi_semaphore_alloc(1, 0);
+    const BleHandlerProfile profiles[] = {
+        BleHandlerProfileBulk, BleHandlerProfileIdle, BleHandlerProfileInteractive};
+    link_bench_wait_profile(ble, BleHandlerProfileInteractive);
+
+    for(size_t i = 0; i < COUNT_OF(profiles); i++) {
+        ble_handler_set_profile(ble, profiles[i]);
+        if(!link_bench_wait_profile(ble, profiles[i])) {
+            printf("%-12s %9s\n", ble_handler_profile_name(profiles[i]), "failed");
+            continue;
+        }
+
+        BleHandlerStats stats;
+        ble_handler_get_stats(ble, &stats);
+        ChameleonBenchResult result = {0};
+        if(chameleon_bench_start(
+               bench,
+               ChameleonBenchCasePing,
+               LINK_BENCH_PROFILE_ITERATIONS,
+               1,
+               link_bench_done_callback,
+               done)) {
+            furi_semaphore_acquire(done, FuriWaitForever);
+            chameleon_bench_get_result(bench, &result);
+        }
+
+        printf(
+            "%-12s %9u %11u\n",
+            ble_handler_profile_name(profiles[i]),
+            stats.conn_update_last_ms,
+            result.p50_us);
+    }
+    printf("\n");
+
+    chameleon_bench_free(bench);
+    furi_semaphore_free(done);
+
+    BleHandlerStats before;
+    ble_handler_get_stats(ble, &before);
+    chameleon_engine_set_activity_callback(engine, link_bench_activity_callback, ble);
+
+    char name[64];
+    snprintf(name, sizeof(name), "BLE GATT (simulated, ATT MTU %u)", ble_handler_get_att_mtu(ble));
+    link_bench_run(engine, name, iterations);
+
+    // The bulk job of the last case lingers, wait for its switch back
+    link_bench_wait_profile(ble, BleHandlerProfileInteractive);
+    chameleon_engine_set_activity_callback(engine, NULL, NULL);
+
+    BleHandlerStats stats;
+    ble_handler_get_stats(ble, &stats);
+    ChameleonSimGattStats gatt_stats;
+    chameleon_sim_gatt_get_stats(gatt, &gatt_stats);
+    printf(
+        "Sent %u frames in %u packets, %u rejected writes\n"
+        "Received %u frames from %u notifications, %u dropped\n",
+        stats.tx_frames,
+        stats.tx_packets,
+        gatt_stats.rejected,
+        stats.rx_frames,
+        stats.rx_notifications,
+        stats.rx_errors);
+
+    uint32_t switches = stats.conn_updates - before.conn_updates;
+    printf(
+        "%u automatic profile switches, %u ms on average\n\n",
+        switches,
+        switches ? (stats.conn_update_total_ms - before.conn_update_total_ms) / switches : 0);
+
+    // Reconnect with the handles cached at the first connection, as the app
+    // does with the device it saved
+    BleHandlerPeer peer;
+    ble_handler_get_peer(ble, &peer);
+    ble_handler_disconnect(ble);
+    uint32_t cached_start = furi_get_tick();
+    bool cached_ok = ble_handler_connect_peer(ble, &peer) && link_bench_first_command(engine);
+    uint32_t cached_ms = furi_get_tick() - cached_start;
+
+    printf("Time to first command: ");
+    if(cold_ok) {
+        printf("%u ms with a scan, ", cold_ms);
+    } else {
+        printf("failed with a scan, ");
+    }
+    if(cached_ok) {
+        printf("%u ms reconnecting\n\n", cached_ms);
+    } else {
+        printf("failed reconnecting\n\n");
+    }
+
+    // Disconnecting stops writes reaching the simulator, its delivery thread
+    // may still notify until it is freed
+    chameleon_engine_set_transport(engine, NULL);
+    ble_handler_free(ble);
+    chameleon_sim_free(sim);
+    chameleon_sim_gatt_free(gatt);
+    chameleon_engine_free(engine);
+}
+
+static bool link_bench_serial(const char* path, uint32_t iterations) {
+    SerialHandler* serial = serial_handler_alloc();
+    if(!serial_handler_open(serial, path)) {
+        serial_handler_free(serial);
+        return false;
+    }
+
+    ChameleonTransport transport;
+    chameleon_transport_init(&transport, &serial_handler_transport, serial);
+
+    ChameleonEngine* engine = chameleon_engine_alloc();
+    chameleon_engine_set_link(engine, ChameleonEngineLinkUsb);
+    chameleon_engine_set_transport(engine, &transport);
+    chameleon_transport_start_rx(&transport);
+
+    char name[128];
+    snprintf(name, sizeof(name), "%s (%s)", transport.interface->name, path);
+    link_bench_run(engine, name, iterations);
+
+    chameleon_transport_stop_rx(&transport);
+    chameleon_engine_set_transport(engine, NULL);
+    chameleon_engine_free(engine);
+    serial_handler_free(serial);
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = LINK_BENCH_DEFAULT_ITERATIONS;
+    int option;
+
+    while((option = getopt(argc, argv, "n:h")) != -1) {
+        switch(option) {
+        case 'n':
+            iterations = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n iterations] [device]\n", argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+
+    if(argc - optind > 1) {
+        fprintf(stderr, "usage: %s [-n iterations] [device]\n", argv[0]);
+        return 2;
+    }
+
+    if(optind < argc) {
+        return link_bench_serial(argv[optind], iterations) ? 0 : 1;
+    }
+
+    for(size_t i = 0; i < COUNT_OF(link_bench_presets); i++) {
+        link_bench_simulated(&link_bench_presets[i], iterations);
+    }
+
+    for(size_t i = 0; i < COUNT_OF(link_bench_gatt_mtus); i++) {
+        link_bench_gatt(link_bench_gatt_mtus[i], iterations);
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+// Query a Chameleon over a serial port from Linux
+//
+// Runs the request engine over the serial transport against a real device
+// (/dev/ttyACM*) or chameleon_simd, prints what the device reports and
+// optionally repeats a request so the client paths can be profiled.
+
+#include "chameleon_engine.h"
+#include "serial_handler.h"
+#include <furi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static bool probe_request(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const char* name,
+    ChameleonFrameView* response) {
+    if(!chameleon_engine_request(engine, cmd, NULL, 0, response)) {
+        fprintf(stderr, "%s: no response\n", name);
+        return false;
+    }
+
+    if(!chameleon_protocol_status_is_success(response->status)) {
+        fprintf(stderr, "%s: status 0x%04X\n", name, response->status);
+        chameleon_engine_release(engine, response);
+        return false;
+    }
+
+    return true;
+}
+
+static void probe_device(ChameleonEngine* engine) {
+    ChameleonFrameView response;
+
+    if(probe_request(engine, CMD_GET_APP_VERSION, "version", &response)) {
+        printf("Version:  %u.%u\n", response.data[0], response.data[1]);
+        chameleon_engine_release(engine, &response);
+    }
+
+    if(probe_request(engine, CMD_GET_GIT_VERSION, "git version", &response)) {
+        printf("Git:      %.*s\n", response.data_len, (const char*)response.data);
+        chameleon_engine_release(engine, &response);
+    }
+
+    if(probe_request(engine, CMD_GET_DEVICE_CHIP_ID, "chip ID", &response)) {
+        printf("Chip ID:  ");
+        for(uint16_t i = 0; i < response.data_len; i++) {
+            printf("%02X", response.data[i]);
+        }
+        printf("\n");
+        chameleon_engine_release(engine, &response);
+    }
+
+    if(probe_request(engine, CMD_GET_DEVICE_MODEL, "model", &response)) {
+        printf("Model:    %s\n", response.data[0] == 0 ? "Ultra" : "Lite");
+        chameleon_engine_release(engine, &response);
+    }
+
+    if(probe_request(engine, CMD_GET_DEVICE_MODE, "mode", &response)) {
+        printf("Mode:     %s\n", response.data[0] ? "Reader" : "Emulator");
+        chameleon_engine_release(engine, &response);
+    }
+
+    if(probe_request(engine, CMD_GET_SLOT_INFO, "slots", &response)) {
+        for(uint8_t i = 0; i < CHAMELEON_SLOT_COUNT; i++) {
+            const uint8_t* entry = &response.data[i * CHAMELEON_SLOT_INFO_ENTRY_LEN];
+            printf(
+                "Slot %u:   HF %u%s LF %u%s \"%.*s\"\n",
+                entry[0],
+                entry[1],
+                entry[3] ? "" : " (off)",
+                entry[2],
+                entry[4] ? "" : " (off)",
+                (int)strnlen((const char*)&entry[5], CHAMELEON_SLOT_NICK_LEN),
+                (const char*)&entry[5]);
+        }
+        chameleon_engine_release(engine, &response);
+    }
+}
+
+static void probe_repeat(ChameleonEngine* engine, uint32_t count) {
+    struct timespec start, end;
+    uint32_t failed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(uint32_t i = 0; i < count; i++) {
+        ChameleonFrameView response;
+        if(chameleon_engine_request(engine, CMD_GET_APP_VERSION, NULL, 0, &response)) {
+            chameleon_engine_release(engine, &response);
+        } else {
+            failed++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf(
+        "%u requests in %.3f s, %.0f req/s, %.1f us/req, %u failed\n",
+        count,
+        seconds,
+        count / seconds,
+        seconds * 1e6 / count,
+        failed);
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t repeat = 0;
+    int option;
+
+    while((option = getopt(argc, argv, "n:h")) != -1) {
+        switch(option) {
+        case 'n':
+            repeat = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n repeat] device\n", argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+
+    if(optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-n repeat] device\n", argv[0]);
+        return 2;
+    }
+
+    SerialHandler* serial = serial_handler_alloc();
+    if(!serial_handler_open(serial, argv[optind])) {
+        serial_handler_free(serial);
+        return 1;
+    }
+
+    ChameleonTransport transport;
+    chameleon_transport_init(&transport, &serial_handler_transport, serial);
+
+    ChameleonEngine* engine = chameleon_engine_alloc();
+    chameleon_engine_set_link(engine, ChameleonEngineLinkUsb);
+    chameleon_engine_set_transport(engine, &transport);
+    chameleon_transport_start_rx(&transport);
+
+    probe_device(engine);
+    if(repeat) {
+        probe_repeat(engine, repeat);
+    }
+
+    ChameleonTransportStats stats;
+    chameleon_transport_get_stats(&transport, &stats);
+    printf(
+        "TX %u B, RX %u B, RX dropped %u, peak %zu B\n",
+        stats.tx_bytes,
+        stats.rx_bytes,
+        stats.rx_dropped,
+        stats.rx_high_water);
+
+    chameleon_transport_stop_rx(&transport);
+    chameleon_engine_set_transport(engine, NULL);
+    chameleon_engine_free(engine);
+    serial_handler_free(serial);
+
+    return 0;
+}
@@ -0,0 +1,207 @@
+#include "chameleon_protocol.h"
+#include <furi.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_TIME_NS 200000000ULL // Run each case for at least 200 ms
+#define BENCH_BATCH 1024
+
+static const uint16_t bench_payload_sizes[] = {0, 16, 64, 512};
+
+// Keeps results observable so the compiler cannot drop the measured work
+static volatile uint32_t bench_sink;
+
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_fill(uint8_t* data, size_t len) {
+    uint32_t seed = 0x12345678;
+    for(size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = seed >> 16;
+    }
+}
+
+static void bench_report(const char* name, uint16_t len, uint64_t iterations, uint64_t elapsed_ns) {
+    double seconds = (double)elapsed_ns / 1e9;
+    double per_sec = (double)iterations / seconds;
+    printf(
+        "%-24s %4u B %12.0f frames/s %10.1f MB/s %8.1f ns/frame\n",
+        name,
+        len,
+        per_sec,
+        per_sec * (len + CHAMELEON_FRAME_OVERHEAD) / 1e6,
+        (double)elapsed_ns / (double)iterations);
+}
+
+static void bench_build_frame(ChameleonProtocol* protocol, const uint8_t* payload, uint16_t len) {
+    uint8_t frame[CHAMELEON_MAX_FRAME_LEN];
+    size_t frame_len;
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    do {
+        for(size_t i = 0; i < BENCH_BATCH; i++) {
+            chameleon_protocol_build_frame(protocol, CMD_MF1_WRITE_EMU_BLOCK_DATA, payload, len, frame, &frame_len);
+            bench_sink += frame[frame_len - 1];
+        }
+        iterations += BENCH_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    bench_report("build_frame", len, iterations, elapsed);
+}
+
+static void bench_parse_frame(ChameleonProtocol* protocol, const uint8_t* payload, uint16_t len) {
+    uint8_t frame[CHAMELEON_MAX_FRAME_LEN];
+    uint8_t data[CHAMELEON_MAX_DATA_LEN];
+    size_t frame_len;
+    uint16_t cmd, status, data_len;
+
+    chameleon_protocol_build_frame(protocol, CMD_MF1_WRITE_EMU_BLOCK_DATA, payload, len, frame, &frame_len);
+
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    do {
+        for(size_t i = 0; i < BENCH_BATCH; i++) {
+            if(!chameleon_protocol_parse_frame(protocol, frame, frame_len, &cmd, &status, data, &data_len)) {
+                fprintf(stderr, "parse_frame failed\n");
+                exit(1);
+            }
+            bench_sink += data_len;
+        }
+        iterations += BENCH_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    bench_report("parse_frame", len, iterations, elapsed);
+}
+
+static void bench_parse_frame_view(ChameleonProtocol* protocol, const uint8_t* payload, uint16_t len) {
+    uint8_t frame[CHAMELEON_MAX_FRAME_LEN];
+    size_t frame_len;
+    ChameleonFrameView view;
+
+    chameleon_protocol_build_frame(protocol, CMD_MF1_WRITE_EMU_BLOCK_DATA, payload, len, frame, &frame_len);
+
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    do {
+        for(size_t i = 0; i < BENCH_BATCH; i++) {
+            if(!chameleon_protocol_parse_frame_view(frame, frame_len, &view)) {
+                fprintf(stderr, "parse_frame_view failed\n");
+                exit(1);
+            }
+            bench_sink += view.data_len;
+        }
+        iterations += BENCH_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    bench_report("parse_frame_view", len, iterations, elapsed);
+}
+
+static void bench_decoder_callback(const ChameleonFrameView* view, void* context) {
+    UNUSED(context);
+    bench_sink += view->data_len;
+}
+
+static void bench_decoder_feed(ChameleonProtocol* protocol, const uint8_t* payload, uint16_t len) {
+    uint8_t frame[CHAMELEON_MAX_FRAME_LEN];
+    size_t frame_len;
+
+    chameleon_protocol_build_frame(protocol, CMD_MF1_WRITE_EMU_BLOCK_DATA, payload, len, frame, &frame_len);
+
+    ChameleonFrameDecoder* decoder = chameleon_frame_decoder_alloc();
+    chameleon_frame_decoder_set_callback(decoder, bench_decoder_callback, NULL);
+
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    // Feed in 64 byte pieces, the USB CDC packet size
+    do {
+        for(size_t i = 0; i < BENCH_BATCH; i++) {
+            for(size_t offset = 0; offset < frame_len; offset += 64) {
+                chameleon_frame_decoder_feed(decoder, &frame[offset], MIN(frame_len - offset, (size_t)64));
+            }
+        }
+        iterations += BENCH_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    ChameleonFrameDecoderStats stats;
+    chameleon_frame_decoder_get_stats(decoder, &stats);
+    if(stats.frames != iterations) {
+        fprintf(stderr, "decoder lost frames: %u of %llu\n", stats.frames, (unsigned long long)iterations);
+        exit(1);
+    }
+
+    chameleon_frame_decoder_free(decoder);
+
+    bench_report("frame_decoder_feed", len, iterations, elapsed);
+}
+
+static void bench_calculate_lrc(const uint8_t* data, size_t len) {
+    uint64_t iterations = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+
+    do {
+        for(size_t i = 0; i < BENCH_BATCH; i++) {
+            bench_sink += chameleon_protocol_calculate_lrc(data, len);
+        }
+        iterations += BENCH_BATCH;
+        elapsed = bench_now_ns() - start;
+    } while(elapsed < BENCH_MIN_TIME_NS);
+
+    double seconds = (double)elapsed / 1e9;
+    printf(
+        "%-24s %4zu B %12.1f MB/s %8.2f ns/byte\n",
+        "calculate_lrc",
+        len,
+        (double)(iterations * len) / seconds / 1e6,
+        (double)elapsed / (double)(iterations * len));
+}
+
+int main(void) {
+    uint8_t payload[CHAMELEON_MAX_DATA_LEN];
+    bench_fill(payload, sizeof(payload));
+
+    ChameleonProtocol* protocol = chameleon_protocol_alloc();
+
+    for(size_t i = 0; i < COUNT_OF(bench_payload_sizes); i++) {
+        bench_build_frame(protocol, payload, bench_payload_sizes[i]);
+    }
+
+    for(size_t i = 0; i < COUNT_OF(bench_payload_sizes); i++) {
+        bench_parse_frame(protocol, payload, bench_payload_sizes[i]);
+    }
+
+    for(size_t i = 0; i < COUNT_OF(bench_payload_sizes); i++) {
+        bench_parse_frame_view(protocol, payload, bench_payload_sizes[i]);
+    }
+
+    for(size_t i = 0; i < COUNT_OF(bench_payload_sizes); i++) {
+        bench_decoder_feed(protocol, payload, bench_payload_sizes[i]);
+    }
+
+    for(size_t i = 1; i < COUNT_OF(bench_payload_sizes); i++) {
+        bench_calculate_lrc(payload, bench_payload_sizes[i]);
+    }
+
+    chameleon_protocol_free(protocol);
+
+    return 0;
+}
@@ -0,0 +1,980 @@
+#include "chameleon_sim.h"
+#include <furi.h>
+#include <string.h>
+#include <time.h>
+
+#define TAG "ChameleonSim"
+
+// Wait on the thread flags for delays of at least this long, spin shorter ones
+#define CHAMELEON_SIM_SLEEP_MIN_US 2000
+
+// Bytes of client to device traffic corrupted at a time
+#define CHAMELEON_SIM_FEED_CHUNK 64
+
+#define CHAMELEON_SIM_DEFAULT_SEED 0x2545F491
+
+// Sense types of SET_SLOT_ENABLE and DELETE_SLOT_SENSE_TYPE
+#define CHAMELEON_SIM_SENSE_HF 1
+#define CHAMELEON_SIM_SENSE_LF 2
+
+#define CHAMELEON_SIM_MF1_KEY_A 0x60
+#define CHAMELEON_SIM_MF1_KEY_B 0x61
+#define CHAMELEON_SIM_MF1_KEY_LEN 6
+
+#define CHAMELEON_SIM_EM410X_ID_LEN 5
+
+// Values the device model reports
+#define CHAMELEON_SIM_VERSION_MAJOR 2
+#define CHAMELEON_SIM_VERSION_MINOR 0
+#define CHAMELEON_SIM_GIT_VERSION "v2.0.0-sim"
+#define CHAMELEON_SIM_MODEL_ULTRA 0
+#define CHAMELEON_SIM_CHIP_ID_LEN 8
+
+typedef enum {
+    ChameleonSimEventQueued = (1 << 0),
+    ChameleonSimEventStop = (1 << 1),
+} ChameleonSimEvent;
+
+#define CHAMELEON_SIM_EVENTS_ALL (ChameleonSimEventQueued | ChameleonSimEventStop)
+
+// Response frame waiting for its delivery time
+typedef struct {
+    uint64_t due_us;
+    uint16_t length;
+    uint8_t frame[CHAMELEON_MAX_FRAME_LEN];
+} ChameleonSimPending;
+
+typedef struct {
+    uint8_t hf_tag_type;
+    uint8_t lf_tag_type;
+    bool hf_enabled;
+    bool lf_enabled;
+    uint8_t nickname[CHAMELEON_SLOT_NICK_LEN]; // Zero padded, no terminator
+    uint8_t em410x_id[CHAMELEON_SIM_EM410X_ID_LEN];
+    uint8_t mf1[CHAMELEON_SIM_MF1_BLOCKS][CHAMELEON_SIM_MF1_BLOCK_LEN];
+} ChameleonSimSlot;
+
+struct ChameleonSim {
+    FuriMutex* mutex; // Guards everything below up to the decoder
+    FuriThread* thread;
+
+    ChameleonSimLink link;
+    uint32_t random;
+    ChameleonSimStats stats;
+
+    // Device model
+    bool reader_mode;
+    uint8_t active_slot;
+    ChameleonSimSlot slots[CHAMELEON_SLOT_COUNT];
+
+    // Tags in the reader field
+    bool hf_present;
+    ChameleonSimHf14aTag hf_tag;
+    uint8_t hf_mf1[CHAMELEON_SIM_MF1_BLOCKS][CHAMELEON_SIM_MF1_BLOCK_LEN];
+    bool em410x_present;
+    uint8_t em410x_id[CHAMELEON_SIM_EM410X_ID_LEN];
+
+    // Delivery queue, oldest first
+    ChameleonSimPending queue[CHAMELEON_SIM_QUEUE_LEN];
+    size_t queue_head;
+    size_t queue_count;
+    uint64_t last_due_us;
+    bool delivering; // Delivery thread is writing a frame to the output
+
+    // Used on the feeding thread only
+    ChameleonFrameDecoder* decoder;
+    uint8_t response[CHAMELEON_MAX_FRAME_LEN];
+
+    ChameleonSimOutputCallback output_callback;
+    void* output_context;
+};
+
+typedef uint16_t (*ChameleonSimHandler)(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len);
+
+typedef struct {
+    uint16_t cmd;
+    ChameleonSimHandler handler;
+} ChameleonSimCommand;
+
+static uint64_t chameleon_sim_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// xorshift32, mutex held
+static uint32_t chameleon_sim_random(ChameleonSim* sim) {
+    uint32_t x = sim->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->random = x;
+    return x;
+}
+
+// Flip bits at the configured rate, mutex held
+static void chameleon_sim_corrupt(ChameleonSim* sim, uint8_t* data, size_t length) {
+    if(!sim->link.bit_error_ppm) return;
+
+    for(size_t bit = 0; bit < length * 8; bit++) {
+        if(chameleon_sim_random(sim) % 1000000 < sim->link.bit_error_ppm) {
+            data[bit / 8] ^= 1 << (bit % 8);
+            sim->stats.bit_errors++;
+        }
+    }
+}
+
+// Blank MIFARE Classic 1K: manufacturer block from the tag, transport keys
+static void chameleon_sim_mf1_format(
+    uint8_t mf1[CHAMELEON_SIM_MF1_BLOCKS][CHAMELEON_SIM_MF1_BLOCK_LEN],
+    const ChameleonSimHf14aTag* tag) {
+    static const uint8_t trailer[CHAMELEON_SIM_MF1_BLOCK_LEN] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07, 0x80, 0x69, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    memset(mf1, 0, CHAMELEON_SIM_MF1_BLOCKS * CHAMELEON_SIM_MF1_BLOCK_LEN);
+    for(size_t block = 3; block < CHAMELEON_SIM_MF1_BLOCKS; block += 4) {
+        memcpy(mf1[block], trailer, sizeof(trailer));
+    }
+
+    size_t offset = tag->uid_len;
+    memcpy(mf1[0], tag->uid, tag->uid_len);
+    if(tag->uid_len == 4) {
+        mf1[0][offset++] = tag->uid[0] ^ tag->uid[1] ^ tag->uid[2] ^ tag->uid[3];
+    }
+    mf1[0][offset++] = tag->sak;
+    mf1[0][offset++] = tag->atqa[0];
+    mf1[0][offset] = tag->atqa[1];
+}
+
+static uint16_t chameleon_sim_get_app_version(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(sim);
+    UNUSED(data);
+    UNUSED(data_len);
+
+    response[0] = CHAMELEON_SIM_VERSION_MAJOR;
+    response[1] = CHAMELEON_SIM_VERSION_MINOR;
+    *response_len = 2;
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_change_device_mode(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    // True selects reader mode
+    sim->reader_mode = data[0] != 0;
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_get_device_mode(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data);
+    UNUSED(data_len);
+
+    response[0] = sim->reader_mode ? 1 : 0;
+    *response_len = 1;
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_set_active_slot(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    if(data[0] >= CHAMELEON_SLOT_COUNT) return STATUS_INVALID_PARAM;
+
+    sim->active_slot = data[0];
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_set_slot_tag_type(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    uint16_t tag_type = (data[1] << 8) | data[2];
+    if(data[0] >= CHAMELEON_SLOT_COUNT || tag_type > UINT8_MAX) return STATUS_INVALID_PARAM;
+
+    ChameleonSimSlot* slot = &sim->slots[data[0]];
+    if(tag_type >= CHAMELEON_SIM_LF_TAG_TYPE_MIN) {
+        slot->lf_tag_type = tag_type;
+    } else {
+        slot->hf_tag_type = tag_type;
+    }
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_set_slot_enable(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    if(data[0] >= CHAMELEON_SLOT_COUNT) return STATUS_INVALID_PARAM;
+
+    ChameleonSimSlot* slot = &sim->slots[data[0]];
+    if(data[1] == CHAMELEON_SIM_SENSE_HF) {
+        slot->hf_enabled = data[2] != 0;
+    } else if(data[1] == CHAMELEON_SIM_SENSE_LF) {
+        slot->lf_enabled = data[2] != 0;
+    } else {
+        return STATUS_INVALID_PARAM;
+    }
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_set_slot_tag_nick(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(response);
+    UNUSED(response_len);
+
+    if(data[0] >= CHAMELEON_SLOT_COUNT) return STATUS_INVALID_PARAM;
+
+    ChameleonSimSlot* slot = &sim->slots[data[0]];
+    memset(slot->nickname, 0, sizeof(slot->nickname));
+    memcpy(slot->nickname, &data[1], data_len - 1);
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_get_device_chip_id(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(sim);
+    UNUSED(data);
+    UNUSED(data_len);
+
+    static const uint8_t chip_id[CHAMELEON_SIM_CHIP_ID_LEN] = {
+        0x5C, 0x1A, 0x7E, 0x00, 0xC0, 0xFF, 0xEE, 0x01};
+
+    memcpy(response, chip_id, sizeof(chip_id));
+    *response_len = sizeof(chip_id);
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_get_git_version(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(sim);
+    UNUSED(data);
+    UNUSED(data_len);
+
+    // No terminator, like every string on the wire
+    *response_len = strlen(CHAMELEON_SIM_GIT_VERSION);
+    memcpy(response, CHAMELEON_SIM_GIT_VERSION, *response_len);
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_get_slot_info(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data);
+    UNUSED(data_len);
+
+    for(uint8_t i = 0; i < CHAMELEON_SLOT_COUNT; i++) {
+        const ChameleonSimSlot* slot = &sim->slots[i];
+        uint8_t* entry = &response[i * CHAMELEON_SLOT_INFO_ENTRY_LEN];
+
+        entry[0] = i;
+        entry[1] = slot->hf_tag_type;
+        entry[2] = slot->lf_tag_type;
+        entry[3] = slot->hf_enabled;
+        entry[4] = slot->lf_enabled;
+        memcpy(&entry[5], slot->nickname, CHAMELEON_SLOT_NICK_LEN);
+    }
+
+    *response_len = CHAMELEON_SLOT_INFO_LEN;
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_delete_slot_sense_type(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    if(data[0] >= CHAMELEON_SLOT_COUNT) return STATUS_INVALID_PARAM;
+
+    ChameleonSimSlot* slot = &sim->slots[data[0]];
+    if(data[1] == CHAMELEON_SIM_SENSE_HF) {
+        slot->hf_tag_type = 0;
+        slot->hf_enabled = false;
+    } else if(data[1] == CHAMELEON_SIM_SENSE_LF) {
+        slot->lf_tag_type = 0;
+        slot->lf_enabled = false;
+    } else {
+        return STATUS_INVALID_PARAM;
+    }
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_get_device_model(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(sim);
+    UNUSED(data);
+    UNUSED(data_len);
+
+    response[0] = CHAMELEON_SIM_MODEL_ULTRA;
+    *response_len = 1;
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_get_device_capabilities(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len);
+
+static uint16_t chameleon_sim_hf14a_scan(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data);
+    UNUSED(data_len);
+
+    if(!sim->hf_present) return STATUS_HF_TAG_NO;
+
+    // One tag: UID length, UID, ATQA, SAK, ATS length, ATS
+    const ChameleonSimHf14aTag* tag = &sim->hf_tag;
+    uint16_t offset = 0;
+    response[offset++] = tag->uid_len;
+    memcpy(&response[offset], tag->uid, tag->uid_len);
+    offset += tag->uid_len;
+    response[offset++] = tag->atqa[0];
+    response[offset++] = tag->atqa[1];
+    response[offset++] = tag->sak;
+    response[offset++] = tag->ats_len;
+    memcpy(&response[offset], tag->ats, tag->ats_len);
+    offset += tag->ats_len;
+
+    *response_len = offset;
+    return STATUS_HF_TAG_OK;
+}
+
+static uint16_t chameleon_sim_mf1_detect_support(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data);
+    UNUSED(data_len);
+
+    if(!sim->hf_present) return STATUS_HF_TAG_NO;
+
+    // SAK bit 3 marks MIFARE Classic
+    response[0] = (sim->hf_tag.sak & 0x08) != 0;
+    *response_len = 1;
+    return STATUS_HF_TAG_OK;
+}
+
+// Check type|block|key of a reader request against the sector trailer
+static uint16_t chameleon_sim_mf1_auth(ChameleonSim* sim, const uint8_t* data) {
+    uint8_t key_type = data[0];
+    uint8_t block = data[1];
+    const uint8_t* key = &data[2];
+
+    if(!sim->hf_present) return STATUS_HF_TAG_NO;
+    if(block >= CHAMELEON_SIM_MF1_BLOCKS) return STATUS_INVALID_PARAM;
+
+    const uint8_t* trailer = sim->hf_mf1[block | 3];
+    if(key_type == CHAMELEON_SIM_MF1_KEY_A) {
+        if(memcmp(key, &trailer[0], CHAMELEON_SIM_MF1_KEY_LEN) != 0) return STATUS_MF_ERR_AUTH;
+    } else if(key_type == CHAMELEON_SIM_MF1_KEY_B) {
+        if(memcmp(key, &trailer[10], CHAMELEON_SIM_MF1_KEY_LEN) != 0) return STATUS_MF_ERR_AUTH;
+    } else {
+        return STATUS_INVALID_PARAM;
+    }
+    return STATUS_HF_TAG_OK;
+}
+
+static uint16_t chameleon_sim_mf1_auth_one_key_block(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    return chameleon_sim_mf1_auth(sim, data);
+}
+
+static uint16_t chameleon_sim_mf1_read_one_block(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+
+    uint16_t status = chameleon_sim_mf1_auth(sim, data);
+    if(status != STATUS_HF_TAG_OK) return status;
+
+    memcpy(response, sim->hf_mf1[data[1]], CHAMELEON_SIM_MF1_BLOCK_LEN);
+    *response_len = CHAMELEON_SIM_MF1_BLOCK_LEN;
+    return status;
+}
+
+static uint16_t chameleon_sim_mf1_write_one_block(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    uint16_t status = chameleon_sim_mf1_auth(sim, data);
+    if(status != STATUS_HF_TAG_OK) return status;
+
+    memcpy(sim->hf_mf1[data[1]], &data[2 + CHAMELEON_SIM_MF1_KEY_LEN], CHAMELEON_SIM_MF1_BLOCK_LEN);
+    return status;
+}
+
+static uint16_t chameleon_sim_em410x_scan(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data);
+    UNUSED(data_len);
+
+    if(!sim->em410x_present) return STATUS_LF_TAG_NO;
+
+    memcpy(response, sim->em410x_id, CHAMELEON_SIM_EM410X_ID_LEN);
+    *response_len = CHAMELEON_SIM_EM410X_ID_LEN;
+    return STATUS_LF_TAG_OK;
+}
+
+static uint16_t chameleon_sim_mf1_write_emu_block_data(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(response);
+    UNUSED(response_len);
+
+    // Start block followed by whole blocks
+    uint8_t block = data[0];
+    uint16_t length = data_len - 1;
+    if(length % CHAMELEON_SIM_MF1_BLOCK_LEN) return STATUS_INVALID_PARAM;
+    if(block + length / CHAMELEON_SIM_MF1_BLOCK_LEN > CHAMELEON_SIM_MF1_BLOCKS) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    memcpy(sim->slots[sim->active_slot].mf1[block], &data[1], length);
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_mf1_read_emu_block_data(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+
+    // Start block and block count
+    uint8_t block = data[0];
+    uint8_t count = data[1];
+    if(count == 0 || block + count > CHAMELEON_SIM_MF1_BLOCKS ||
+       count * CHAMELEON_SIM_MF1_BLOCK_LEN > CHAMELEON_MAX_DATA_LEN) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    *response_len = count * CHAMELEON_SIM_MF1_BLOCK_LEN;
+    memcpy(response, sim->slots[sim->active_slot].mf1[block], *response_len);
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_mf1_get_emulator_config(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(sim);
+    UNUSED(data);
+    UNUSED(data_len);
+
+    // Detection, Gen1a, Gen2, block anti-collision off, normal write mode
+    memset(response, 0, 5);
+    *response_len = 5;
+    return STATUS_SUCCESS;
+}
+
+static uint16_t chameleon_sim_em410x_set_emu_id(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(data_len);
+    UNUSED(response);
+    UNUSED(response_len);
+
+    memcpy(sim->slots[sim->active_slot].em410x_id, data, CHAMELEON_SIM_EM410X_ID_LEN);
+    return STATUS_SUCCESS;
+}
+
+// Implemented commands, everything else is answered with STATUS_INVALID_CMD
+static const ChameleonSimCommand chameleon_sim_commands[] = {
+    {CMD_GET_APP_VERSION, chameleon_sim_get_app_version},
+    {CMD_CHANGE_DEVICE_MODE, chameleon_sim_change_device_mode},
+    {CMD_GET_DEVICE_MODE, chameleon_sim_get_device_mode},
+    {CMD_SET_ACTIVE_SLOT, chameleon_sim_set_active_slot},
+    {CMD_SET_SLOT_TAG_TYPE, chameleon_sim_set_slot_tag_type},
+    {CMD_SET_SLOT_ENABLE, chameleon_sim_set_slot_enable},
+    {CMD_SET_SLOT_TAG_NICK, chameleon_sim_set_slot_tag_nick},
+    {CMD_GET_DEVICE_CHIP_ID, chameleon_sim_get_device_chip_id},
+    {CMD_GET_GIT_VERSION, chameleon_sim_get_git_version},
+    {CMD_GET_SLOT_INFO, chameleon_sim_get_slot_info},
+    {CMD_DELETE_SLOT_SENSE_TYPE, chameleon_sim_delete_slot_sense_type},
+    {CMD_GET_DEVICE_MODEL, chameleon_sim_get_device_model},
+    {CMD_GET_DEVICE_CAPABILITIES, chameleon_sim_get_device_capabilities},
+    {CMD_HF14A_SCAN, chameleon_sim_hf14a_scan},
+    {CMD_MF1_DETECT_SUPPORT, chameleon_sim_mf1_detect_support},
+    {CMD_MF1_AUTH_ONE_KEY_BLOCK, chameleon_sim_mf1_auth_one_key_block},
+    {CMD_MF1_READ_ONE_BLOCK, chameleon_sim_mf1_read_one_block},
+    {CMD_MF1_WRITE_ONE_BLOCK, chameleon_sim_mf1_write_one_block},
+    {CMD_EM410X_SCAN, chameleon_sim_em410x_scan},
+    {CMD_MF1_WRITE_EMU_BLOCK_DATA, chameleon_sim_mf1_write_emu_block_data},
+    {CMD_MF1_READ_EMU_BLOCK_DATA, chameleon_sim_mf1_read_emu_block_data},
+    {CMD_MF1_GET_EMULATOR_CONFIG, chameleon_sim_mf1_get_emulator_config},
+    {CMD_EM410X_SET_EMU_ID, chameleon_sim_em410x_set_emu_id},
+};
+
+static uint16_t chameleon_sim_get_device_capabilities(
+    ChameleonSim* sim,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* response,
+    uint16_t* response_len) {
+    UNUSED(sim);
+    UNUSED(data);
+    UNUSED(data_len);
+
+    // Big-endian u16 IDs
+    for(size_t i = 0; i < COUNT_OF(chameleon_sim_commands); i++) {
+        response[i * 2] = chameleon_sim_commands[i].cmd >> 8;
+        response[i * 2 + 1] = chameleon_sim_commands[i].cmd & 0xFF;
+    }
+
+    *response_len = COUNT_OF(chameleon_sim_commands) * 2;
+    return STATUS_SUCCESS;
+}
+
+// Run one request against the device model, mutex held
+static uint16_t chameleon_sim_handle(
+    ChameleonSim* sim,
+    const ChameleonFrameView* request,
+    uint8_t* response,
+    uint16_t* response_len) {
+    ChameleonSimHandler handler = NULL;
+    for(size_t i = 0; i < COUNT_OF(chameleon_sim_commands); i++) {
+        if(chameleon_sim_commands[i].cmd == request->cmd) {
+            handler = chameleon_sim_commands[i].handler;
+            break;
+        }
+    }
+
+    if(!handler) {
+        sim->stats.unsupported++;
+        return STATUS_INVALID_CMD;
+    }
+
+    // Every implemented command has a descriptor
+    const ChameleonCommandDescriptor* descriptor = chameleon_protocol_get_command(request->cmd);
+    if(request->data_len < descriptor->request_min || request->data_len > descriptor->request_max) {
+        return STATUS_INVALID_PARAM;
+    }
+
+    return handler(sim, request->data, request->data_len, response, response_len);
+}
+
+// Response header and trailer around data already in place
+static size_t chameleon_sim_build_frame(
+    uint8_t* frame,
+    uint16_t cmd,
+    uint16_t status,
+    uint16_t data_len) {
+    frame[0] = CHAMELEON_SOF;
+    frame[1] = CHAMELEON_LRC1;
+    frame[2] = cmd >> 8;
+    frame[3] = cmd & 0xFF;
+    frame[4] = status >> 8;
+    frame[5] = status & 0xFF;
+    frame[6] = data_len >> 8;
+    frame[7] = data_len & 0xFF;
+    frame[8] = chameleon_protocol_calculate_lrc(&frame[2], 6);
+    frame[CHAMELEON_HEADER_LEN + data_len] =
+        chameleon_protocol_build_trailer(&frame[CHAMELEON_HEADER_LEN], data_len);
+
+    return CHAMELEON_HEADER_LEN + data_len + 1;
+}
+
+// Hand a frame to the output, in fragments if configured
+static void chameleon_sim_output(ChameleonSim* sim, const uint8_t* frame, size_t length) {
+    while(length) {
+        size_t chunk = length;
+
+        furi_mutex_acquire(sim->mutex, FuriWaitForever);
+        if(sim->link.fragment_max) {
+            size_t fragment = 1 + chameleon_sim_random(sim) % sim->link.fragment_max;
+            chunk = MIN(length, fragment);
+        }
+        furi_mutex_release(sim->mutex);
+
+        if(sim->output_callback) {
+            sim->output_callback(frame, chunk, sim->output_context);
+        }
+        frame += chunk;
+        length -= chunk;
+    }
+}
+
+// Corrupt and queue a response frame, or output it right away on an ideal link
+static void chameleon_sim_send(ChameleonSim* sim, uint8_t* frame, size_t length) {
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+
+    chameleon_sim_corrupt(sim, frame, length);
+    sim->stats.responses++;
+
+    const ChameleonSimLink* link = &sim->link;
+    bool delayed = link->latency_us || link->jitter_us || link->fragment_max;
+    if(!delayed && sim->queue_count == 0 && !sim->delivering) {
+        furi_mutex_release(sim->mutex);
+        chameleon_sim_output(sim, frame, length);
+        return;
+    }
+
+    if(sim->queue_count == CHAMELEON_SIM_QUEUE_LEN) {
+        sim->stats.dropped++;
+        furi_mutex_release(sim->mutex);
+        FURI_LOG_W(TAG, "Delivery queue full");
+        return;
+    }
+
+    // A serial link keeps frames in order, jitter never lets one overtake another
+    uint64_t delay_us = link->latency_us;
+    if(link->jitter_us) {
+        delay_us += chameleon_sim_random(sim) % (link->jitter_us + 1);
+    }
+    uint64_t due_us = MAX(chameleon_sim_now_us() + delay_us, sim->last_due_us);
+    sim->last_due_us = due_us;
+
+    ChameleonSimPending* pending =
+        &sim->queue[(sim->queue_head + sim->queue_count) % CHAMELEON_SIM_QUEUE_LEN];
+    pending->due_us = due_us;
+    pending->length = length;
+    memcpy(pending->frame, frame, length);
+    sim->queue_count++;
+
+    furi_mutex_release(sim->mutex);
+
+    furi_thread_flags_set(furi_thread_get_id(sim->thread), ChameleonSimEventQueued);
+}
+
+static void chameleon_sim_frame_callback(const ChameleonFrameView* view, void* context) {
+    ChameleonSim* sim = context;
+    uint16_t data_len = 0;
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    sim->stats.requests++;
+    uint16_t status =
+        chameleon_sim_handle(sim, view, &sim->response[CHAMELEON_HEADER_LEN], &data_len);
+    uint32_t service_us = sim->link.service_us;
+    furi_mutex_release(sim->mutex);
+
+    if(service_us) {
+        furi_delay_us(service_us);
+    }
+
+    size_t length = chameleon_sim_build_frame(sim->response, view->cmd, status, data_len);
+    chameleon_sim_send(sim, sim->response, length);
+}
+
+static int32_t chameleon_sim_delivery_thread(void* context) {
+    ChameleonSim* sim = context;
+    uint8_t frame[CHAMELEON_MAX_FRAME_LEN];
+    uint32_t timeout = FuriWaitForever;
+
+    while(true) {
+        uint32_t events =
+            furi_thread_flags_wait(CHAMELEON_SIM_EVENTS_ALL, FuriFlagWaitAny, timeout);
+        if(!(events & FuriFlagError) && (events & ChameleonSimEventStop)) break;
+
+        timeout = FuriWaitForever;
+
+        while(true) {
+            furi_mutex_acquire(sim->mutex, FuriWaitForever);
+
+            if(sim->queue_count == 0) {
+                furi_mutex_release(sim->mutex);
+                break;
+            }
+
+            ChameleonSimPending* pending = &sim->queue[sim->queue_head];
+            uint64_t now_us = chameleon_sim_now_us();
+            if(pending->due_us > now_us) {
+                uint64_t wait_us = pending->due_us - now_us;
+                furi_mutex_release(sim->mutex);
+
+                // Flag waits have tick resolution, spin out the last stretch
+                if(wait_us >= CHAMELEON_SIM_SLEEP_MIN_US) {
+                    timeout = wait_us / 1000 - 1;
+                    break;
+                }
+                furi_delay_us(wait_us);
+                continue;
+            }
+
+            size_t length = pending->length;
+            memcpy(frame, pending->frame, length);
+            sim->queue_head = (sim->queue_head + 1) % CHAMELEON_SIM_QUEUE_LEN;
+            sim->queue_count--;
+            sim->delivering = true;
+
+            furi_mutex_release(sim->mutex);
+
+            chameleon_sim_output(sim, frame, length);
+
+            furi_mutex_acquire(sim->mutex, FuriWaitForever);
+            sim->delivering = false;
+            furi_mutex_release(sim->mutex);
+        }
+    }
+
+    return 0;
+}
+
+ChameleonSim* chameleon_sim_alloc() {
+    ChameleonSim* sim = malloc(sizeof(ChameleonSim));
+    memset(sim, 0, sizeof(ChameleonSim));
+
+    sim->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    sim->random = CHAMELEON_SIM_DEFAULT_SEED;
+
+    sim->decoder = chameleon_frame_decoder_alloc();
+    chameleon_frame_decoder_set_callback(sim->decoder, chameleon_sim_frame_callback, sim);
+
+    // MIFARE Classic 1K and EM410X in the field, slot 0 emulates the same pair
+    static const ChameleonSimHf14aTag default_tag = {
+        .uid = {0xDE, 0xAD, 0xBE, 0xEF},
+        .uid_len = 4,
+        .atqa = {0x00, 0x04},
+        .sak = 0x08,
+    };
+    static const uint8_t default_em410x_id[CHAMELEON_SIM_EM410X_ID_LEN] = {
+        0x01, 0x23, 0x45, 0x67, 0x89};
+
+    sim->hf_present = true;
+    sim->hf_tag = default_tag;
+    chameleon_sim_mf1_format(sim->hf_mf1, &default_tag);
+    sim->em410x_present = true;
+    memcpy(sim->em410x_id, default_em410x_id, sizeof(default_em410x_id));
+
+    for(size_t i = 0; i < CHAMELEON_SLOT_COUNT; i++) {
+        chameleon_sim_mf1_format(sim->slots[i].mf1, &default_tag);
+    }
+
+    ChameleonSimSlot* slot = &sim->slots[0];
+    slot->hf_tag_type = 1; // MIFARE Classic 1K
+    slot->lf_tag_type = CHAMELEON_SIM_LF_TAG_TYPE_MIN; // EM410X
+    slot->hf_enabled = true;
+    slot->lf_enabled = true;
+    memcpy(slot->em410x_id, default_em410x_id, sizeof(default_em410x_id));
+    memcpy(slot->nickname, "Simulator", strlen("Simulator"));
+
+    sim->reader_mode = true;
+
+    sim->thread =
+        furi_thread_alloc_ex("ChameleonSimDelivery", 2048, chameleon_sim_delivery_thread, sim);
+    furi_thread_start(sim->thread);
+
+    return sim;
+}
+
+void chameleon_sim_free(ChameleonSim* sim) {
+    furi_assert(sim);
+
+    // Frames still queued are dropped
+    furi_thread_flags_set(furi_thread_get_id(sim->thread), ChameleonSimEventStop);
+    furi_thread_join(sim->thread);
+    furi_thread_free(sim->thread);
+
+    chameleon_frame_decoder_free(sim->decoder);
+    furi_mutex_free(sim->mutex);
+    free(sim);
+}
+
+void chameleon_sim_set_output_callback(
+    ChameleonSim* sim,
+    ChameleonSimOutputCallback callback,
+    void* context) {
+    furi_assert(sim);
+    sim->output_callback = callback;
+    sim->output_context = context;
+}
+
+void chameleon_sim_set_link(ChameleonSim* sim, const ChameleonSimLink* link) {
+    furi_assert(sim);
+    furi_assert(link);
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    sim->link = *link;
+    sim->random = link->seed ? link->seed : CHAMELEON_SIM_DEFAULT_SEED;
+    furi_mutex_release(sim->mutex);
+}
+
+void chameleon_sim_get_link(ChameleonSim* sim, ChameleonSimLink* link) {
+    furi_assert(sim);
+    furi_assert(link);
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    *link = sim->link;
+    furi_mutex_release(sim->mutex);
+}
+
+void chameleon_sim_feed(ChameleonSim* sim, const uint8_t* data, size_t length) {
+    furi_assert(sim);
+    furi_assert(data || length == 0);
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    bool corrupt = sim->link.bit_error_ppm != 0;
+    furi_mutex_release(sim->mutex);
+
+    if(!corrupt) {
+        chameleon_frame_decoder_feed(sim->decoder, data, length);
+    } else {
+        uint8_t chunk[CHAMELEON_SIM_FEED_CHUNK];
+
+        while(length) {
+            size_t chunk_len = MIN(length, sizeof(chunk));
+            memcpy(chunk, data, chunk_len);
+
+            furi_mutex_acquire(sim->mutex, FuriWaitForever);
+            chameleon_sim_corrupt(sim, chunk, chunk_len);
+            furi_mutex_release(sim->mutex);
+
+            chameleon_frame_decoder_feed(sim->decoder, chunk, chunk_len);
+            data += chunk_len;
+            length -= chunk_len;
+        }
+    }
+
+    ChameleonFrameDecoderStats decoder_stats;
+    chameleon_frame_decoder_get_stats(sim->decoder, &decoder_stats);
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    sim->stats.rx_errors = decoder_stats.header_errors + decoder_stats.data_errors;
+    furi_mutex_release(sim->mutex);
+}
+
+void chameleon_sim_set_hf14a_tag(ChameleonSim* sim, const ChameleonSimHf14aTag* tag) {
+    furi_assert(sim);
+    furi_assert(!tag || (tag->uid_len <= sizeof(tag->uid) && tag->ats_len <= sizeof(tag->ats)));
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    sim->hf_present = tag != NULL;
+    if(tag) {
+        sim->hf_tag = *tag;
+        chameleon_sim_mf1_format(sim->hf_mf1, tag);
+    }
+    furi_mutex_release(sim->mutex);
+}
+
+void chameleon_sim_set_em410x_tag(ChameleonSim* sim, const uint8_t* id) {
+    furi_assert(sim);
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    sim->em410x_present = id != NULL;
+    if(id) {
+        memcpy(sim->em410x_id, id, CHAMELEON_SIM_EM410X_ID_LEN);
+    }
+    furi_mutex_release(sim->mutex);
+}
+
+bool chameleon_sim_get_emu_block(ChameleonSim* sim, uint8_t slot, uint8_t block, uint8_t* data) {
+    furi_assert(sim);
+    furi_assert(data);
+
+    if(slot >= CHAMELEON_SLOT_COUNT || block >= CHAMELEON_SIM_MF1_BLOCKS) return false;
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    memcpy(data, sim->slots[slot].mf1[block], CHAMELEON_SIM_MF1_BLOCK_LEN);
+    furi_mutex_release(sim->mutex);
+
+    return true;
+}
+
+void chameleon_sim_get_stats(ChameleonSim* sim, ChameleonSimStats* stats) {
+    furi_assert(sim);
+    furi_assert(stats);
+
+    furi_mutex_acquire(sim->mutex, FuriWaitForever);
+    *stats = sim->stats;
+    furi_mutex_release(sim->mutex);
+}
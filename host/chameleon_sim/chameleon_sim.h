@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chameleon_protocol.h"
+
+// Response frames waiting for their delivery time
+#define CHAMELEON_SIM_QUEUE_LEN 32
+
+// MIFARE Classic 1K memory, per emulator slot and for the tag in the field
+#define CHAMELEON_SIM_MF1_BLOCKS 64
+#define CHAMELEON_SIM_MF1_BLOCK_LEN 16
+
+// Tag types at and above this value are LF types, see ChameleonTagType
+#define CHAMELEON_SIM_LF_TAG_TYPE_MIN 7
+
+// Chameleon Ultra device simulator
+//
+// Decodes request frames fed to it, runs the command against a model of
+// the device (slots, nicknames, mode, MF1 emulator memory, tags in the
+// reader field) and emits response frames through the output callback.
+// Link impairments delay, fragment and corrupt the byte stream between
+// client and device, runs with the same seed and input are repeatable.
+typedef struct ChameleonSim ChameleonSim;
+
+// Link impairments, all zero is an ideal link
+typedef struct {
+    uint32_t service_us; // Device time per request, requests are served one at a time
+    uint32_t latency_us; // Delay of each response frame
+    uint32_t jitter_us; // Random extra delay up to this value, frames stay in order
+    uint16_t fragment_max; // Deliver responses in random chunks of 1..fragment_max bytes, 0 keeps frames whole
+    uint32_t bit_error_ppm; // Flipped bits per million, applied in both directions
+    uint32_t seed; // Random seed, 0 picks a fixed default
+} ChameleonSimLink;
+
+// Simulator counters since alloc
+typedef struct {
+    uint32_t requests; // Frames decoded
+    uint32_t rx_errors; // Frames dropped by the decoder, corrupt or truncated
+    uint32_t unsupported; // Requests answered with STATUS_INVALID_CMD
+    uint32_t responses; // Frames queued for output
+    uint32_t dropped; // Responses lost to a full delivery queue
+    uint32_t bit_errors; // Bits flipped by the link
+} ChameleonSimStats;
+
+// ISO14443-A tag in the reader field
+typedef struct {
+    uint8_t uid[10];
+    uint8_t uid_len; // 4, 7 or 10
+    uint8_t atqa[2];
+    uint8_t sak;
+    uint8_t ats[32];
+    uint8_t ats_len;
+} ChameleonSimHf14aTag;
+
+// Called with device to client bytes, on the thread feeding the simulator
+// for an ideal link and on the delivery thread otherwise
+typedef void (*ChameleonSimOutputCallback)(const uint8_t* data, size_t length, void* context);
+
+// Create and destroy simulator, starts with one MF1 1K tag and one EM410X
+// tag in the field and slot 0 set up for both
+ChameleonSim* chameleon_sim_alloc();
+void chameleon_sim_free(ChameleonSim* sim);
+
+// Set output callback, before feeding the first byte
+void chameleon_sim_set_output_callback(
+    ChameleonSim* sim,
+    ChameleonSimOutputCallback callback,
+    void* context);
+
+// Set link impairments, reseeds the random generator
+void chameleon_sim_set_link(ChameleonSim* sim, const ChameleonSimLink* link);
+void chameleon_sim_get_link(ChameleonSim* sim, ChameleonSimLink* link);
+
+// Feed client to device bytes, chunks may hold partial or multiple frames.
+// Requests are handled on the calling thread.
+void chameleon_sim_feed(ChameleonSim* sim, const uint8_t* data, size_t length);
+
+// Place a tag in the reader field, NULL removes it. The HF tag gets fresh
+// MF1 memory with transport keys.
+void chameleon_sim_set_hf14a_tag(ChameleonSim* sim, const ChameleonSimHf14aTag* tag);
+void chameleon_sim_set_em410x_tag(ChameleonSim* sim, const uint8_t* id);
+
+// Read a block of a slot's MF1 emulator memory
+bool chameleon_sim_get_emu_block(ChameleonSim* sim, uint8_t slot, uint8_t block, uint8_t* data);
+
+void chameleon_sim_get_stats(ChameleonSim* sim, ChameleonSimStats* stats);
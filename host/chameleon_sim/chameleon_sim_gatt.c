@@ -0,0 +1,362 @@
+#include "chameleon_sim_gatt.h"
+#include "chameleon_rx_queue.h"
+#include <furi.h>
+#include <string.h>
+
+#define TAG "ChameleonSimGatt"
+
+// Attribute handles of the UART service
+#define CHAMELEON_SIM_GATT_RX_VALUE 0x0010
+#define CHAMELEON_SIM_GATT_TX_VALUE 0x0012
+#define CHAMELEON_SIM_GATT_TX_CCCD 0x0013
+
+// Time a write waits for the simulator to catch up
+#define CHAMELEON_SIM_GATT_AIR_TIMEOUT_MS 100
+
+#define CHAMELEON_SIM_GATT_RSSI (-48)
+
+static const uint8_t chameleon_sim_gatt_mac[] = {0xC0, 0xDE, 0xC0, 0xDE, 0x00, 0x01};
+
+struct ChameleonSimGatt {
+    ChameleonSim* sim;
+    uint16_t peer_mtu;
+    ChameleonRxQueue* air; // Client writes on their way to the simulator
+    FuriTimer* update_timer; // Fires at the instant of a parameter update
+
+    // Guards everything below
+    FuriMutex* mutex;
+    BleHandlerBackendEventCallback callback;
+    void* context;
+    bool connected;
+    bool notify;
+    uint16_t att_mtu;
+    uint16_t interval; // 1.25 ms units
+    bool update_pending;
+    BleHandlerConnParams update;
+    ChameleonSimGattStats stats;
+};
+
+// The connection interval is what a response waits for
+static void chameleon_sim_gatt_apply_interval(ChameleonSimGatt* gatt, uint16_t interval) {
+    ChameleonSimLink link;
+    chameleon_sim_get_link(gatt->sim, &link);
+    link.latency_us = interval * 1250;
+    chameleon_sim_set_link(gatt->sim, &link);
+}
+
+// Block for a number of connection events at the current interval
+static void chameleon_sim_gatt_wait_events(ChameleonSimGatt* gatt, uint32_t events) {
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    uint32_t interval = gatt->interval;
+    furi_mutex_release(gatt->mutex);
+
+    furi_delay_us(events * interval * 1250);
+}
+
+static void chameleon_sim_gatt_update_callback(void* context) {
+    ChameleonSimGatt* gatt = context;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    bool apply = gatt->connected && gatt->update_pending;
+    gatt->update_pending = false;
+
+    // The peripheral has data queued and never skips connection events
+    BleHandlerConnParams params = {
+        .interval_min = gatt->update.interval_min,
+        .interval_max = gatt->update.interval_min,
+        .latency = gatt->update.latency,
+        .timeout = gatt->update.timeout,
+    };
+    if(apply) {
+        gatt->interval = params.interval_min;
+        gatt->stats.conn_updates++;
+    }
+    BleHandlerBackendEventCallback callback = gatt->callback;
+    void* callback_context = gatt->context;
+    furi_mutex_release(gatt->mutex);
+
+    if(!apply) return;
+
+    chameleon_sim_gatt_apply_interval(gatt, params.interval_min);
+
+    if(callback) {
+        BleHandlerBackendEvent event = {
+            .type = BleHandlerBackendEventConnParams,
+            .conn_params = &params,
+        };
+        callback(&event, callback_context);
+    }
+}
+
+static void chameleon_sim_gatt_air_callback(const uint8_t* data, size_t length, void* context) {
+    ChameleonSimGatt* gatt = context;
+    chameleon_sim_feed(gatt->sim, data, length);
+}
+
+// Responses leave as notifications of the negotiated size
+static void chameleon_sim_gatt_output_callback(const uint8_t* data, size_t length, void* context) {
+    ChameleonSimGatt* gatt = context;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    bool notify = gatt->connected && gatt->notify;
+    size_t packet_max = gatt->att_mtu - BLE_HANDLER_ATT_HEADER_LEN;
+    BleHandlerBackendEventCallback callback = gatt->callback;
+    void* callback_context = gatt->context;
+    if(notify) {
+        gatt->stats.notifications += (length + packet_max - 1) / packet_max;
+    }
+    furi_mutex_release(gatt->mutex);
+
+    if(!notify || !callback) return;
+
+    BleHandlerBackendEvent event = {
+        .type = BleHandlerBackendEventNotification,
+        .handle = CHAMELEON_SIM_GATT_TX_VALUE,
+    };
+    while(length > 0) {
+        event.data = data;
+        event.length = MIN(length, packet_max);
+        callback(&event, callback_context);
+        data += event.length;
+        length -= event.length;
+    }
+}
+
+ChameleonSimGatt* chameleon_sim_gatt_alloc(ChameleonSim* sim, uint16_t att_mtu) {
+    furi_assert(sim);
+    furi_assert(att_mtu >= BLE_HANDLER_ATT_MTU_DEFAULT);
+
+    ChameleonSimGatt* gatt = malloc(sizeof(ChameleonSimGatt));
+    memset(gatt, 0, sizeof(ChameleonSimGatt));
+
+    gatt->sim = sim;
+    gatt->peer_mtu = att_mtu;
+    gatt->att_mtu = BLE_HANDLER_ATT_MTU_DEFAULT;
+    gatt->interval = CHAMELEON_SIM_GATT_INTERVAL_DEFAULT;
+    gatt->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    gatt->update_timer =
+        furi_timer_alloc(chameleon_sim_gatt_update_callback, FuriTimerTypeOnce, gatt);
+
+    gatt->air = chameleon_rx_queue_alloc(CHAMELEON_SIM_GATT_AIR_SIZE, "SimGattAir");
+    chameleon_rx_queue_set_callback(gatt->air, chameleon_sim_gatt_air_callback, gatt);
+    chameleon_rx_queue_set_overflow(
+        gatt->air, ChameleonRxOverflowBlock, CHAMELEON_SIM_GATT_AIR_TIMEOUT_MS);
+
+    chameleon_sim_set_output_callback(sim, chameleon_sim_gatt_output_callback, gatt);
+
+    return gatt;
+}
+
+void chameleon_sim_gatt_free(ChameleonSimGatt* gatt) {
+    furi_assert(gatt);
+
+    furi_timer_stop(gatt->update_timer);
+    furi_timer_free(gatt->update_timer);
+    chameleon_rx_queue_free(gatt->air);
+    furi_mutex_free(gatt->mutex);
+    free(gatt);
+}
+
+void chameleon_sim_gatt_get_stats(ChameleonSimGatt* gatt, ChameleonSimGattStats* stats) {
+    furi_assert(gatt);
+    furi_assert(stats);
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    *stats = gatt->stats;
+    furi_mutex_release(gatt->mutex);
+}
+
+static void chameleon_sim_gatt_set_event_callback(
+    void* instance,
+    BleHandlerBackendEventCallback callback,
+    void* context) {
+    ChameleonSimGatt* gatt = instance;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    gatt->callback = callback;
+    gatt->context = context;
+    furi_mutex_release(gatt->mutex);
+}
+
+// The one advertiser is reported with its next advertisement
+static bool chameleon_sim_gatt_start_scan(void* instance) {
+    ChameleonSimGatt* gatt = instance;
+
+    furi_delay_ms(CHAMELEON_SIM_GATT_ADV_INTERVAL_MS);
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    BleHandlerBackendEventCallback callback = gatt->callback;
+    void* context = gatt->context;
+    furi_mutex_release(gatt->mutex);
+
+    if(callback) {
+        BleHandlerBackendEvent event = {
+            .type = BleHandlerBackendEventAdvertisement,
+            .mac = chameleon_sim_gatt_mac,
+            .rssi = CHAMELEON_SIM_GATT_RSSI,
+            .name = CHAMELEON_SIM_GATT_NAME,
+        };
+        callback(&event, context);
+    }
+
+    return true;
+}
+
+static void chameleon_sim_gatt_stop_scan(void* instance) {
+    UNUSED(instance);
+}
+
+static bool chameleon_sim_gatt_connect(
+    void* instance,
+    const uint8_t* mac,
+    const BleHandlerGattService* service,
+    BleHandlerGattHandles* handles,
+    bool known,
+    uint32_t timeout_ms) {
+    UNUSED(service);
+    UNUSED(timeout_ms);
+    ChameleonSimGatt* gatt = instance;
+
+    if(memcmp(mac, chameleon_sim_gatt_mac, sizeof(chameleon_sim_gatt_mac)) != 0) {
+        return false;
+    }
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    bool connected = gatt->connected;
+    gatt->connected = true;
+    gatt->notify = false;
+    gatt->att_mtu = BLE_HANDLER_ATT_MTU_DEFAULT;
+    furi_mutex_release(gatt->mutex);
+
+    if(connected) return false;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    gatt->interval = CHAMELEON_SIM_GATT_INTERVAL_DEFAULT;
+    gatt->update_pending = false;
+    furi_mutex_release(gatt->mutex);
+
+    chameleon_sim_gatt_apply_interval(gatt, CHAMELEON_SIM_GATT_INTERVAL_DEFAULT);
+    chameleon_rx_queue_start(gatt->air);
+
+    // The connect request goes out on average half an advertising interval
+    // in, the link is up one connection event later
+    furi_delay_ms(CHAMELEON_SIM_GATT_ADV_INTERVAL_MS / 2);
+    chameleon_sim_gatt_wait_events(gatt, 1);
+
+    // Known handles are used as given, writes to wrong ones are rejected
+    if(!known) {
+        chameleon_sim_gatt_wait_events(gatt, CHAMELEON_SIM_GATT_DISCOVERY_EXCHANGES * 2);
+        handles->rx_value = CHAMELEON_SIM_GATT_RX_VALUE;
+        handles->tx_value = CHAMELEON_SIM_GATT_TX_VALUE;
+        handles->tx_cccd = CHAMELEON_SIM_GATT_TX_CCCD;
+    }
+
+    return true;
+}
+
+static void chameleon_sim_gatt_disconnect(void* instance) {
+    ChameleonSimGatt* gatt = instance;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    bool connected = gatt->connected;
+    gatt->connected = false;
+    gatt->notify = false;
+    gatt->update_pending = false;
+    furi_mutex_release(gatt->mutex);
+
+    if(connected) {
+        chameleon_rx_queue_stop(gatt->air);
+    }
+}
+
+static uint16_t chameleon_sim_gatt_exchange_mtu(void* instance, uint16_t client_mtu) {
+    ChameleonSimGatt* gatt = instance;
+
+    chameleon_sim_gatt_wait_events(gatt, 2);
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    gatt->att_mtu = MAX(MIN(client_mtu, gatt->peer_mtu), BLE_HANDLER_ATT_MTU_DEFAULT);
+    uint16_t att_mtu = gatt->att_mtu;
+    furi_mutex_release(gatt->mutex);
+
+    return att_mtu;
+}
+
+// The update takes effect a few connection events later, at its instant
+static bool
+    chameleon_sim_gatt_update_conn_params(void* instance, const BleHandlerConnParams* params) {
+    ChameleonSimGatt* gatt = instance;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+    bool accepted = gatt->connected && !gatt->update_pending &&
+                    params->interval_min >= 6 && params->interval_min <= params->interval_max;
+    uint32_t delay_ms = 0;
+    if(accepted) {
+        gatt->update_pending = true;
+        gatt->update = *params;
+        delay_ms = (CHAMELEON_SIM_GATT_UPDATE_EVENTS * gatt->interval * 5 + 3) / 4;
+    }
+    furi_mutex_release(gatt->mutex);
+
+    if(accepted) {
+        furi_timer_start(gatt->update_timer, delay_ms);
+    }
+
+    return accepted;
+}
+
+static bool chameleon_sim_gatt_write(
+    void* instance,
+    uint16_t handle,
+    const uint8_t* data,
+    size_t length,
+    bool with_response,
+    uint32_t timeout_ms) {
+    UNUSED(timeout_ms);
+    ChameleonSimGatt* gatt = instance;
+    bool accepted = false;
+
+    furi_mutex_acquire(gatt->mutex, FuriWaitForever);
+
+    if(!gatt->connected || length > (size_t)gatt->att_mtu - BLE_HANDLER_ATT_HEADER_LEN) {
+        gatt->stats.rejected++;
+    } else if(handle == CHAMELEON_SIM_GATT_TX_CCCD && with_response && length == 2) {
+        gatt->notify = data[0] & 0x01;
+        gatt->stats.writes_with_response++;
+        accepted = true;
+    } else if(handle == CHAMELEON_SIM_GATT_RX_VALUE && !with_response) {
+        gatt->stats.writes++;
+        accepted = true;
+    } else {
+        gatt->stats.rejected++;
+    }
+
+    furi_mutex_release(gatt->mutex);
+
+    if(with_response) {
+        chameleon_sim_gatt_wait_events(gatt, 2);
+    }
+
+    if(!accepted) {
+        FURI_LOG_W(TAG, "Rejected write of %zu bytes to 0x%04X", length, handle);
+        return false;
+    }
+
+    if(handle == CHAMELEON_SIM_GATT_RX_VALUE) {
+        chameleon_rx_queue_push(gatt->air, data, length);
+    }
+
+    return true;
+}
+
+const BleHandlerBackend chameleon_sim_gatt_backend = {
+    .name = "Simulator",
+    .set_event_callback = chameleon_sim_gatt_set_event_callback,
+    .start_scan = chameleon_sim_gatt_start_scan,
+    .stop_scan = chameleon_sim_gatt_stop_scan,
+    .connect = chameleon_sim_gatt_connect,
+    .disconnect = chameleon_sim_gatt_disconnect,
+    .exchange_mtu = chameleon_sim_gatt_exchange_mtu,
+    .update_conn_params = chameleon_sim_gatt_update_conn_params,
+    .write = chameleon_sim_gatt_write,
+};
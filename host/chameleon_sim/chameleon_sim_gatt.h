@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ble_handler.h"
+#include "chameleon_sim.h"
+
+// Advertised name of the simulated peripheral
+#define CHAMELEON_SIM_GATT_NAME "ChameleonUltra"
+
+// Bytes written by the client and not yet seen by the simulator
+#define CHAMELEON_SIM_GATT_AIR_SIZE 2048
+
+// Connection interval a new connection starts with, 1.25 ms units
+#define CHAMELEON_SIM_GATT_INTERVAL_DEFAULT 24
+
+// Connection events between a parameter update request and its instant
+#define CHAMELEON_SIM_GATT_UPDATE_EVENTS 6
+
+// Time between advertisements, a scan or a direct connect waits for one
+#define CHAMELEON_SIM_GATT_ADV_INTERVAL_MS 100
+
+// Request/response exchanges of discovering the UART service, its
+// characteristics and the CCCD, two connection events each
+#define CHAMELEON_SIM_GATT_DISCOVERY_EXCHANGES 6
+
+// GATT peripheral in front of the simulator
+//
+// A BleHandlerBackend that advertises one Chameleon, exposes its UART
+// service and checks what the client does with it: writes must fit the
+// negotiated MTU and notifications only flow once enabled. Writes reach the
+// simulator on a worker thread, responses come back as notifications of at
+// most MTU - 3 bytes. Scanning, connecting, discovery and requests that
+// wait for a response take the time they take over the air. The connection
+// interval is the simulator's link
+// latency, parameter updates change it after CHAMELEON_SIM_GATT_UPDATE_EVENTS
+// connection events. Takes over the simulator's output callback.
+typedef struct ChameleonSimGatt ChameleonSimGatt;
+
+// Peripheral counters since alloc
+typedef struct {
+    uint32_t writes; // Write without response packets to the RX characteristic
+    uint32_t writes_with_response;
+    uint32_t rejected; // Writes longer than the MTU allows, or to unknown handles
+    uint32_t notifications;
+    uint32_t conn_updates;
+} ChameleonSimGattStats;
+
+// Create and destroy peripheral, att_mtu is the largest MTU it accepts
+ChameleonSimGatt* chameleon_sim_gatt_alloc(ChameleonSim* sim, uint16_t att_mtu);
+void chameleon_sim_gatt_free(ChameleonSimGatt* gatt);
+
+void chameleon_sim_gatt_get_stats(ChameleonSimGatt* gatt, ChameleonSimGattStats* stats);
+
+// Backend operations, the instance is a ChameleonSimGatt
+extern const BleHandlerBackend chameleon_sim_gatt_backend;
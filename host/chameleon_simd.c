@@ -0,0 +1,190 @@
+#define _GNU_SOURCE
+
+// Chameleon Ultra simulator on a pseudo terminal
+//
+// Creates a PTY, prints the path of its serial side and answers frames
+// written to it like a device on a USB CDC port would.
+
+#include "chameleon_sim.h"
+#include <furi.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define SIMD_READ_SIZE 512
+#define SIMD_POLL_MS 200
+
+static volatile sig_atomic_t simd_running = 1;
+
+static void simd_signal(int signal) {
+    UNUSED(signal);
+    simd_running = 0;
+}
+
+static void simd_usage(const char* name) {
+    fprintf(
+        stderr,
+        "usage: %s [-s service_us] [-l latency_us] [-j jitter_us] [-f fragment_max]\n"
+        "          [-e bit_error_ppm] [-r seed] [-L link]\n"
+        "\n"
+        "  -s  device time per request\n"
+        "  -l  delay of each response frame\n"
+        "  -j  random extra delay up to this value\n"
+        "  -f  deliver responses in chunks of 1..fragment_max bytes\n"
+        "  -e  flipped bits per million, both directions\n"
+        "  -r  random seed\n"
+        "  -L  symlink to create for the serial side\n",
+        name);
+}
+
+static void simd_output_callback(const uint8_t* data, size_t length, void* context) {
+    int fd = *(int*)context;
+
+    while(length) {
+        ssize_t written = write(fd, data, length);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN) {
+                // Nobody is reading, give the client a moment
+                struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+                poll(&pfd, 1, SIMD_POLL_MS);
+                continue;
+            }
+            fprintf(stderr, "write: %s\n", strerror(errno));
+            return;
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+static int simd_open_pty(char* path, size_t path_size) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ||
+       ptsname_r(master, path, path_size) != 0) {
+        fprintf(stderr, "pty: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // Raw bytes, no echo or line discipline
+    struct termios tio;
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+
+    return master;
+}
+
+static uint32_t simd_parse(const char* arg, const char* name) {
+    char* end;
+    unsigned long value = strtoul(arg, &end, 0);
+    if(*arg == '\0' || *end != '\0' || value > UINT32_MAX) {
+        fprintf(stderr, "invalid %s: %s\n", name, arg);
+        exit(2);
+    }
+    return value;
+}
+
+int main(int argc, char* argv[]) {
+    ChameleonSimLink link = {0};
+    const char* link_path = NULL;
+    int option;
+
+    while((option = getopt(argc, argv, "s:l:j:f:e:r:L:h")) != -1) {
+        switch(option) {
+        case 's':
+            link.service_us = simd_parse(optarg, "service time");
+            break;
+        case 'l':
+            link.latency_us = simd_parse(optarg, "latency");
+            break;
+        case 'j':
+            link.jitter_us = simd_parse(optarg, "jitter");
+            break;
+        case 'f':
+            link.fragment_max = MIN(simd_parse(optarg, "fragment size"), UINT16_MAX);
+            break;
+        case 'e':
+            link.bit_error_ppm = simd_parse(optarg, "bit error rate");
+            break;
+        case 'r':
+            link.seed = simd_parse(optarg, "seed");
+            break;
+        case 'L':
+            link_path = optarg;
+            break;
+        default:
+            simd_usage(argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+
+    char path[64];
+    int master = simd_open_pty(path, sizeof(path));
+    if(master < 0) return 1;
+
+    // Hold the serial side open so the PTY survives clients closing it
+    int slave = open(path, O_RDWR | O_NOCTTY);
+    if(slave < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    if(link_path) {
+        unlink(link_path);
+        if(symlink(path, link_path) != 0) {
+            fprintf(stderr, "%s: %s\n", link_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    signal(SIGINT, simd_signal);
+    signal(SIGTERM, simd_signal);
+
+    ChameleonSim* sim = chameleon_sim_alloc();
+    chameleon_sim_set_link(sim, &link);
+    chameleon_sim_set_output_callback(sim, simd_output_callback, &master);
+
+    printf("%s\n", link_path ? link_path : path);
+    fflush(stdout);
+
+    uint8_t buffer[SIMD_READ_SIZE];
+    while(simd_running) {
+        struct pollfd pfd = {.fd = master, .events = POLLIN};
+        if(poll(&pfd, 1, SIMD_POLL_MS) <= 0) continue;
+
+        ssize_t length = read(master, buffer, sizeof(buffer));
+        if(length > 0) {
+            chameleon_sim_feed(sim, buffer, length);
+        } else if(length < 0 && errno != EAGAIN && errno != EINTR) {
+            fprintf(stderr, "read: %s\n", strerror(errno));
+            break;
+        }
+    }
+
+    ChameleonSimStats stats;
+    chameleon_sim_get_stats(sim, &stats);
+    fprintf(
+        stderr,
+        "requests %u, rx errors %u, unsupported %u, responses %u, dropped %u, bit errors %u\n",
+        stats.requests,
+        stats.rx_errors,
+        stats.unsupported,
+        stats.responses,
+        stats.dropped,
+        stats.bit_errors);
+
+    chameleon_sim_free(sim);
+    if(link_path) unlink(link_path);
+    close(slave);
+    close(master);
+
+    return 0;
+}
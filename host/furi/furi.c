@@ -0,0 +1,639 @@
+#define _GNU_SOURCE
+
+#include "furi.h"
+#include "furi_hal.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+// Kernel
+
+static uint64_t furi_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Absolute CLOCK_MONOTONIC deadline for pthread_cond_timedwait
+static struct timespec furi_deadline(uint32_t timeout_ms) {
+    uint64_t deadline = furi_monotonic_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    struct timespec ts = {
+        .tv_sec = deadline / 1000000000ULL,
+        .tv_nsec = deadline % 1000000000ULL,
+    };
+    return ts;
+}
+
+static void furi_cond_init(pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+// Wait on cond until woken or the deadline passes, false on timeout
+static bool furi_cond_wait(
+    pthread_cond_t* cond,
+    pthread_mutex_t* mutex,
+    uint32_t timeout,
+    const struct timespec* deadline) {
+    if(timeout == FuriWaitForever) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+uint32_t furi_get_tick(void) {
+    return (uint32_t)(furi_monotonic_ns() / 1000000ULL);
+}
+
+void furi_delay_ms(uint32_t milliseconds) {
+    furi_delay_us(milliseconds * 1000);
+}
+
+void furi_delay_us(uint32_t microseconds) {
+    struct timespec ts = {
+        .tv_sec = microseconds / 1000000,
+        .tv_nsec = (microseconds % 1000000) * 1000L,
+    };
+    while(nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+    }
+}
+
+static pthread_mutex_t furi_critical_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void furi_critical_enter(void) {
+    pthread_mutex_lock(&furi_critical_mutex);
+}
+
+void furi_critical_exit(void) {
+    pthread_mutex_unlock(&furi_critical_mutex);
+}
+
+// Hal
+
+const DWT_Type* furi_hal_dwt(void) {
+    static __thread DWT_Type dwt;
+    dwt.CYCCNT =
+        (uint32_t)(furi_monotonic_ns() * FURI_HAL_CORTEX_INSTRUCTIONS_PER_MICROSECOND / 1000);
+    return &dwt;
+}
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return FURI_HAL_CORTEX_INSTRUCTIONS_PER_MICROSECOND;
+}
+
+// Mutex
+
+struct FuriMutex {
+    pthread_mutex_t mutex;
+};
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    FuriMutex* instance = malloc(sizeof(FuriMutex));
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(
+        &attr, type == FuriMutexTypeRecursive ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_ERRORCHECK);
+    pthread_mutex_init(&instance->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    return instance;
+}
+
+void furi_mutex_free(FuriMutex* instance) {
+    furi_assert(instance);
+    pthread_mutex_destroy(&instance->mutex);
+    free(instance);
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* instance, uint32_t timeout) {
+    furi_assert(instance);
+
+    int result;
+    if(timeout == FuriWaitForever) {
+        result = pthread_mutex_lock(&instance->mutex);
+    } else if(timeout == 0) {
+        result = pthread_mutex_trylock(&instance->mutex);
+    } else {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = deadline.tv_nsec + (uint64_t)timeout * 1000000ULL;
+        deadline.tv_sec += ns / 1000000000ULL;
+        deadline.tv_nsec = ns % 1000000000ULL;
+        result = pthread_mutex_timedlock(&instance->mutex, &deadline);
+    }
+
+    // Relocking a normal mutex deadlocks on the device, fail loudly instead
+    furi_check(result != EDEADLK);
+
+    return result == 0 ? FuriStatusOk : FuriStatusErrorTimeout;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* instance) {
+    furi_assert(instance);
+    furi_check(pthread_mutex_unlock(&instance->mutex) == 0);
+    return FuriStatusOk;
+}
+
+// Semaphore
+
+struct FuriSemaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint32_t count;
+    uint32_t max_count;
+};
+
+FuriSemaphore* furi_semaphore_alloc(uint32_t max_count, uint32_t initial_count) {
+    furi_assert(max_count > 0 && initial_count <= max_count);
+
+    FuriSemaphore* instance = malloc(sizeof(FuriSemaphore));
+    pthread_mutex_init(&instance->mutex, NULL);
+    furi_cond_init(&instance->cond);
+    instance->count = initial_count;
+    instance->max_count = max_count;
+
+    return instance;
+}
+
+void furi_semaphore_free(FuriSemaphore* instance) {
+    furi_assert(instance);
+    pthread_cond_destroy(&instance->cond);
+    pthread_mutex_destroy(&instance->mutex);
+    free(instance);
+}
+
+FuriStatus furi_semaphore_acquire(FuriSemaphore* instance, uint32_t timeout) {
+    furi_assert(instance);
+
+    struct timespec deadline = furi_deadline(timeout == FuriWaitForever ? 0 : timeout);
+    FuriStatus status = FuriStatusOk;
+
+    pthread_mutex_lock(&instance->mutex);
+    while(instance->count == 0) {
+        if(timeout == 0 || !furi_cond_wait(&instance->cond, &instance->mutex, timeout, &deadline)) {
+            status = FuriStatusErrorTimeout;
+            break;
+        }
+    }
+    if(status == FuriStatusOk) {
+        instance->count--;
+    }
+    pthread_mutex_unlock(&instance->mutex);
+
+    return status;
+}
+
+FuriStatus furi_semaphore_release(FuriSemaphore* instance) {
+    furi_assert(instance);
+
+    FuriStatus status = FuriStatusErrorResource;
+
+    pthread_mutex_lock(&instance->mutex);
+    if(instance->count < instance->max_count) {
+        instance->count++;
+        pthread_cond_signal(&instance->cond);
+        status = FuriStatusOk;
+    }
+    pthread_mutex_unlock(&instance->mutex);
+
+    return status;
+}
+
+uint32_t furi_semaphore_get_count(FuriSemaphore* instance) {
+    furi_assert(instance);
+
+    pthread_mutex_lock(&instance->mutex);
+    uint32_t count = instance->count;
+    pthread_mutex_unlock(&instance->mutex);
+
+    return count;
+}
+
+// Timer
+
+struct FuriTimer {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    FuriTimerCallback callback;
+    void* context;
+    FuriTimerType type;
+    uint64_t period_ns;
+    uint64_t due_ns;
+    bool armed;
+    bool quit;
+};
+
+static void* furi_timer_thread(void* arg) {
+    FuriTimer* instance = arg;
+
+    pthread_mutex_lock(&instance->mutex);
+    while(!instance->quit) {
+        if(!instance->armed) {
+            pthread_cond_wait(&instance->cond, &instance->mutex);
+            continue;
+        }
+
+        uint64_t now = furi_monotonic_ns();
+        if(now < instance->due_ns) {
+            struct timespec ts = {
+                .tv_sec = instance->due_ns / 1000000000ULL,
+                .tv_nsec = instance->due_ns % 1000000000ULL,
+            };
+            pthread_cond_timedwait(&instance->cond, &instance->mutex, &ts);
+            continue;
+        }
+
+        if(instance->type == FuriTimerTypePeriodic) {
+            instance->due_ns += instance->period_ns;
+        } else {
+            instance->armed = false;
+        }
+
+        // Callbacks may restart or stop the timer
+        pthread_mutex_unlock(&instance->mutex);
+        instance->callback(instance->context);
+        pthread_mutex_lock(&instance->mutex);
+    }
+    pthread_mutex_unlock(&instance->mutex);
+
+    return NULL;
+}
+
+FuriTimer* furi_timer_alloc(FuriTimerCallback func, FuriTimerType type, void* context) {
+    furi_assert(func);
+
+    FuriTimer* instance = malloc(sizeof(FuriTimer));
+    memset(instance, 0, sizeof(FuriTimer));
+    instance->callback = func;
+    instance->context = context;
+    instance->type = type;
+    pthread_mutex_init(&instance->mutex, NULL);
+    furi_cond_init(&instance->cond);
+    pthread_create(&instance->thread, NULL, furi_timer_thread, instance);
+
+    return instance;
+}
+
+void furi_timer_free(FuriTimer* instance) {
+    furi_assert(instance);
+
+    pthread_mutex_lock(&instance->mutex);
+    instance->quit = true;
+    pthread_cond_signal(&instance->cond);
+    pthread_mutex_unlock(&instance->mutex);
+
+    pthread_join(instance->thread, NULL);
+    pthread_cond_destroy(&instance->cond);
+    pthread_mutex_destroy(&instance->mutex);
+    free(instance);
+}
+
+FuriStatus furi_timer_start(FuriTimer* instance, uint32_t ticks) {
+    furi_assert(instance);
+
+    pthread_mutex_lock(&instance->mutex);
+    instance->period_ns = (uint64_t)ticks * 1000000ULL;
+    instance->due_ns = furi_monotonic_ns() + instance->period_ns;
+    instance->armed = true;
+    pthread_cond_signal(&instance->cond);
+    pthread_mutex_unlock(&instance->mutex);
+
+    return FuriStatusOk;
+}
+
+FuriStatus furi_timer_restart(FuriTimer* instance, uint32_t ticks) {
+    return furi_timer_start(instance, ticks);
+}
+
+FuriStatus furi_timer_stop(FuriTimer* instance) {
+    furi_assert(instance);
+
+    pthread_mutex_lock(&instance->mutex);
+    instance->armed = false;
+    pthread_cond_signal(&instance->cond);
+    pthread_mutex_unlock(&instance->mutex);
+
+    return FuriStatusOk;
+}
+
+uint32_t furi_timer_is_running(FuriTimer* instance) {
+    furi_assert(instance);
+
+    pthread_mutex_lock(&instance->mutex);
+    bool armed = instance->armed;
+    pthread_mutex_unlock(&instance->mutex);
+
+    return armed;
+}
+
+// Thread
+
+struct FuriThread {
+    pthread_t thread;
+    FuriThreadCallback callback;
+    void* context;
+    int32_t return_code;
+    bool started;
+
+    pthread_mutex_t flags_mutex;
+    pthread_cond_t flags_cond;
+    uint32_t flags;
+};
+
+static __thread FuriThread* furi_thread_current;
+
+static void furi_thread_init(FuriThread* thread) {
+    memset(thread, 0, sizeof(FuriThread));
+    pthread_mutex_init(&thread->flags_mutex, NULL);
+    furi_cond_init(&thread->flags_cond);
+}
+
+static void* furi_thread_body(void* arg) {
+    FuriThread* thread = arg;
+    furi_thread_current = thread;
+    thread->return_code = thread->callback(thread->context);
+    return NULL;
+}
+
+FuriThread* furi_thread_alloc(void) {
+    FuriThread* thread = malloc(sizeof(FuriThread));
+    furi_thread_init(thread);
+    return thread;
+}
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context) {
+    FuriThread* thread = furi_thread_alloc();
+    furi_thread_set_name(thread, name);
+    furi_thread_set_stack_size(thread, stack_size);
+    furi_thread_set_callback(thread, callback);
+    furi_thread_set_context(thread, context);
+    return thread;
+}
+
+void furi_thread_free(FuriThread* thread) {
+    furi_assert(thread);
+    furi_assert(!thread->started);
+
+    pthread_cond_destroy(&thread->flags_cond);
+    pthread_mutex_destroy(&thread->flags_mutex);
+    free(thread);
+}
+
+void furi_thread_set_name(FuriThread* thread, const char* name) {
+    furi_assert(thread);
+    UNUSED(name);
+}
+
+void furi_thread_set_stack_size(FuriThread* thread, size_t stack_size) {
+    furi_assert(thread);
+    UNUSED(stack_size);
+}
+
+void furi_thread_set_context(FuriThread* thread, void* context) {
+    furi_assert(thread);
+    thread->context = context;
+}
+
+void furi_thread_set_callback(FuriThread* thread, FuriThreadCallback callback) {
+    furi_assert(thread);
+    thread->callback = callback;
+}
+
+void furi_thread_start(FuriThread* thread) {
+    furi_assert(thread);
+    furi_assert(thread->callback);
+    furi_assert(!thread->started);
+
+    thread->started = true;
+    furi_check(pthread_create(&thread->thread, NULL, furi_thread_body, thread) == 0);
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    furi_assert(thread);
+
+    if(thread->started) {
+        pthread_join(thread->thread, NULL);
+        thread->started = false;
+    }
+
+    return true;
+}
+
+int32_t furi_thread_get_return_code(FuriThread* thread) {
+    furi_assert(thread);
+    return thread->return_code;
+}
+
+FuriThreadId furi_thread_get_id(FuriThread* thread) {
+    furi_assert(thread);
+    return thread;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    // Threads not started through furi, like main, get a record on first use
+    if(!furi_thread_current) {
+        furi_thread_current = furi_thread_alloc();
+    }
+
+    return furi_thread_current;
+}
+
+uint32_t furi_thread_flags_set(FuriThreadId thread_id, uint32_t flags) {
+    furi_assert(thread_id);
+
+    pthread_mutex_lock(&thread_id->flags_mutex);
+    thread_id->flags |= flags;
+    uint32_t result = thread_id->flags;
+    pthread_cond_broadcast(&thread_id->flags_cond);
+    pthread_mutex_unlock(&thread_id->flags_mutex);
+
+    return result;
+}
+
+uint32_t furi_thread_flags_clear(uint32_t flags) {
+    FuriThread* thread = furi_thread_get_current_id();
+
+    pthread_mutex_lock(&thread->flags_mutex);
+    uint32_t result = thread->flags;
+    thread->flags &= ~flags;
+    pthread_mutex_unlock(&thread->flags_mutex);
+
+    return result;
+}
+
+uint32_t furi_thread_flags_get(void) {
+    FuriThread* thread = furi_thread_get_current_id();
+
+    pthread_mutex_lock(&thread->flags_mutex);
+    uint32_t result = thread->flags;
+    pthread_mutex_unlock(&thread->flags_mutex);
+
+    return result;
+}
+
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout) {
+    FuriThread* thread = furi_thread_get_current_id();
+    struct timespec deadline = furi_deadline(timeout == FuriWaitForever ? 0 : timeout);
+    uint32_t result;
+
+    pthread_mutex_lock(&thread->flags_mutex);
+    while(true) {
+        uint32_t set = thread->flags & flags;
+        bool done = (options & FuriFlagWaitAll) ? set == flags : set != 0;
+        if(done) {
+            result = set;
+            if(!(options & FuriFlagNoClear)) {
+                thread->flags &= ~set;
+            }
+            break;
+        }
+
+        if(timeout == 0 ||
+           !furi_cond_wait(&thread->flags_cond, &thread->flags_mutex, timeout, &deadline)) {
+            result = FuriFlagErrorTimeout;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&thread->flags_mutex);
+
+    return result;
+}
+
+// Stream buffer
+
+struct FuriStreamBuffer {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    uint8_t* data;
+    size_t size;
+    size_t head;
+    size_t count;
+    size_t trigger_level;
+};
+
+FuriStreamBuffer* furi_stream_buffer_alloc(size_t size, size_t trigger_level) {
+    furi_assert(size > 0);
+
+    FuriStreamBuffer* stream_buffer = malloc(sizeof(FuriStreamBuffer));
+    memset(stream_buffer, 0, sizeof(FuriStreamBuffer));
+    stream_buffer->data = malloc(size);
+    stream_buffer->size = size;
+    stream_buffer->trigger_level = MAX(trigger_level, (size_t)1);
+    pthread_mutex_init(&stream_buffer->mutex, NULL);
+    furi_cond_init(&stream_buffer->cond);
+
+    return stream_buffer;
+}
+
+void furi_stream_buffer_free(FuriStreamBuffer* stream_buffer) {
+    furi_assert(stream_buffer);
+
+    pthread_cond_destroy(&stream_buffer->cond);
+    pthread_mutex_destroy(&stream_buffer->mutex);
+    free(stream_buffer->data);
+    free(stream_buffer);
+}
+
+size_t furi_stream_buffer_send(
+    FuriStreamBuffer* stream_buffer,
+    const void* data,
+    size_t length,
+    uint32_t timeout) {
+    furi_assert(stream_buffer);
+    furi_assert(data);
+
+    struct timespec deadline = furi_deadline(timeout == FuriWaitForever ? 0 : timeout);
+    size_t wanted = MIN(length, stream_buffer->size);
+
+    pthread_mutex_lock(&stream_buffer->mutex);
+
+    // Like FreeRTOS, wait for room for the whole write, then write what fits
+    while(stream_buffer->size - stream_buffer->count < wanted && timeout != 0) {
+        if(!furi_cond_wait(&stream_buffer->cond, &stream_buffer->mutex, timeout, &deadline)) break;
+    }
+
+    size_t written = MIN(length, stream_buffer->size - stream_buffer->count);
+    for(size_t i = 0; i < written; i++) {
+        size_t tail = (stream_buffer->head + stream_buffer->count + i) % stream_buffer->size;
+        stream_buffer->data[tail] = ((const uint8_t*)data)[i];
+    }
+    stream_buffer->count += written;
+
+    if(written) pthread_cond_broadcast(&stream_buffer->cond);
+    pthread_mutex_unlock(&stream_buffer->mutex);
+
+    return written;
+}
+
+size_t furi_stream_buffer_receive(
+    FuriStreamBuffer* stream_buffer,
+    void* data,
+    size_t length,
+    uint32_t timeout) {
+    furi_assert(stream_buffer);
+    furi_assert(data);
+
+    struct timespec deadline = furi_deadline(timeout == FuriWaitForever ? 0 : timeout);
+
+    pthread_mutex_lock(&stream_buffer->mutex);
+
+    while(stream_buffer->count < stream_buffer->trigger_level && timeout != 0) {
+        if(!furi_cond_wait(&stream_buffer->cond, &stream_buffer->mutex, timeout, &deadline)) break;
+    }
+
+    size_t received = MIN(length, stream_buffer->count);
+    for(size_t i = 0; i < received; i++) {
+        ((uint8_t*)data)[i] = stream_buffer->data[(stream_buffer->head + i) % stream_buffer->size];
+    }
+    stream_buffer->head = (stream_buffer->head + received) % stream_buffer->size;
+    stream_buffer->count -= received;
+
+    if(received) pthread_cond_broadcast(&stream_buffer->cond);
+    pthread_mutex_unlock(&stream_buffer->mutex);
+
+    return received;
+}
+
+size_t furi_stream_buffer_bytes_available(FuriStreamBuffer* stream_buffer) {
+    furi_assert(stream_buffer);
+
+    pthread_mutex_lock(&stream_buffer->mutex);
+    size_t count = stream_buffer->count;
+    pthread_mutex_unlock(&stream_buffer->mutex);
+
+    return count;
+}
+
+size_t furi_stream_buffer_spaces_available(FuriStreamBuffer* stream_buffer) {
+    furi_assert(stream_buffer);
+
+    pthread_mutex_lock(&stream_buffer->mutex);
+    size_t spaces = stream_buffer->size - stream_buffer->count;
+    pthread_mutex_unlock(&stream_buffer->mutex);
+
+    return spaces;
+}
+
+FuriStatus furi_stream_buffer_reset(FuriStreamBuffer* stream_buffer) {
+    furi_assert(stream_buffer);
+
+    pthread_mutex_lock(&stream_buffer->mutex);
+    stream_buffer->head = 0;
+    stream_buffer->count = 0;
+    pthread_cond_broadcast(&stream_buffer->cond);
+    pthread_mutex_unlock(&stream_buffer->mutex);
+
+    return FuriStatusOk;
+}
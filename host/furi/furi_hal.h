@@ -0,0 +1,19 @@
+#pragma once
+
+// Hardware pieces of the furi shim, only what the libraries time themselves with
+
+#include "furi.h"
+
+// Cycles per microsecond of the emulated Cortex-M4 core, as on a 64 MHz Flipper
+#define FURI_HAL_CORTEX_INSTRUCTIONS_PER_MICROSECOND 64
+
+// DWT cycle counter, CYCCNT reads the monotonic clock scaled to core cycles
+// and wraps like the hardware counter
+typedef struct {
+    uint32_t CYCCNT;
+} DWT_Type;
+
+const DWT_Type* furi_hal_dwt(void);
+#define DWT (furi_hal_dwt())
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
@@ -0,0 +1,400 @@
+#define _GNU_SOURCE
+
+#include "serial_handler.h"
+#include <furi.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define TAG "SerialHandler"
+
+struct SerialHandler {
+    int fd; // -1 while closed
+    int wake_pipe[2]; // Wakes the RX thread out of poll to stop it
+
+    FuriThread* rx_thread; // Reads the fd into rx_queue
+    ChameleonRxQueue* rx_queue; // Runs the rx callback on its worker thread
+
+    FuriMutex* mutex; // Keeps frames from different senders contiguous, guards below
+    uint32_t tx_bytes;
+    bool hung_up; // The other end went away, reads and writes fail until reopened
+
+    bool running;
+};
+
+static void serial_handler_hang_up(SerialHandler* handler) {
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->hung_up = true;
+    furi_mutex_release(handler->mutex);
+
+    FURI_LOG_W(TAG, "Device hung up");
+}
+
+// Read until the fd is empty, false once the other end is gone
+static bool serial_handler_rx_drain(SerialHandler* handler) {
+    uint8_t buffer[SERIAL_READ_SIZE];
+
+    while(true) {
+        ssize_t received = read(handler->fd, buffer, sizeof(buffer));
+        if(received > 0) {
+            FURI_LOG_D(TAG, "Received %zd bytes", received);
+            chameleon_rx_queue_push(handler->rx_queue, buffer, received);
+        } else if(received < 0 && errno == EINTR) {
+            continue;
+        } else if(received < 0 && errno == EAGAIN) {
+            return true;
+        } else {
+            // EOF, or EIO from a tty whose other side closed
+            return false;
+        }
+    }
+}
+
+static int32_t serial_handler_rx_thread(void* context) {
+    SerialHandler* handler = context;
+    struct pollfd fds[] = {
+        {.fd = handler->fd, .events = POLLIN},
+        {.fd = handler->wake_pipe[0], .events = POLLIN},
+    };
+
+    FURI_LOG_I(TAG, "RX thread started");
+
+    while(true) {
+        if(poll(fds, COUNT_OF(fds), -1) < 0) {
+            if(errno == EINTR) continue;
+            FURI_LOG_E(TAG, "poll: %s", strerror(errno));
+            break;
+        }
+
+        if(fds[1].revents) break;
+
+        bool open = true;
+        if(fds[0].revents & POLLIN) {
+            open = serial_handler_rx_drain(handler);
+        } else if(fds[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+            open = false;
+        }
+
+        // Only the stop request is left to wait for, a negative fd is skipped by poll
+        if(!open) {
+            serial_handler_hang_up(handler);
+            fds[0].fd = -1;
+        }
+    }
+
+    FURI_LOG_I(TAG, "RX thread stopped");
+    return 0;
+}
+
+SerialHandler* serial_handler_alloc() {
+    SerialHandler* handler = malloc(sizeof(SerialHandler));
+    memset(handler, 0, sizeof(SerialHandler));
+
+    handler->fd = -1;
+    furi_check(pipe2(handler->wake_pipe, O_NONBLOCK | O_CLOEXEC) == 0);
+
+    handler->rx_queue = chameleon_rx_queue_alloc(SERIAL_RX_BUFFER_SIZE, "SerialRxWorker");
+    chameleon_rx_queue_set_overflow(
+        handler->rx_queue, ChameleonRxOverflowBlock, SERIAL_RX_BLOCK_TIMEOUT_MS);
+
+    handler->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+
+    return handler;
+}
+
+void serial_handler_free(SerialHandler* handler) {
+    furi_assert(handler);
+
+    serial_handler_close(handler);
+
+    furi_mutex_free(handler->mutex);
+    chameleon_rx_queue_free(handler->rx_queue);
+    close(handler->wake_pipe[0]);
+    close(handler->wake_pipe[1]);
+    free(handler);
+}
+
+bool serial_handler_open(SerialHandler* handler, const char* path) {
+    furi_assert(handler);
+    furi_assert(path);
+
+    int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if(fd < 0) {
+        FURI_LOG_E(TAG, "%s: %s", path, strerror(errno));
+        return false;
+    }
+
+    return serial_handler_open_fd(handler, fd);
+}
+
+bool serial_handler_open_fd(SerialHandler* handler, int fd) {
+    furi_assert(handler);
+    furi_assert(handler->fd < 0);
+    furi_assert(!handler->running);
+
+    int flags = fcntl(fd, F_GETFL);
+    if(flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        FURI_LOG_E(TAG, "fcntl: %s", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    // Raw 8N1 without flow control or line discipline, drop stale bytes
+    if(isatty(fd)) {
+        struct termios tio;
+        if(tcgetattr(fd, &tio) != 0) {
+            FURI_LOG_E(TAG, "tcgetattr: %s", strerror(errno));
+            close(fd);
+            return false;
+        }
+
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, SERIAL_BAUD_RATE);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~CRTSCTS;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+
+        if(tcsetattr(fd, TCSANOW, &tio) != 0) {
+            FURI_LOG_E(TAG, "tcsetattr: %s", strerror(errno));
+            close(fd);
+            return false;
+        }
+        tcflush(fd, TCIOFLUSH);
+    }
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->fd = fd;
+    handler->hung_up = false;
+    furi_mutex_release(handler->mutex);
+
+    FURI_LOG_I(TAG, "Opened fd %d", fd);
+    return true;
+}
+
+void serial_handler_close(SerialHandler* handler) {
+    furi_assert(handler);
+
+    if(handler->fd < 0) {
+        return;
+    }
+
+    serial_handler_stop_rx(handler);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    close(handler->fd);
+    handler->fd = -1;
+    furi_mutex_release(handler->mutex);
+
+    FURI_LOG_I(TAG, "Closed");
+}
+
+void serial_handler_set_rx_callback(
+    SerialHandler* handler,
+    SerialHandlerRxCallback callback,
+    void* context) {
+    furi_assert(handler);
+    chameleon_rx_queue_set_callback(handler->rx_queue, callback, context);
+}
+
+void serial_handler_set_overflow(
+    SerialHandler* handler,
+    ChameleonRxOverflow overflow,
+    uint32_t timeout_ms) {
+    furi_assert(handler);
+    furi_assert(!handler->running);
+    chameleon_rx_queue_set_overflow(handler->rx_queue, overflow, timeout_ms);
+}
+
+void serial_handler_get_rx_stats(SerialHandler* handler, ChameleonRxStats* stats) {
+    furi_assert(handler);
+    chameleon_rx_queue_get_stats(handler->rx_queue, stats);
+}
+
+bool serial_handler_send_segments(
+    SerialHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    furi_assert(handler);
+    furi_assert(header || header_len == 0);
+    furi_assert(payload || payload_len == 0);
+    furi_assert(trailer || trailer_len == 0);
+
+    struct iovec iov[3];
+    size_t iov_count = 0;
+    const uint8_t* segment_data[] = {header, payload, trailer};
+    const size_t segment_len[] = {header_len, payload_len, trailer_len};
+    for(size_t i = 0; i < COUNT_OF(segment_data); i++) {
+        if(segment_len[i]) {
+            iov[iov_count].iov_base = (void*)segment_data[i];
+            iov[iov_count].iov_len = segment_len[i];
+            iov_count++;
+        }
+    }
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+
+    if(handler->fd < 0 || handler->hung_up) {
+        furi_mutex_release(handler->mutex);
+        FURI_LOG_E(TAG, "Not connected");
+        return false;
+    }
+
+    // Write the whole frame, waiting for the fd to take more when it is full
+    struct iovec* next = iov;
+    bool sent = true;
+    while(iov_count) {
+        ssize_t written = writev(handler->fd, next, iov_count);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+
+            struct pollfd pfd = {.fd = handler->fd, .events = POLLOUT};
+            if(errno == EAGAIN && poll(&pfd, 1, SERIAL_TX_TIMEOUT_MS) > 0) continue;
+
+            FURI_LOG_E(TAG, "TX failed: %s", errno == EAGAIN ? "timeout" : strerror(errno));
+            sent = false;
+            break;
+        }
+
+        handler->tx_bytes += written;
+        while(iov_count && (size_t)written >= next->iov_len) {
+            written -= next->iov_len;
+            next++;
+            iov_count--;
+        }
+        if(iov_count) {
+            next->iov_base = (uint8_t*)next->iov_base + written;
+            next->iov_len -= written;
+        }
+    }
+
+    furi_mutex_release(handler->mutex);
+
+    return sent;
+}
+
+bool serial_handler_is_connected(SerialHandler* handler) {
+    furi_assert(handler);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool connected = handler->fd >= 0 && !handler->hung_up;
+    furi_mutex_release(handler->mutex);
+
+    return connected;
+}
+
+void serial_handler_start_rx(SerialHandler* handler) {
+    furi_assert(handler);
+
+    if(handler->running) {
+        FURI_LOG_W(TAG, "RX already running");
+        return;
+    }
+
+    if(handler->fd < 0) {
+        FURI_LOG_E(TAG, "Not open");
+        return;
+    }
+
+    handler->running = true;
+
+    // The worker has to be running before the first push
+    chameleon_rx_queue_start(handler->rx_queue);
+
+    handler->rx_thread = furi_thread_alloc();
+    furi_thread_set_name(handler->rx_thread, "SerialRxThread");
+    furi_thread_set_stack_size(handler->rx_thread, 2048);
+    furi_thread_set_context(handler->rx_thread, handler);
+    furi_thread_set_callback(handler->rx_thread, serial_handler_rx_thread);
+    furi_thread_start(handler->rx_thread);
+
+    FURI_LOG_I(TAG, "RX started");
+}
+
+void serial_handler_stop_rx(SerialHandler* handler) {
+    furi_assert(handler);
+
+    if(!handler->running) {
+        return;
+    }
+
+    handler->running = false;
+
+    uint8_t wake = 0;
+    furi_check(write(handler->wake_pipe[1], &wake, sizeof(wake)) == sizeof(wake));
+    furi_thread_join(handler->rx_thread);
+    furi_thread_free(handler->rx_thread);
+    handler->rx_thread = NULL;
+
+    // Leave the pipe empty for the next start
+    while(read(handler->wake_pipe[0], &wake, sizeof(wake)) > 0) {
+    }
+
+    chameleon_rx_queue_stop(handler->rx_queue);
+
+    FURI_LOG_I(TAG, "RX stopped");
+}
+
+static bool serial_handler_transport_send(
+    void* instance,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    return serial_handler_send_segments(
+        instance, header, header_len, payload, payload_len, trailer, trailer_len);
+}
+
+static void serial_handler_transport_start_rx(void* instance) {
+    serial_handler_start_rx(instance);
+}
+
+static void serial_handler_transport_stop_rx(void* instance) {
+    serial_handler_stop_rx(instance);
+}
+
+static void serial_handler_transport_set_rx_callback(
+    void* instance,
+    ChameleonTransportRxCallback callback,
+    void* context) {
+    serial_handler_set_rx_callback(instance, callback, context);
+}
+
+static size_t serial_handler_transport_get_mtu(void* instance) {
+    UNUSED(instance);
+    return SERIAL_READ_SIZE;
+}
+
+static void serial_handler_transport_get_stats(void* instance, ChameleonTransportStats* stats) {
+    SerialHandler* handler = instance;
+    ChameleonRxStats rx_stats;
+    serial_handler_get_rx_stats(handler, &rx_stats);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    stats->tx_bytes = handler->tx_bytes;
+    furi_mutex_release(handler->mutex);
+
+    stats->rx_bytes = rx_stats.received;
+    stats->rx_dropped = rx_stats.dropped;
+    stats->rx_high_water = rx_stats.high_water;
+}
+
+const ChameleonTransportInterface serial_handler_transport = {
+    .name = "Serial",
+    .send = serial_handler_transport_send,
+    .start_rx = serial_handler_transport_start_rx,
+    .stop_rx = serial_handler_transport_stop_rx,
+    .set_rx_callback = serial_handler_transport_set_rx_callback,
+    .get_mtu = serial_handler_transport_get_mtu,
+    .get_stats = serial_handler_transport_get_stats,
+};
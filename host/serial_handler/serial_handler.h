@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <termios.h>
+
+#include "chameleon_transport.h"
+#include "chameleon_rx_queue.h"
+
+// Line settings for real devices, USB CDC ports ignore the rate
+#define SERIAL_BAUD_RATE B115200
+
+#define SERIAL_RX_BUFFER_SIZE 1024
+
+// Bytes taken from the fd per read, one USB full speed packet
+#define SERIAL_READ_SIZE 64
+
+// Default time the reading side waits for room before dropping bytes
+#define SERIAL_RX_BLOCK_TIMEOUT_MS 50
+
+// Time to wait for the fd to take more bytes of a frame
+#define SERIAL_TX_TIMEOUT_MS 100
+
+// Serial transport for Linux host runs
+//
+// Talks to a tty (a Chameleon on /dev/ttyACM*, the serial side of
+// chameleon_simd) or any other byte stream fd. Received bytes go through
+// the same RX queue as uart_handler, frames are written straight to the fd.
+typedef struct SerialHandler SerialHandler;
+
+// Callback for received data, runs on the RX worker thread
+typedef void (*SerialHandlerRxCallback)(const uint8_t* data, size_t length, void* context);
+
+// Create and destroy serial handler
+SerialHandler* serial_handler_alloc();
+void serial_handler_free(SerialHandler* handler);
+
+// Open a device in raw mode, or take over an open fd. Ttys are switched to
+// raw 8N1, the fd is closed by serial_handler_close.
+bool serial_handler_open(SerialHandler* handler, const char* path);
+bool serial_handler_open_fd(SerialHandler* handler, int fd);
+void serial_handler_close(SerialHandler* handler);
+
+// Set receive callback
+void serial_handler_set_rx_callback(
+    SerialHandler* handler,
+    SerialHandlerRxCallback callback,
+    void* context);
+
+// Set the overflow policy of the RX buffer, call while RX is stopped
+void serial_handler_set_overflow(
+    SerialHandler* handler,
+    ChameleonRxOverflow overflow,
+    uint32_t timeout_ms);
+
+// Get receive counters
+void serial_handler_get_rx_stats(SerialHandler* handler, ChameleonRxStats* stats);
+
+// Write one frame given as header/payload/trailer segments (any may be empty),
+// returns once the fd has taken all of it
+bool serial_handler_send_segments(
+    SerialHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len);
+
+// Check whether a device is open and has not hung up
+bool serial_handler_is_connected(SerialHandler* handler);
+
+// Start/stop receiving
+void serial_handler_start_rx(SerialHandler* handler);
+void serial_handler_stop_rx(SerialHandler* handler);
+
+// Transport operations, the instance is a SerialHandler
+extern const ChameleonTransportInterface serial_handler_transport;
@@ -3,34 +3,376 @@
 #include <string.h>
 
 #define TAG "BleHandler"
-#define MAX_DEVICES 10
-#define DEVICE_NAME_MAX_LEN 32
+
+// MAC hash index, open addressing with linear probing, at most half full
+#define DEVICE_INDEX_SIZE (BLE_HANDLER_MAX_DEVICES * 2)
+#define DEVICE_INDEX_EMPTY 0xFF
+
+// Smoothed RSSI is kept in 1/8 dB, each advertisement moves it a quarter of
+// the way to the new reading
+#define RSSI_SCALE 8
+#define RSSI_WEIGHT_SHIFT 2
+
+// Advertised names start with this, "ChameleonUltra" or "ChameleonLite"
+#define BLE_DEVICE_NAME_PREFIX "Chameleon"
+
+// Nordic UART Service, 6E40000x-B5A3-F393-E0A9-E50E24DCCA9E
+#define BLE_NUS_UUID(x) \
+    {0x9E, 0xCA, 0xDC, 0x24, 0x0E, 0xE5, 0xA9, 0xE0, 0x93, 0xF3, 0xA3, 0xB5, x, 0x00, 0x40, 0x6E}
 
 typedef struct {
-    char name[DEVICE_NAME_MAX_LEN];
-    uint8_t mac[6];
-    int8_t rssi;
+    char name[BLE_HANDLER_DEVICE_NAME_MAX_LEN];
+    uint8_t mac[BLE_HANDLER_MAC_LEN];
+    int16_t rssi; // Smoothed, in 1/8 dB
+    uint8_t generation; // Bumped whenever the slot takes a device, kept across scans
 } BleDevice;
 
+#define DEVICE_ID(slot, generation) ((size_t)(generation) * BLE_HANDLER_MAX_DEVICES + (slot))
+
 struct BleHandler {
+    const BleHandlerBackend* backend;
+    void* backend_instance;
+
+    // Guards everything below against the backend event thread
+    FuriMutex* mutex;
     BleStatus status;
     BleHandlerRxCallback rx_callback;
     void* rx_context;
     BleHandlerStatusCallback status_callback;
     void* status_context;
+    BleHandlerScanCallback scan_callback;
+    void* scan_context;
 
-    BleDevice devices[MAX_DEVICES];
+    // Devices of the current scan, order holds their slots strongest first
+    BleDevice devices[BLE_HANDLER_MAX_DEVICES];
+    uint8_t order[BLE_HANDLER_MAX_DEVICES];
+    uint8_t index[DEVICE_INDEX_SIZE];
     size_t device_count;
 
+    BleHandlerPeer peer; // Connected or last connected
+    BleHandlerGattHandles handles;
+    uint16_t att_mtu;
+    BleHandlerStats stats;
+
+    // Connection parameter profiles, one update in flight at a time
+    BleHandlerProfile profile; // In use
+    BleHandlerProfile profile_wanted;
+    BleHandlerProfile profile_pending; // Being negotiated, Num if none
+    uint32_t profile_tick; // Update requested
+
     bool initialized;
-    FuriThread* scan_thread;
     bool scanning;
+
+    // Reassembles notifications into frames, only touched by the backend
+    // event thread. Connect and disconnect set rx_reset, guarded by mutex, to
+    // drop a frame left incomplete by the previous link.
+    ChameleonFrameDecoder* decoder;
+    bool rx_reset;
+    BleHandlerRxCallback frame_callback;
+    void* frame_context;
+
+    // Keeps the packets of a frame together, guards packet
+    FuriMutex* tx_mutex;
+    uint8_t packet[BLE_HANDLER_ATT_PAYLOAD_MAX];
+};
+
+// Peripheral latency stays low enough for the supervision timeout to cover
+// (1 + latency) * interval_max twice
+static const BleHandlerConnParams ble_handler_profiles[BleHandlerProfileNum] = {
+    [BleHandlerProfileBulk] =
+        {.interval_min = 6, .interval_max = 12, .latency = 0, .timeout = 200},
+    [BleHandlerProfileInteractive] =
+        {.interval_min = 12, .interval_max = 24, .latency = 0, .timeout = 400},
+    [BleHandlerProfileIdle] =
+        {.interval_min = 160, .interval_max = 320, .latency = 4, .timeout = 600},
 };
 
+static const char* const ble_handler_profile_names[BleHandlerProfileNum] = {
+    [BleHandlerProfileBulk] = "Bulk",
+    [BleHandlerProfileInteractive] = "Interactive",
+    [BleHandlerProfileIdle] = "Idle",
+};
+
+static const BleHandlerGattService ble_handler_uart_service = {
+    .service = BLE_NUS_UUID(0x01),
+    .rx = BLE_NUS_UUID(0x02),
+    .tx = BLE_NUS_UUID(0x03),
+};
+
+static void ble_handler_set_status(BleHandler* handler, BleStatus status) {
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->status = status;
+    BleHandlerStatusCallback callback = handler->status_callback;
+    void* context = handler->status_context;
+    furi_mutex_release(handler->mutex);
+
+    if(callback) {
+        callback(status, context);
+    }
+}
+
+static size_t ble_handler_mac_hash(const uint8_t* mac) {
+    // Vendor bits say little, the low bytes differ between devices
+    uint32_t hash = 2166136261u;
+    for(size_t i = BLE_HANDLER_MAC_LEN; i > 0; i--) {
+        hash = (hash ^ mac[i - 1]) * 16777619u;
+    }
+    return hash % DEVICE_INDEX_SIZE;
+}
+
+// Returns the index entry of mac, or the empty entry it would go in
+static size_t ble_handler_index_find(BleHandler* handler, const uint8_t* mac) {
+    size_t entry = ble_handler_mac_hash(mac);
+
+    while(handler->index[entry] != DEVICE_INDEX_EMPTY &&
+          memcmp(handler->devices[handler->index[entry]].mac, mac, BLE_HANDLER_MAC_LEN) != 0) {
+        entry = (entry + 1) % DEVICE_INDEX_SIZE;
+    }
+
+    return entry;
+}
+
+static void ble_handler_index_rebuild(BleHandler* handler) {
+    memset(handler->index, DEVICE_INDEX_EMPTY, sizeof(handler->index));
+    for(size_t slot = 0; slot < handler->device_count; slot++) {
+        handler->index[ble_handler_index_find(handler, handler->devices[slot].mac)] = slot;
+    }
+}
+
+// Move the device at the given rank to where its RSSI puts it, returns
+// whether the order changed
+static bool ble_handler_rerank(BleHandler* handler, size_t rank) {
+    uint8_t* order = handler->order;
+    uint8_t slot = order[rank];
+    int16_t rssi = handler->devices[slot].rssi;
+    size_t from = rank;
+
+    while(rank > 0 && handler->devices[order[rank - 1]].rssi < rssi) {
+        order[rank] = order[rank - 1];
+        rank--;
+    }
+    while(rank + 1 < handler->device_count && handler->devices[order[rank + 1]].rssi > rssi) {
+        order[rank] = order[rank + 1];
+        rank++;
+    }
+    order[rank] = slot;
+
+    return rank != from;
+}
+
+static size_t ble_handler_rank_of(BleHandler* handler, uint8_t slot) {
+    size_t rank = 0;
+    while(handler->order[rank] != slot) {
+        rank++;
+    }
+    return rank;
+}
+
+// Must be called with mutex held, returns whether the ranked list changed
+static bool ble_handler_update_device(BleHandler* handler, const BleHandlerBackendEvent* event) {
+    int16_t rssi = event->rssi * RSSI_SCALE;
+    size_t entry = ble_handler_index_find(handler, event->mac);
+
+    if(handler->index[entry] != DEVICE_INDEX_EMPTY) {
+        uint8_t slot = handler->index[entry];
+        BleDevice* device = &handler->devices[slot];
+        device->rssi += (rssi - device->rssi) / (1 << RSSI_WEIGHT_SHIFT);
+        return ble_handler_rerank(handler, ble_handler_rank_of(handler, slot));
+    }
+
+    uint8_t slot;
+    size_t rank;
+    bool evict = handler->device_count == BLE_HANDLER_MAX_DEVICES;
+    if(evict) {
+        // Full, a stronger newcomer takes the place of the weakest device
+        rank = handler->device_count - 1;
+        slot = handler->order[rank];
+        if(rssi <= handler->devices[slot].rssi) {
+            return false;
+        }
+    } else {
+        rank = handler->device_count++;
+        slot = rank;
+        handler->order[rank] = slot;
+    }
+
+    BleDevice* device = &handler->devices[slot];
+    device->generation++;
+    snprintf(device->name, BLE_HANDLER_DEVICE_NAME_MAX_LEN, "%s", event->name);
+    memcpy(device->mac, event->mac, BLE_HANDLER_MAC_LEN);
+    device->rssi = rssi;
+
+    // Probe chains may run through the evicted entry, start over
+    if(evict) {
+        ble_handler_index_rebuild(handler);
+    } else {
+        handler->index[entry] = slot;
+    }
+
+    ble_handler_rerank(handler, rank);
+    FURI_LOG_I(TAG, "Found device: %s", device->name);
+
+    return true;
+}
+
+static void ble_handler_add_device(BleHandler* handler, const BleHandlerBackendEvent* event) {
+    if(!event->name ||
+       strncmp(event->name, BLE_DEVICE_NAME_PREFIX, strlen(BLE_DEVICE_NAME_PREFIX)) != 0) {
+        return;
+    }
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool changed = handler->scanning && ble_handler_update_device(handler, event);
+    BleHandlerScanCallback callback = handler->scan_callback;
+    void* context = handler->scan_context;
+    furi_mutex_release(handler->mutex);
+
+    if(changed && callback) {
+        callback(context);
+    }
+}
+
+// Hands a complete frame to the rx callback as the decoder checked it
+static void ble_handler_frame_callback(const ChameleonFrameView* view, void* context) {
+    BleHandler* handler = context;
+    handler->frame_callback(view, handler->frame_context);
+}
+
+static void ble_handler_notification(BleHandler* handler, const BleHandlerBackendEvent* event) {
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool deliver = handler->status == BleStatusConnected &&
+                   event->handle == handler->handles.tx_value;
+    if(deliver) {
+        handler->stats.rx_notifications++;
+        handler->stats.rx_bytes += event->length;
+    }
+    bool reset = handler->rx_reset;
+    handler->rx_reset = false;
+    handler->frame_callback = handler->rx_callback;
+    handler->frame_context = handler->rx_context;
+    furi_mutex_release(handler->mutex);
+
+    if(reset) {
+        chameleon_frame_decoder_reset(handler->decoder);
+    }
+
+    if(!deliver || !handler->frame_callback) return;
+
+    // Frames completed by this notification are delivered from in here
+    chameleon_frame_decoder_feed(handler->decoder, event->data, event->length);
+
+    ChameleonFrameDecoderStats decoder_stats;
+    chameleon_frame_decoder_get_stats(handler->decoder, &decoder_stats);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->stats.rx_frames = decoder_stats.frames;
+    handler->stats.rx_errors = decoder_stats.header_errors + decoder_stats.data_errors;
+    handler->stats.rx_skipped = decoder_stats.bytes_skipped;
+    furi_mutex_release(handler->mutex);
+}
+
+static void ble_handler_request_profile(BleHandler* handler, BleHandlerProfile profile) {
+    FURI_LOG_D(TAG, "Requesting %s link profile", ble_handler_profile_names[profile]);
+
+    if(!handler->backend->update_conn_params(
+           handler->backend_instance, &ble_handler_profiles[profile])) {
+        FURI_LOG_W(TAG, "%s link profile refused", ble_handler_profile_names[profile]);
+        furi_mutex_acquire(handler->mutex, FuriWaitForever);
+        handler->profile_pending = BleHandlerProfileNum;
+        handler->stats.conn_update_failures++;
+        furi_mutex_release(handler->mutex);
+    }
+}
+
+static void ble_handler_conn_params(BleHandler* handler, const BleHandlerBackendEvent* event) {
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+
+    BleHandlerProfile finished = handler->profile_pending;
+    BleHandlerProfile next = BleHandlerProfileNum;
+
+    // Updates the peripheral started itself leave the profile as it is
+    if(finished != BleHandlerProfileNum) {
+        uint32_t elapsed = furi_get_tick() - handler->profile_tick;
+
+        if(event->conn_params) {
+            handler->profile = finished;
+            handler->stats.conn_updates++;
+            handler->stats.conn_update_last_ms = elapsed;
+            handler->stats.conn_update_max_ms = MAX(handler->stats.conn_update_max_ms, elapsed);
+            handler->stats.conn_update_total_ms += elapsed;
+        } else {
+            handler->stats.conn_update_failures++;
+        }
+        handler->profile_pending = BleHandlerProfileNum;
+
+        // Asked for another profile meanwhile, a rejected one is not retried
+        if(handler->status == BleStatusConnected && handler->profile_wanted != finished &&
+           handler->profile_wanted != handler->profile) {
+            next = handler->profile_wanted;
+            handler->profile_pending = next;
+            handler->profile_tick = furi_get_tick();
+        }
+    }
+
+    furi_mutex_release(handler->mutex);
+
+    if(finished != BleHandlerProfileNum) {
+        if(event->conn_params) {
+            FURI_LOG_I(
+                TAG,
+                "%s link profile, interval %u.%02u ms",
+                ble_handler_profile_names[finished],
+                event->conn_params->interval_min * 5 / 4,
+                event->conn_params->interval_min * 125 % 100);
+        } else {
+            FURI_LOG_W(TAG, "%s link profile rejected", ble_handler_profile_names[finished]);
+        }
+    }
+
+    if(next != BleHandlerProfileNum) {
+        ble_handler_request_profile(handler, next);
+    }
+}
+
+static void
+    ble_handler_backend_event_callback(const BleHandlerBackendEvent* event, void* context) {
+    BleHandler* handler = context;
+
+    if(event->type == BleHandlerBackendEventAdvertisement) {
+        ble_handler_add_device(handler, event);
+    } else if(event->type == BleHandlerBackendEventNotification) {
+        ble_handler_notification(handler, event);
+    } else if(event->type == BleHandlerBackendEventConnParams) {
+        ble_handler_conn_params(handler, event);
+    } else if(event->type == BleHandlerBackendEventDisconnected) {
+        furi_mutex_acquire(handler->mutex, FuriWaitForever);
+        bool was_connected = handler->status == BleStatusConnected;
+        handler->att_mtu = BLE_HANDLER_ATT_MTU_DEFAULT;
+        handler->rx_reset = true;
+        handler->profile = BleHandlerProfileNum;
+        handler->profile_pending = BleHandlerProfileNum;
+        furi_mutex_release(handler->mutex);
+
+        if(was_connected) {
+            FURI_LOG_W(TAG, "Link lost");
+            ble_handler_set_status(handler, BleStatusDisconnected);
+        }
+    }
+}
+
 BleHandler* ble_handler_alloc() {
     BleHandler* handler = malloc(sizeof(BleHandler));
     memset(handler, 0, sizeof(BleHandler));
+    handler->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    handler->tx_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
     handler->status = BleStatusDisconnected;
+    handler->att_mtu = BLE_HANDLER_ATT_MTU_DEFAULT;
+    handler->profile = BleHandlerProfileNum;
+    handler->profile_wanted = BleHandlerProfileNum;
+    handler->profile_pending = BleHandlerProfileNum;
+    memset(handler->index, DEVICE_INDEX_EMPTY, sizeof(handler->index));
+    handler->decoder = chameleon_frame_decoder_alloc();
+    chameleon_frame_decoder_set_callback(handler->decoder, ble_handler_frame_callback, handler);
     return handler;
 }
 
@@ -41,9 +383,22 @@ void ble_handler_free(BleHandler* handler) {
         ble_handler_deinit(handler);
     }
 
+    chameleon_frame_decoder_free(handler->decoder);
+    furi_mutex_free(handler->tx_mutex);
+    furi_mutex_free(handler->mutex);
     free(handler);
 }
 
+void ble_handler_set_backend(
+    BleHandler* handler,
+    const BleHandlerBackend* backend,
+    void* instance) {
+    furi_assert(handler);
+    furi_assert(!handler->initialized);
+    handler->backend = backend;
+    handler->backend_instance = instance;
+}
+
 bool ble_handler_init(BleHandler* handler) {
     furi_assert(handler);
 
@@ -52,11 +407,15 @@ bool ble_handler_init(BleHandler* handler) {
         return true;
     }
 
-    FURI_LOG_I(TAG, "Initializing BLE");
+    if(!handler->backend) {
+        FURI_LOG_E(TAG, "No BLE central backend in this firmware");
+        return false;
+    }
+
+    FURI_LOG_I(TAG, "Initializing BLE on %s", handler->backend->name);
 
-    // Note: BLE initialization on Flipper Zero is complex and requires
-    // proper GAP/GATT setup. This is a simplified version.
-    // For production, you'd need to use the full BLE stack.
+    handler->backend->set_event_callback(
+        handler->backend_instance, ble_handler_backend_event_callback, handler);
 
     handler->initialized = true;
     handler->status = BleStatusDisconnected;
@@ -75,6 +434,7 @@ void ble_handler_deinit(BleHandler* handler) {
     ble_handler_disconnect(handler);
     ble_handler_stop_scan(handler);
 
+    handler->backend->set_event_callback(handler->backend_instance, NULL, NULL);
     handler->initialized = false;
 
     FURI_LOG_I(TAG, "BLE deinitialized");
@@ -85,8 +445,21 @@ void ble_handler_set_rx_callback(
     BleHandlerRxCallback callback,
     void* context) {
     furi_assert(handler);
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
     handler->rx_callback = callback;
     handler->rx_context = context;
+    furi_mutex_release(handler->mutex);
+}
+
+void ble_handler_set_scan_callback(
+    BleHandler* handler,
+    BleHandlerScanCallback callback,
+    void* context) {
+    furi_assert(handler);
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->scan_callback = callback;
+    handler->scan_context = context;
+    furi_mutex_release(handler->mutex);
 }
 
 void ble_handler_set_status_callback(
@@ -94,33 +467,10 @@ void ble_handler_set_status_callback(
     BleHandlerStatusCallback callback,
     void* context) {
     furi_assert(handler);
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
     handler->status_callback = callback;
     handler->status_context = context;
-}
-
-static int32_t ble_scan_thread(void* context) {
-    BleHandler* handler = context;
-
-    FURI_LOG_I(TAG, "Scan thread started");
-
-    // Simulate scanning for Chameleon Ultra devices
-    // In a real implementation, this would use BLE GAP scanning
-
-    handler->device_count = 0;
-
-    // Simulate finding a device (for testing)
-    // TODO: Implement actual BLE scanning
-    furi_delay_ms(2000);
-
-    if(handler->scanning) {
-        snprintf(handler->devices[0].name, DEVICE_NAME_MAX_LEN, "Chameleon Ultra");
-        handler->devices[0].rssi = -60;
-        handler->device_count = 1;
-        FURI_LOG_I(TAG, "Found device: %s", handler->devices[0].name);
-    }
-
-    FURI_LOG_I(TAG, "Scan thread finished");
-    return 0;
+    furi_mutex_release(handler->mutex);
 }
 
 bool ble_handler_start_scan(BleHandler* handler) {
@@ -138,21 +488,24 @@ bool ble_handler_start_scan(BleHandler* handler) {
 
     FURI_LOG_I(TAG, "Starting BLE scan");
 
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
     handler->scanning = true;
     handler->device_count = 0;
-    handler->status = BleStatusScanning;
-
-    if(handler->status_callback) {
-        handler->status_callback(handler->status, handler->status_context);
+    memset(handler->index, DEVICE_INDEX_EMPTY, sizeof(handler->index));
+    furi_mutex_release(handler->mutex);
+
+    ble_handler_set_status(handler, BleStatusScanning);
+
+    // Advertisements are collected from the event callback until stopped
+    if(!handler->backend->start_scan(handler->backend_instance)) {
+        FURI_LOG_E(TAG, "Scan failed to start");
+        furi_mutex_acquire(handler->mutex, FuriWaitForever);
+        handler->scanning = false;
+        furi_mutex_release(handler->mutex);
+        ble_handler_set_status(handler, BleStatusError);
+        return false;
     }
 
-    handler->scan_thread = furi_thread_alloc();
-    furi_thread_set_name(handler->scan_thread, "BleScanThread");
-    furi_thread_set_stack_size(handler->scan_thread, 2048);
-    furi_thread_set_context(handler->scan_thread, handler);
-    furi_thread_set_callback(handler->scan_thread, ble_scan_thread);
-    furi_thread_start(handler->scan_thread);
-
     return true;
 }
 
@@ -165,114 +518,412 @@ void ble_handler_stop_scan(BleHandler* handler) {
 
     FURI_LOG_I(TAG, "Stopping BLE scan");
 
-    handler->scanning = false;
-
-    if(handler->scan_thread) {
-        furi_thread_join(handler->scan_thread);
-        furi_thread_free(handler->scan_thread);
-        handler->scan_thread = NULL;
-    }
+    handler->backend->stop_scan(handler->backend_instance);
 
-    handler->status = BleStatusDisconnected;
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->scanning = false;
+    furi_mutex_release(handler->mutex);
 
-    if(handler->status_callback) {
-        handler->status_callback(handler->status, handler->status_context);
-    }
+    ble_handler_set_status(handler, BleStatusDisconnected);
 }
 
 size_t ble_handler_get_device_count(BleHandler* handler) {
     furi_assert(handler);
-    return handler->device_count;
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    size_t count = handler->device_count;
+    furi_mutex_release(handler->mutex);
+
+    return count;
 }
 
-const char* ble_handler_get_device_name(BleHandler* handler, size_t index) {
+bool ble_handler_get_device(BleHandler* handler, size_t rank, BleHandlerDevice* device) {
     furi_assert(handler);
-
-    if(index >= handler->device_count) {
-        return NULL;
+    furi_assert(device);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool found = rank < handler->device_count;
+    if(found) {
+        const BleDevice* entry = &handler->devices[handler->order[rank]];
+        device->id = DEVICE_ID(handler->order[rank], entry->generation);
+        memcpy(device->name, entry->name, sizeof(device->name));
+        memcpy(device->mac, entry->mac, sizeof(device->mac));
+        device->rssi = entry->rssi / RSSI_SCALE;
     }
+    furi_mutex_release(handler->mutex);
 
-    return handler->devices[index].name;
+    return found;
 }
 
-bool ble_handler_connect(BleHandler* handler, size_t device_index) {
-    furi_assert(handler);
+// Bring up the UART service of a peer, known handles skip service discovery
+static bool ble_handler_open(BleHandler* handler, const BleHandlerPeer* peer, bool known) {
+    void* instance = handler->backend_instance;
+
+    BleHandlerGattHandles handles = peer->handles;
+    if(!handler->backend->connect(
+           instance,
+           peer->mac,
+           &ble_handler_uart_service,
+           &handles,
+           known,
+           known ? BLE_HANDLER_RECONNECT_TIMEOUT_MS : BLE_HANDLER_CONNECT_TIMEOUT_MS)) {
+        if(known) {
+            FURI_LOG_E(TAG, "%s not reachable", peer->name);
+        } else {
+            FURI_LOG_E(TAG, "No UART service on %s", peer->name);
+        }
+        return false;
+    }
 
+    // Fewer, larger packets per frame are what sets throughput
+    uint16_t att_mtu = handler->backend->exchange_mtu(instance, BLE_HANDLER_ATT_MTU_MAX);
+    att_mtu = CLAMP(att_mtu, BLE_HANDLER_ATT_MTU_MAX, BLE_HANDLER_ATT_MTU_DEFAULT);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->peer = *peer;
+    handler->peer.handles = handles;
+    handler->handles = handles;
+    handler->att_mtu = att_mtu;
+    handler->rx_reset = true;
+    handler->profile = BleHandlerProfileNum;
+    handler->profile_pending = BleHandlerProfileNum;
+    furi_mutex_release(handler->mutex);
+
+    // Notifications must be on before the first request, the only write
+    // that waits for a response. Stale cached handles fail here.
+    static const uint8_t notify_enable[] = {0x01, 0x00};
+    if(!handler->backend->write(
+           instance,
+           handles.tx_cccd,
+           notify_enable,
+           sizeof(notify_enable),
+           true,
+           BLE_HANDLER_CONNECT_TIMEOUT_MS)) {
+        FURI_LOG_E(TAG, "Failed to enable notifications");
+        handler->backend->disconnect(instance);
+        return false;
+    }
+
+    return true;
+}
+
+static bool ble_handler_establish(BleHandler* handler, const BleHandlerPeer* peer, bool known) {
     if(!handler->initialized) {
         FURI_LOG_E(TAG, "Not initialized");
         return false;
     }
 
-    if(device_index >= handler->device_count) {
-        FURI_LOG_E(TAG, "Invalid device index: %zu", device_index);
+    FURI_LOG_I(TAG, "%s to: %s", known ? "Reconnecting" : "Connecting", peer->name);
+
+    ble_handler_set_status(handler, BleStatusConnecting);
+
+    if(!ble_handler_open(handler, peer, known)) {
+        ble_handler_set_status(handler, BleStatusError);
         return false;
     }
 
-    FURI_LOG_I(TAG, "Connecting to: %s", handler->devices[device_index].name);
+    ble_handler_set_status(handler, BleStatusConnected);
 
-    handler->status = BleStatusConnecting;
+    FURI_LOG_I(
+        TAG, "Connected to: %s, ATT MTU %u", peer->name, ble_handler_get_att_mtu(handler));
 
-    if(handler->status_callback) {
-        handler->status_callback(handler->status, handler->status_context);
-    }
+    // The central's defaults are unknown, start from a known profile
+    ble_handler_set_profile(handler, BleHandlerProfileInteractive);
 
-    // Simulate connection
-    // TODO: Implement actual BLE connection with GATT services
-    furi_delay_ms(1000);
+    return true;
+}
 
-    handler->status = BleStatusConnected;
+bool ble_handler_connect(BleHandler* handler, size_t device_id) {
+    furi_assert(handler);
+
+    // Freezes the device list
+    ble_handler_stop_scan(handler);
+
+    BleHandlerPeer peer;
+    memset(&peer, 0, sizeof(peer));
 
-    if(handler->status_callback) {
-        handler->status_callback(handler->status, handler->status_context);
+    // A slot refilled since the id was handed out holds another device
+    size_t slot = device_id % BLE_HANDLER_MAX_DEVICES;
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool valid = slot < handler->device_count &&
+                 DEVICE_ID(slot, handler->devices[slot].generation) == device_id;
+    if(valid) {
+        const BleDevice* device = &handler->devices[slot];
+        memcpy(peer.mac, device->mac, sizeof(peer.mac));
+        memcpy(peer.name, device->name, sizeof(peer.name));
     }
+    furi_mutex_release(handler->mutex);
 
-    FURI_LOG_I(TAG, "Connected to: %s", handler->devices[device_index].name);
+    if(!valid) {
+        FURI_LOG_E(TAG, "Invalid or stale device id: %zu", device_id);
+        return false;
+    }
 
-    return true;
+    return ble_handler_establish(handler, &peer, false);
+}
+
+bool ble_handler_connect_peer(BleHandler* handler, const BleHandlerPeer* peer) {
+    furi_assert(handler);
+    furi_assert(peer);
+
+    ble_handler_stop_scan(handler);
+
+    return ble_handler_establish(handler, peer, true);
+}
+
+bool ble_handler_get_peer(BleHandler* handler, BleHandlerPeer* peer) {
+    furi_assert(handler);
+    furi_assert(peer);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool connected = handler->status == BleStatusConnected;
+    if(connected) {
+        *peer = handler->peer;
+    }
+    furi_mutex_release(handler->mutex);
+
+    return connected;
 }
 
 void ble_handler_disconnect(BleHandler* handler) {
     furi_assert(handler);
 
-    if(handler->status != BleStatusConnected) {
+    BleStatus status = ble_handler_get_status(handler);
+    if(status != BleStatusConnected && status != BleStatusConnecting) {
         return;
     }
 
     FURI_LOG_I(TAG, "Disconnecting");
 
-    // TODO: Implement actual BLE disconnection
+    handler->backend->disconnect(handler->backend_instance);
 
-    handler->status = BleStatusDisconnected;
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->att_mtu = BLE_HANDLER_ATT_MTU_DEFAULT;
+    handler->rx_reset = true;
+    handler->profile = BleHandlerProfileNum;
+    handler->profile_pending = BleHandlerProfileNum;
+    furi_mutex_release(handler->mutex);
 
-    if(handler->status_callback) {
-        handler->status_callback(handler->status, handler->status_context);
-    }
+    ble_handler_set_status(handler, BleStatusDisconnected);
 
     FURI_LOG_I(TAG, "Disconnected");
 }
 
 bool ble_handler_send(BleHandler* handler, const uint8_t* data, size_t length) {
+    return ble_handler_send_segments(handler, data, length, NULL, 0, NULL, 0);
+}
+
+// Must be called with tx_mutex held
+static bool ble_handler_write_packet(
+    BleHandler* handler,
+    uint16_t handle,
+    const uint8_t* data,
+    size_t length) {
+    if(!handler->backend->write(
+           handler->backend_instance, handle, data, length, false, BLE_HANDLER_TX_TIMEOUT_MS)) {
+        FURI_LOG_E(TAG, "Write of %zu bytes failed", length);
+        return false;
+    }
+
+    return true;
+}
+
+bool ble_handler_send_segments(
+    BleHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
     furi_assert(handler);
-    furi_assert(data);
+    furi_assert(header || header_len == 0);
+    furi_assert(payload || payload_len == 0);
+    furi_assert(trailer || trailer_len == 0);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    bool connected = handler->status == BleStatusConnected;
+    uint16_t handle = handler->handles.rx_value;
+    size_t packet_max = handler->att_mtu - BLE_HANDLER_ATT_HEADER_LEN;
+    furi_mutex_release(handler->mutex);
 
-    if(handler->status != BleStatusConnected) {
+    if(!connected) {
         FURI_LOG_E(TAG, "Not connected");
         return false;
     }
 
-    FURI_LOG_D(TAG, "Sending %zu bytes via BLE", length);
+    const uint8_t* segments[] = {header, payload, trailer};
+    size_t lengths[] = {header_len, payload_len, trailer_len};
+    size_t fill = 0;
+    uint32_t packets = 0;
+    bool success = true;
+
+    furi_mutex_acquire(handler->tx_mutex, FuriWaitForever);
+
+    // Segments are packed back to back, every packet but the last is full
+    for(size_t i = 0; i < COUNT_OF(segments) && success; i++) {
+        const uint8_t* data = segments[i];
+        size_t length = lengths[i];
+
+        while(length > 0 && success) {
+            // Whole packets of a long segment go out in place
+            if(fill == 0 && length >= packet_max) {
+                success = ble_handler_write_packet(handler, handle, data, packet_max);
+                data += packet_max;
+                length -= packet_max;
+                packets++;
+                continue;
+            }
+
+            size_t chunk = MIN(length, packet_max - fill);
+            memcpy(&handler->packet[fill], data, chunk);
+            fill += chunk;
+            data += chunk;
+            length -= chunk;
+
+            if(fill == packet_max) {
+                success = ble_handler_write_packet(handler, handle, handler->packet, fill);
+                fill = 0;
+                packets++;
+            }
+        }
+    }
 
-    // TODO: Implement actual BLE data transmission via GATT characteristic
+    if(success && fill > 0) {
+        success = ble_handler_write_packet(handler, handle, handler->packet, fill);
+        packets++;
+    }
 
-    return true;
+    furi_mutex_release(handler->tx_mutex);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->stats.tx_packets += packets;
+    if(success) {
+        handler->stats.tx_frames++;
+        handler->stats.tx_bytes += header_len + payload_len + trailer_len;
+    }
+    furi_mutex_release(handler->mutex);
+
+    return success;
 }
 
 BleStatus ble_handler_get_status(BleHandler* handler) {
     furi_assert(handler);
-    return handler->status;
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    BleStatus status = handler->status;
+    furi_mutex_release(handler->mutex);
+
+    return status;
 }
 
 bool ble_handler_is_connected(BleHandler* handler) {
+    return ble_handler_get_status(handler) == BleStatusConnected;
+}
+
+uint16_t ble_handler_get_att_mtu(BleHandler* handler) {
+    furi_assert(handler);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    uint16_t att_mtu = handler->att_mtu;
+    furi_mutex_release(handler->mutex);
+
+    return att_mtu;
+}
+
+void ble_handler_set_profile(BleHandler* handler, BleHandlerProfile profile) {
+    furi_assert(handler);
+    furi_assert(profile < BleHandlerProfileNum);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->profile_wanted = profile;
+    bool request = handler->status == BleStatusConnected &&
+                   handler->backend->update_conn_params &&
+                   handler->profile_pending == BleHandlerProfileNum &&
+                   handler->profile != profile;
+    if(request) {
+        handler->profile_pending = profile;
+        handler->profile_tick = furi_get_tick();
+    }
+    furi_mutex_release(handler->mutex);
+
+    if(request) {
+        ble_handler_request_profile(handler, profile);
+    }
+}
+
+BleHandlerProfile ble_handler_get_profile(BleHandler* handler) {
     furi_assert(handler);
-    return (handler->status == BleStatusConnected);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    BleHandlerProfile profile = handler->profile;
+    furi_mutex_release(handler->mutex);
+
+    return profile;
+}
+
+const char* ble_handler_profile_name(BleHandlerProfile profile) {
+    return profile < BleHandlerProfileNum ? ble_handler_profile_names[profile] : "None";
+}
+
+void ble_handler_get_stats(BleHandler* handler, BleHandlerStats* stats) {
+    furi_assert(handler);
+    furi_assert(stats);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    *stats = handler->stats;
+    furi_mutex_release(handler->mutex);
+}
+
+static bool ble_handler_transport_send(
+    void* instance,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    return ble_handler_send_segments(
+        instance, header, header_len, payload, payload_len, trailer, trailer_len);
+}
+
+// Notifications flow for as long as the connection is up
+static void ble_handler_transport_start_rx(void* instance) {
+    UNUSED(instance);
+}
+
+static void ble_handler_transport_stop_rx(void* instance) {
+    UNUSED(instance);
 }
+
+static void ble_handler_transport_set_frame_callback(
+    void* instance,
+    ChameleonTransportFrameCallback callback,
+    void* context) {
+    ble_handler_set_rx_callback(instance, callback, context);
+}
+
+static size_t ble_handler_transport_get_mtu(void* instance) {
+    return ble_handler_get_att_mtu(instance) - BLE_HANDLER_ATT_HEADER_LEN;
+}
+
+static void ble_handler_transport_get_stats(void* instance, ChameleonTransportStats* stats) {
+    BleHandlerStats ble_stats;
+    ble_handler_get_stats(instance, &ble_stats);
+
+    memset(stats, 0, sizeof(ChameleonTransportStats));
+    stats->tx_bytes = ble_stats.tx_bytes;
+    stats->rx_bytes = ble_stats.rx_bytes;
+    stats->rx_dropped = ble_stats.rx_skipped;
+}
+
+const ChameleonTransportInterface ble_handler_transport = {
+    .name = "Bluetooth",
+    .send = ble_handler_transport_send,
+    .start_rx = ble_handler_transport_start_rx,
+    .stop_rx = ble_handler_transport_stop_rx,
+    .set_frame_callback = ble_handler_transport_set_frame_callback,
+    .get_mtu = ble_handler_transport_get_mtu,
+    .get_stats = ble_handler_transport_get_stats,
+};
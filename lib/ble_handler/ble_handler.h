@@ -1,12 +1,47 @@
 #pragma once
 
 #include <furi.h>
-#include <furi_hal_bt.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "../chameleon_transport/chameleon_transport.h"
+#include "../chameleon_protocol/chameleon_protocol.h"
+
+// ATT MTU before the exchange and the largest the Chameleon accepts
+#define BLE_HANDLER_ATT_MTU_DEFAULT 23
+#define BLE_HANDLER_ATT_MTU_MAX 247
+
+// Opcode and handle in front of each written or notified value
+#define BLE_HANDLER_ATT_HEADER_LEN 3
+
+#define BLE_HANDLER_ATT_PAYLOAD_MAX (BLE_HANDLER_ATT_MTU_MAX - BLE_HANDLER_ATT_HEADER_LEN)
+
+#define BLE_HANDLER_CONNECT_TIMEOUT_MS 5000
+
+// A peer that is around answers a direct connect within a few advertising
+// intervals
+#define BLE_HANDLER_RECONNECT_TIMEOUT_MS 1500
+
+// Time to wait for the stack to take one packet of a frame
+#define BLE_HANDLER_TX_TIMEOUT_MS 100
+
+// Scan results kept, the weakest gives way to a stronger newcomer
+#define BLE_HANDLER_MAX_DEVICES 16
+
+// Device ids stay below this. An id names a list slot and how often the slot
+// had been filled, the count wraps after 256 devices through one slot.
+#define BLE_HANDLER_DEVICE_ID_LIMIT (BLE_HANDLER_MAX_DEVICES * 256)
+
+#define BLE_HANDLER_DEVICE_NAME_MAX_LEN 32
+#define BLE_HANDLER_MAC_LEN 6
+
 // BLE handler instance
+//
+// Central side of a connection to the Chameleon's UART service (Nordic UART
+// Service): requests are written to its RX characteristic, responses arrive
+// as notifications of its TX characteristic. The radio work is done by a
+// backend, the GATT client of whatever BLE stack is available.
 typedef struct BleHandler BleHandler;
 
 // BLE connection status
@@ -18,39 +53,225 @@ typedef enum {
     BleStatusError,
 } BleStatus;
 
-// Callback for received data
-typedef void (*BleHandlerRxCallback)(const uint8_t* data, size_t length, void* context);
+// Callback for received frames, one whole checked frame per call.
+// Notifications are reassembled first, runs on the backend's event thread.
+typedef void (*BleHandlerRxCallback)(const ChameleonFrameView* view, void* context);
 
 // Callback for connection status changes
 typedef void (*BleHandlerStatusCallback)(BleStatus status, void* context);
 
+// Callback for scan result changes (new device or new order), runs on the
+// backend's event thread
+typedef void (*BleHandlerScanCallback)(void* context);
+
+// Scan result, a Chameleon seen during the current scan
+typedef struct {
+    size_t id; // Pass to ble_handler_connect, refused once the device left the list
+    char name[BLE_HANDLER_DEVICE_NAME_MAX_LEN];
+    uint8_t mac[BLE_HANDLER_MAC_LEN];
+    int8_t rssi; // Smoothed over the advertisements seen
+} BleHandlerDevice;
+
+// 128-bit UUIDs of the UART service, little endian as sent over the air
+typedef struct {
+    uint8_t service[16];
+    uint8_t rx[16]; // Written by the central
+    uint8_t tx[16]; // Notified by the peripheral
+} BleHandlerGattService;
+
+// Attribute handles found by service discovery
+typedef struct {
+    uint16_t rx_value;
+    uint16_t tx_value;
+    uint16_t tx_cccd; // Client configuration descriptor of tx_value
+} BleHandlerGattHandles;
+
+// What reconnecting to a device takes without scanning or service discovery
+typedef struct {
+    uint8_t mac[BLE_HANDLER_MAC_LEN];
+    char name[BLE_HANDLER_DEVICE_NAME_MAX_LEN];
+    BleHandlerGattHandles handles;
+} BleHandlerPeer;
+
+// Connection parameters in link layer units
+typedef struct {
+    uint16_t interval_min; // 1.25 ms units
+    uint16_t interval_max; // 1.25 ms units
+    uint16_t latency; // Connection events the peripheral may skip
+    uint16_t timeout; // Supervision timeout, 10 ms units
+} BleHandlerConnParams;
+
+// Named connection parameter sets
+typedef enum {
+    BleHandlerProfileBulk, // Shortest interval, no peripheral latency
+    BleHandlerProfileInteractive, // Short interval, answers within a few tens of ms
+    BleHandlerProfileIdle, // Long interval and peripheral latency, saves battery
+    BleHandlerProfileNum, // None applied yet
+} BleHandlerProfile;
+
+typedef enum {
+    BleHandlerBackendEventAdvertisement, // mac, rssi and name of an advertiser
+    BleHandlerBackendEventNotification, // handle and value of a notification
+    BleHandlerBackendEventDisconnected, // Link lost or closed by the peer
+    BleHandlerBackendEventConnParams, // Connection parameter update finished
+} BleHandlerBackendEventType;
+
+// Backend event, pointers are only valid during the callback
+typedef struct {
+    BleHandlerBackendEventType type;
+    const uint8_t* mac;
+    int8_t rssi;
+    const char* name; // NULL if the advertisement carries none
+    uint16_t handle;
+    const uint8_t* data;
+    size_t length;
+    const BleHandlerConnParams* conn_params; // In use from now on, NULL if rejected
+} BleHandlerBackendEvent;
+
+// Callback for backend events, runs on the backend's event thread. Events are
+// delivered one at a time.
+typedef void (*BleHandlerBackendEventCallback)(const BleHandlerBackendEvent* event, void* context);
+
+// GATT client operations of a BLE stack in the central role, each takes the
+// backend instance as its first argument. Stock Flipper firmware does not
+// offer the central role to apps, firmware builds or host tools that have
+// one register it with ble_handler_set_backend.
+typedef struct {
+    const char* name;
+
+    void (*set_event_callback)(
+        void* instance,
+        BleHandlerBackendEventCallback callback,
+        void* context);
+
+    bool (*start_scan)(void* instance);
+    void (*stop_scan)(void* instance);
+
+    // Connect and discover the service, false if the peer does not answer
+    // within the timeout or lacks the service. With known set, handles hold
+    // those of an earlier connection to the peer and discovery is skipped.
+    bool (*connect)(
+        void* instance,
+        const uint8_t* mac,
+        const BleHandlerGattService* service,
+        BleHandlerGattHandles* handles,
+        bool known,
+        uint32_t timeout_ms);
+    void (*disconnect)(void* instance);
+
+    // Exchange MTU, returns the ATT MTU both sides use from now on
+    uint16_t (*exchange_mtu)(void* instance, uint16_t client_mtu);
+
+    // Start a connection parameter update and return, the outcome arrives as
+    // a BleHandlerBackendEventConnParams event. Called from the event
+    // callback too. NULL if the stack cannot update parameters.
+    bool (*update_conn_params)(void* instance, const BleHandlerConnParams* params);
+
+    // Write a value of at most MTU - 3 bytes. With response blocks until the
+    // peer acknowledged it, without response until the stack queued the packet.
+    bool (*write)(
+        void* instance,
+        uint16_t handle,
+        const uint8_t* data,
+        size_t length,
+        bool with_response,
+        uint32_t timeout_ms);
+} BleHandlerBackend;
+
+// Link counters since alloc
+typedef struct {
+    uint32_t tx_frames;
+    uint32_t tx_packets; // Write without response packets, frames are packed into the fewest
+    uint32_t tx_bytes;
+    uint32_t rx_notifications;
+    uint32_t rx_bytes;
+    uint32_t rx_frames; // Reassembled from notifications and delivered
+    uint32_t rx_errors; // Frames dropped on a bad header or checksum
+    uint32_t rx_skipped; // Bytes outside any frame
+    uint32_t conn_updates; // Profile switches the peer accepted
+    uint32_t conn_update_failures;
+    uint32_t conn_update_last_ms; // Request to parameters in use
+    uint32_t conn_update_max_ms;
+    uint32_t conn_update_total_ms;
+} BleHandlerStats;
+
 // Create and destroy BLE handler
 BleHandler* ble_handler_alloc();
 void ble_handler_free(BleHandler* handler);
 
-// Initialize BLE
+// Set the GATT client backend, call while not initialized
+void ble_handler_set_backend(
+    BleHandler* handler,
+    const BleHandlerBackend* backend,
+    void* instance);
+
+// Initialize BLE, fails without a backend
 bool ble_handler_init(BleHandler* handler);
 void ble_handler_deinit(BleHandler* handler);
 
 // Set callbacks
 void ble_handler_set_rx_callback(BleHandler* handler, BleHandlerRxCallback callback, void* context);
 void ble_handler_set_status_callback(BleHandler* handler, BleHandlerStatusCallback callback, void* context);
+void ble_handler_set_scan_callback(
+    BleHandler* handler,
+    BleHandlerScanCallback callback,
+    void* context);
 
 // Scan for Chameleon Ultra devices
 bool ble_handler_start_scan(BleHandler* handler);
 void ble_handler_stop_scan(BleHandler* handler);
 
-// Get list of found devices
+// Get found devices, deduplicated by MAC and ranked by smoothed RSSI with the
+// nearest first. The list changes while scanning, copy out what is needed.
 size_t ble_handler_get_device_count(BleHandler* handler);
-const char* ble_handler_get_device_name(BleHandler* handler, size_t index);
+bool ble_handler_get_device(BleHandler* handler, size_t rank, BleHandlerDevice* device);
+
+// Stop scanning, connect to the device with the given id, negotiate the
+// largest MTU and enable notifications. Blocks until the link is usable or
+// has failed. Fails right away when another device or a later scan took the
+// id's place in the list.
+bool ble_handler_connect(BleHandler* handler, size_t device_id);
+
+// Connect to a peer of an earlier connection straight away, trusting its
+// handles. Fails quickly when the peer is away or its handles went stale.
+bool ble_handler_connect_peer(BleHandler* handler, const BleHandlerPeer* peer);
 
-// Connect to device
-bool ble_handler_connect(BleHandler* handler, size_t device_index);
+// Get the connected peer, to reconnect to it later
+bool ble_handler_get_peer(BleHandler* handler, BleHandlerPeer* peer);
 void ble_handler_disconnect(BleHandler* handler);
 
 // Send data
 bool ble_handler_send(BleHandler* handler, const uint8_t* data, size_t length);
 
+// Send one frame given as header/payload/trailer segments (any may be empty),
+// packed into write without response packets of the negotiated ATT payload
+bool ble_handler_send_segments(
+    BleHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len);
+
 // Check connection status
 BleStatus ble_handler_get_status(BleHandler* handler);
 bool ble_handler_is_connected(BleHandler* handler);
+
+// Get the negotiated ATT MTU, BLE_HANDLER_ATT_MTU_DEFAULT while disconnected
+uint16_t ble_handler_get_att_mtu(BleHandler* handler);
+
+// Switch the link to a profile and return without waiting. Only one update
+// runs at a time, the last profile asked for is applied once it finishes.
+// Connecting applies BleHandlerProfileInteractive.
+void ble_handler_set_profile(BleHandler* handler, BleHandlerProfile profile);
+
+// Get the profile in use, BleHandlerProfileNum before the first switch
+BleHandlerProfile ble_handler_get_profile(BleHandler* handler);
+
+const char* ble_handler_profile_name(BleHandlerProfile profile);
+
+void ble_handler_get_stats(BleHandler* handler, BleHandlerStats* stats);
+
+// Transport operations, the instance is a BleHandler
+extern const ChameleonTransportInterface ble_handler_transport;
@@ -0,0 +1,483 @@
+#include "chameleon_bench.h"
+#include <furi.h>
+#include <furi_hal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TAG "ChameleonBench"
+
+#define CHAMELEON_BENCH_MF1_KEY_A 0x60
+#define CHAMELEON_BENCH_MF1_KEY_LEN 6
+#define CHAMELEON_BENCH_MF1_BLOCK_LEN 16
+
+typedef enum {
+    ChameleonBenchStateIdle,
+    ChameleonBenchStatePreparing, // Reading the data a write case writes back
+    ChameleonBenchStateRunning,
+} ChameleonBenchState;
+
+// Request in flight, the context of its engine callback
+typedef struct {
+    ChameleonBench* bench;
+    uint32_t start_cycles;
+    bool busy;
+} ChameleonBenchSlot;
+
+struct ChameleonBench {
+    ChameleonEngine* engine;
+    FuriMutex* mutex;
+    FuriSemaphore* finished; // Given once the callback of a finished case returned
+
+    // Everything below is guarded by mutex
+    ChameleonBenchState state;
+    bool joined; // The last case has been waited for, no finished token pending
+    bool stopping;
+
+    ChameleonBenchCase bench_case;
+    uint32_t iterations;
+    uint8_t depth;
+    ChameleonBenchCallback callback;
+    void* context;
+
+    // Request repeated by the case, referenced by the engine while in flight
+    uint16_t cmd;
+    bool bulk;
+    uint8_t request[CHAMELEON_MAX_DATA_LEN];
+    uint16_t request_len;
+
+    ChameleonBenchSlot slots[CHAMELEON_ENGINE_WINDOW];
+    uint32_t issued;
+    uint32_t in_flight;
+    uint32_t errors;
+    uint32_t* samples; // Latency of each successful request, microseconds
+    uint32_t sampled;
+    uint64_t bytes;
+    uint32_t last_cycles; // Elapsed time is summed between completions, wrap safe
+    uint64_t elapsed_cycles;
+
+    ChameleonBenchResult result;
+};
+
+static const char* const chameleon_bench_case_names[ChameleonBenchCaseNum] = {
+    [ChameleonBenchCasePing] = "Ping",
+    [ChameleonBenchCaseMf1Read] = "MF1 read",
+    [ChameleonBenchCaseMf1Write] = "MF1 write",
+    [ChameleonBenchCaseEmuWrite] = "Emu write",
+};
+
+// Cortex-M4 cycle counter, wraps after about a minute at 64 MHz
+static inline uint32_t chameleon_bench_cycles(void) {
+    return DWT->CYCCNT;
+}
+
+static int chameleon_bench_compare(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentile of sorted samples
+static uint32_t chameleon_bench_percentile(const uint32_t* samples, uint32_t count, uint32_t p) {
+    uint32_t rank = (count * p + 99) / 100;
+    return samples[rank > 0 ? rank - 1 : 0];
+}
+
+// Must be called with mutex held, fills the result and returns true exactly
+// once when the last request of a running case completed
+static bool chameleon_bench_finish_locked(ChameleonBench* bench) {
+    if(bench->state != ChameleonBenchStateRunning || bench->in_flight > 0) return false;
+    if(!bench->stopping && bench->issued < bench->iterations) return false;
+
+    ChameleonBenchResult* result = &bench->result;
+    memset(result, 0, sizeof(ChameleonBenchResult));
+    result->requests = bench->sampled;
+    result->errors = bench->errors;
+
+    uint64_t elapsed_us = bench->elapsed_cycles / furi_hal_cortex_instructions_per_microsecond();
+    result->elapsed_ms = elapsed_us / 1000;
+
+    if(bench->sampled > 0) {
+        qsort(bench->samples, bench->sampled, sizeof(uint32_t), chameleon_bench_compare);
+
+        uint64_t sum = 0;
+        for(uint32_t i = 0; i < bench->sampled; i++) {
+            sum += bench->samples[i];
+        }
+
+        result->min_us = bench->samples[0];
+        result->max_us = bench->samples[bench->sampled - 1];
+        result->avg_us = sum / bench->sampled;
+        result->p50_us = chameleon_bench_percentile(bench->samples, bench->sampled, 50);
+        result->p99_us = chameleon_bench_percentile(bench->samples, bench->sampled, 99);
+    }
+
+    if(elapsed_us > 0) {
+        result->requests_per_s = (uint64_t)bench->sampled * 1000000 / elapsed_us;
+        result->bytes_per_s = bench->bytes * 1000000 / elapsed_us;
+    }
+
+    free(bench->samples);
+    bench->samples = NULL;
+    bench->state = ChameleonBenchStateIdle;
+
+    return true;
+}
+
+// Report a finished case, nothing may touch the bench after the token is given
+static void chameleon_bench_finished(ChameleonBench* bench, bool success) {
+    FURI_LOG_I(
+        TAG,
+        "%s: %lu ok, %lu failed, avg %lu us, p99 %lu us",
+        chameleon_bench_case_names[bench->bench_case],
+        bench->result.requests,
+        bench->result.errors,
+        bench->result.avg_us,
+        bench->result.p99_us);
+
+    if(bench->callback) {
+        bench->callback(success, bench->context);
+    }
+
+    furi_semaphore_release(bench->finished);
+}
+
+static void chameleon_bench_issue(ChameleonBench* bench);
+
+static void chameleon_bench_request_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    uint32_t cycles = chameleon_bench_cycles();
+    ChameleonBenchSlot* slot = context;
+    ChameleonBench* bench = slot->bench;
+
+    furi_mutex_acquire(bench->mutex, FuriWaitForever);
+
+    if(result == ChameleonEngineResultOk &&
+       chameleon_protocol_status_is_success(response->status)) {
+        bench->samples[bench->sampled++] =
+            (cycles - slot->start_cycles) / furi_hal_cortex_instructions_per_microsecond();
+        bench->bytes += bench->request_len + response->data_len;
+    } else {
+        bench->errors++;
+    }
+
+    bench->elapsed_cycles += cycles - bench->last_cycles;
+    bench->last_cycles = cycles;
+
+    slot->busy = false;
+    bench->in_flight--;
+
+    furi_mutex_release(bench->mutex);
+
+    chameleon_bench_issue(bench);
+}
+
+static bool chameleon_bench_submit(ChameleonBench* bench, ChameleonBenchSlot* slot) {
+    if(bench->bulk) {
+        return chameleon_engine_submit_bulk(
+            bench->engine,
+            bench->cmd,
+            bench->request,
+            bench->request_len,
+            chameleon_bench_request_callback,
+            slot);
+    }
+
+    return chameleon_engine_submit(
+        bench->engine,
+        bench->cmd,
+        bench->request,
+        bench->request_len,
+        chameleon_bench_request_callback,
+        slot);
+}
+
+// Submit requests until the case has its depth in flight, or finish it once
+// nothing is left to do. Submits happen outside the mutex, a failed send may
+// complete a request on this thread.
+static void chameleon_bench_issue(ChameleonBench* bench) {
+    while(true) {
+        furi_mutex_acquire(bench->mutex, FuriWaitForever);
+
+        if(chameleon_bench_finish_locked(bench)) {
+            bool success = bench->result.requests > 0;
+            furi_mutex_release(bench->mutex);
+            chameleon_bench_finished(bench, success);
+            break;
+        }
+
+        if(bench->state != ChameleonBenchStateRunning || bench->stopping ||
+           bench->issued >= bench->iterations || bench->in_flight >= bench->depth) {
+            furi_mutex_release(bench->mutex);
+            break;
+        }
+
+        ChameleonBenchSlot* slot = NULL;
+        for(size_t i = 0; i < CHAMELEON_ENGINE_WINDOW; i++) {
+            if(!bench->slots[i].busy) {
+                slot = &bench->slots[i];
+                break;
+            }
+        }
+        furi_check(slot);
+
+        slot->busy = true;
+        slot->start_cycles = chameleon_bench_cycles();
+        bench->issued++;
+        bench->in_flight++;
+
+        furi_mutex_release(bench->mutex);
+
+        if(!chameleon_bench_submit(bench, slot)) {
+            furi_mutex_acquire(bench->mutex, FuriWaitForever);
+            slot->busy = false;
+            bench->in_flight--;
+            bench->errors++;
+            furi_mutex_release(bench->mutex);
+        }
+    }
+}
+
+// Must be called with mutex held
+static void chameleon_bench_run_locked(ChameleonBench* bench) {
+    bench->state = ChameleonBenchStateRunning;
+    bench->last_cycles = chameleon_bench_cycles();
+}
+
+static void chameleon_bench_prepare_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    ChameleonBench* bench = context;
+    bool prepared = result == ChameleonEngineResultOk &&
+                    chameleon_protocol_status_is_success(response->status);
+
+    furi_mutex_acquire(bench->mutex, FuriWaitForever);
+
+    // Write back exactly what was read
+    if(prepared && bench->bench_case == ChameleonBenchCaseMf1Write) {
+        prepared = response->data_len == CHAMELEON_BENCH_MF1_BLOCK_LEN;
+        if(prepared) {
+            memcpy(
+                &bench->request[2 + CHAMELEON_BENCH_MF1_KEY_LEN],
+                response->data,
+                CHAMELEON_BENCH_MF1_BLOCK_LEN);
+        }
+    } else if(prepared) {
+        prepared = response->data_len ==
+                   CHAMELEON_BENCH_EMU_BLOCK_COUNT * CHAMELEON_BENCH_MF1_BLOCK_LEN;
+        if(prepared) {
+            memcpy(&bench->request[1], response->data, response->data_len);
+        }
+    }
+
+    bool run = prepared && !bench->stopping;
+    if(run) {
+        chameleon_bench_run_locked(bench);
+    } else {
+        memset(&bench->result, 0, sizeof(ChameleonBenchResult));
+        free(bench->samples);
+        bench->samples = NULL;
+        bench->state = ChameleonBenchStateIdle;
+    }
+
+    furi_mutex_release(bench->mutex);
+
+    if(run) {
+        chameleon_bench_issue(bench);
+    } else {
+        FURI_LOG_W(TAG, "%s: preparation failed", chameleon_bench_case_names[bench->bench_case]);
+        chameleon_bench_finished(bench, false);
+    }
+}
+
+ChameleonBench* chameleon_bench_alloc(ChameleonEngine* engine) {
+    furi_assert(engine);
+
+    ChameleonBench* bench = malloc(sizeof(ChameleonBench));
+    memset(bench, 0, sizeof(ChameleonBench));
+
+    bench->engine = engine;
+    bench->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    bench->finished = furi_semaphore_alloc(1, 0);
+    bench->joined = true;
+
+    for(size_t i = 0; i < CHAMELEON_ENGINE_WINDOW; i++) {
+        bench->slots[i].bench = bench;
+    }
+
+    return bench;
+}
+
+void chameleon_bench_free(ChameleonBench* bench) {
+    furi_assert(bench);
+
+    chameleon_bench_stop(bench);
+
+    furi_semaphore_free(bench->finished);
+    furi_mutex_free(bench->mutex);
+    free(bench);
+}
+
+const char* chameleon_bench_case_name(ChameleonBenchCase bench_case) {
+    furi_assert(bench_case < ChameleonBenchCaseNum);
+    return chameleon_bench_case_names[bench_case];
+}
+
+bool chameleon_bench_start(
+    ChameleonBench* bench,
+    ChameleonBenchCase bench_case,
+    uint32_t iterations,
+    uint8_t depth,
+    ChameleonBenchCallback callback,
+    void* context) {
+    furi_assert(bench);
+    furi_assert(bench_case < ChameleonBenchCaseNum);
+
+    // Request of the case and the read it needs first, if any
+    uint16_t cmd;
+    uint16_t prepare_cmd = 0;
+    uint8_t prepare[2 + CHAMELEON_BENCH_MF1_KEY_LEN];
+    uint16_t prepare_len = 0;
+
+    switch(bench_case) {
+    case ChameleonBenchCasePing:
+        cmd = CMD_GET_APP_VERSION;
+        break;
+    case ChameleonBenchCaseMf1Read:
+        cmd = CMD_MF1_READ_ONE_BLOCK;
+        break;
+    case ChameleonBenchCaseMf1Write:
+        cmd = CMD_MF1_WRITE_ONE_BLOCK;
+        prepare_cmd = CMD_MF1_READ_ONE_BLOCK;
+        prepare[0] = CHAMELEON_BENCH_MF1_KEY_A;
+        prepare[1] = CHAMELEON_BENCH_MF1_BLOCK;
+        memset(&prepare[2], 0xFF, CHAMELEON_BENCH_MF1_KEY_LEN);
+        prepare_len = 2 + CHAMELEON_BENCH_MF1_KEY_LEN;
+        break;
+    default:
+        cmd = CMD_MF1_WRITE_EMU_BLOCK_DATA;
+        prepare_cmd = CMD_MF1_READ_EMU_BLOCK_DATA;
+        prepare[0] = CHAMELEON_BENCH_EMU_BLOCK_START;
+        prepare[1] = CHAMELEON_BENCH_EMU_BLOCK_COUNT;
+        prepare_len = 2;
+        break;
+    }
+
+    if(!chameleon_engine_supports(bench->engine, cmd) ||
+       (prepare_cmd && !chameleon_engine_supports(bench->engine, prepare_cmd))) {
+        return false;
+    }
+
+    furi_mutex_acquire(bench->mutex, FuriWaitForever);
+
+    if(bench->state != ChameleonBenchStateIdle) {
+        furi_mutex_release(bench->mutex);
+        return false;
+    }
+
+    // The previous case is done, take its token before starting over
+    if(!bench->joined) {
+        furi_mutex_release(bench->mutex);
+        furi_check(furi_semaphore_acquire(bench->finished, FuriWaitForever) == FuriStatusOk);
+        furi_mutex_acquire(bench->mutex, FuriWaitForever);
+    }
+
+    bench->bench_case = bench_case;
+    bench->iterations = CLAMP(iterations, CHAMELEON_BENCH_MAX_ITERATIONS, 1u);
+    bench->depth = CLAMP(depth, CHAMELEON_ENGINE_WINDOW, 1);
+    bench->callback = callback;
+    bench->context = context;
+    bench->cmd = cmd;
+    bench->bulk = bench_case == ChameleonBenchCaseEmuWrite;
+    bench->stopping = false;
+    bench->joined = false;
+    bench->issued = 0;
+    bench->in_flight = 0;
+    bench->errors = 0;
+    bench->sampled = 0;
+    bench->bytes = 0;
+    bench->elapsed_cycles = 0;
+    bench->samples = malloc(bench->iterations * sizeof(uint32_t));
+
+    // Default key A of the MF1 cases, written data is filled in by the read
+    switch(bench_case) {
+    case ChameleonBenchCasePing:
+        bench->request_len = 0;
+        break;
+    case ChameleonBenchCaseMf1Read:
+    case ChameleonBenchCaseMf1Write:
+        bench->request[0] = CHAMELEON_BENCH_MF1_KEY_A;
+        bench->request[1] = CHAMELEON_BENCH_MF1_BLOCK;
+        memset(&bench->request[2], 0xFF, CHAMELEON_BENCH_MF1_KEY_LEN);
+        bench->request_len = 2 + CHAMELEON_BENCH_MF1_KEY_LEN;
+        if(bench_case == ChameleonBenchCaseMf1Write) {
+            bench->request_len += CHAMELEON_BENCH_MF1_BLOCK_LEN;
+        }
+        break;
+    default:
+        bench->request[0] = CHAMELEON_BENCH_EMU_BLOCK_START;
+        bench->request_len = 1 + CHAMELEON_BENCH_EMU_BLOCK_COUNT * CHAMELEON_BENCH_MF1_BLOCK_LEN;
+        break;
+    }
+
+    if(prepare_cmd) {
+        bench->state = ChameleonBenchStatePreparing;
+    } else {
+        chameleon_bench_run_locked(bench);
+    }
+
+    furi_mutex_release(bench->mutex);
+
+    if(!prepare_cmd) {
+        chameleon_bench_issue(bench);
+        return true;
+    }
+
+    if(!chameleon_engine_submit(
+           bench->engine,
+           prepare_cmd,
+           prepare,
+           prepare_len,
+           chameleon_bench_prepare_callback,
+           bench)) {
+        furi_mutex_acquire(bench->mutex, FuriWaitForever);
+        free(bench->samples);
+        bench->samples = NULL;
+        bench->state = ChameleonBenchStateIdle;
+        bench->joined = true;
+        furi_mutex_release(bench->mutex);
+        return false;
+    }
+
+    return true;
+}
+
+void chameleon_bench_stop(ChameleonBench* bench) {
+    furi_assert(bench);
+
+    furi_mutex_acquire(bench->mutex, FuriWaitForever);
+    if(bench->joined) {
+        furi_mutex_release(bench->mutex);
+        return;
+    }
+    bench->stopping = true;
+    furi_mutex_release(bench->mutex);
+
+    // Requests in flight complete or time out, the last one finishes the case
+    furi_check(furi_semaphore_acquire(bench->finished, FuriWaitForever) == FuriStatusOk);
+
+    furi_mutex_acquire(bench->mutex, FuriWaitForever);
+    bench->joined = true;
+    furi_mutex_release(bench->mutex);
+}
+
+void chameleon_bench_get_result(ChameleonBench* bench, ChameleonBenchResult* result) {
+    furi_assert(bench);
+    furi_assert(result);
+
+    furi_mutex_acquire(bench->mutex, FuriWaitForever);
+    *result = bench->result;
+    furi_mutex_release(bench->mutex);
+}
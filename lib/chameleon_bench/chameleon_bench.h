@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../chameleon_engine/chameleon_engine.h"
+
+// Most requests timed per case, one latency sample each
+#define CHAMELEON_BENCH_MAX_ITERATIONS 1000
+
+// Block used by the MF1 reader cases, first data block of sector 1
+#define CHAMELEON_BENCH_MF1_BLOCK 4
+
+// Emulator blocks rewritten per request, the largest whole number of blocks
+// that fits a frame next to the start block byte
+#define CHAMELEON_BENCH_EMU_BLOCK_START 4
+#define CHAMELEON_BENCH_EMU_BLOCK_COUNT ((CHAMELEON_MAX_DATA_LEN - 1) / 16)
+
+// Link benchmark
+//
+// Times a stream of identical requests through the request engine and
+// reports round trip latency and throughput of the link underneath. Up to
+// the given depth of requests is kept in flight, depth 1 measures round
+// trips, deeper runs measure how well the link is kept busy. Write cases
+// first read the data they write, running them leaves the device unchanged.
+// Bulk cases keep at most CHAMELEON_ENGINE_WINDOW - 1 requests in flight.
+typedef struct ChameleonBench ChameleonBench;
+
+typedef enum {
+    ChameleonBenchCasePing, // CMD_GET_APP_VERSION, smallest round trip
+    ChameleonBenchCaseMf1Read, // Reader reads of one block with the default key
+    ChameleonBenchCaseMf1Write, // Reader writes of one block with the default key
+    ChameleonBenchCaseEmuWrite, // Max-size emulator block writes, a bulk job like an upload
+    ChameleonBenchCaseNum,
+} ChameleonBenchCase;
+
+// Results of a finished case, times in microseconds
+typedef struct {
+    uint32_t requests; // Completed with a success status
+    uint32_t errors; // Failed, timed out or completed with an error status
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t elapsed_ms; // First submit to last completion
+    uint32_t requests_per_s;
+    uint32_t bytes_per_s; // Request and response payload bytes
+} ChameleonBenchResult;
+
+// Case completion callback, runs on whichever engine thread completed the
+// last request. Success is false if the case could not be prepared or every
+// request failed.
+typedef void (*ChameleonBenchCallback)(bool success, void* context);
+
+// Create and destroy benchmark, free stops a running case
+ChameleonBench* chameleon_bench_alloc(ChameleonEngine* engine);
+void chameleon_bench_free(ChameleonBench* bench);
+
+// Name of a case for reports
+const char* chameleon_bench_case_name(ChameleonBenchCase bench_case);
+
+// Start a case and return without waiting for it. Depth is clamped to
+// CHAMELEON_ENGINE_WINDOW, iterations to CHAMELEON_BENCH_MAX_ITERATIONS.
+// Returns false if a case is running or the device does not support the
+// commands of the case, the callback is not called in that case.
+bool chameleon_bench_start(
+    ChameleonBench* bench,
+    ChameleonBenchCase bench_case,
+    uint32_t iterations,
+    uint8_t depth,
+    ChameleonBenchCallback callback,
+    void* context);
+
+// Stop submitting and wait for requests in flight, the callback runs as if
+// the case had finished. Returns at once if no case is running.
+void chameleon_bench_stop(ChameleonBench* bench);
+
+// Get results of the last finished case
+void chameleon_bench_get_result(ChameleonBench* bench, ChameleonBenchResult* result);
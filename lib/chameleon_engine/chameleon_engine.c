@@ -0,0 +1,1233 @@
+#include "chameleon_engine.h"
+#include <furi.h>
+#include <string.h>
+
+#define TAG "ChameleonEngine"
+
+typedef enum {
+    ChameleonEngineEventStop = (1 << 0),
+    ChameleonEngineEventTimeout = (1 << 1), // Earliest deadline reached
+    ChameleonEngineEventActivity = (1 << 2), // Lingering job due for a recheck
+} ChameleonEngineEvent;
+
+#define CHAMELEON_ENGINE_EVENTS_ALL \
+    (ChameleonEngineEventStop | ChameleonEngineEventTimeout | ChameleonEngineEventActivity)
+
+typedef enum {
+    ChameleonEnginePendingFree,
+    ChameleonEnginePendingQueued, // Accepted, waiting for a window slot
+    ChameleonEnginePendingSending, // Frame being written, no timeout yet
+    ChameleonEnginePendingWaiting, // Sent, waiting for response or deadline
+} ChameleonEnginePendingState;
+
+typedef struct {
+    ChameleonEnginePendingState state;
+    ChameleonEnginePriority priority;
+    uint16_t cmd;
+    uint32_t order; // Submit order, requests of one priority are sent oldest first
+    uint32_t seq; // Wire order, responses to the same CMD complete oldest first
+    uint32_t last_seq; // Wire order of the latest transmission
+    uint32_t deadline; // Tick at which the current attempt times out
+    uint32_t sent; // Tick of the first transmission
+    uint32_t last_sent; // Tick of the latest transmission
+    ChameleonEngineCallback callback;
+    void* context;
+
+    const ChameleonCommandDescriptor* descriptor;
+    ChameleonEngineLink link;
+    ChameleonEngineRttClass rtt_class;
+    uint8_t attempt; // Retransmissions so far
+    bool retriable;
+    uint16_t payload_len;
+    const uint8_t* payload; // Points at inline or at the caller's buffer
+    uint8_t inline_payload[CHAMELEON_ENGINE_INLINE_PAYLOAD_MAX];
+} ChameleonEnginePending;
+
+// Per-link timeout bounds
+typedef struct {
+    uint16_t rto_min_ms; // Floor below which a response cannot be expected
+    uint8_t rto_max_scale; // Ceiling as a multiple of the command's default timeout
+} ChameleonEngineLinkProfile;
+
+static const ChameleonEngineLinkProfile chameleon_engine_links[ChameleonEngineLinkNum] = {
+    [ChameleonEngineLinkUsb] = {.rto_min_ms = 50, .rto_max_scale = 1},
+    [ChameleonEngineLinkBle] = {.rto_min_ms = 300, .rto_max_scale = 2},
+};
+
+// Doublings of the timeout carried over to later requests after timeouts
+#define CHAMELEON_ENGINE_BACKOFF_MAX 4
+
+// Round trip estimator in Jacobson's scaled form, srtt * 8 and rttvar * 4
+typedef struct {
+    uint32_t samples;
+    int32_t srtt8;
+    int32_t rttvar4;
+    uint8_t backoff; // Kept until the next sample, late replies give none
+} ChameleonEngineEstimator;
+
+// Replies still owed for transmissions of a completed request. Frames carry
+// no sequence number, a late reply would otherwise complete the next request
+// with the same CMD, so those wait in the queue until the replies are in or
+// count as lost.
+typedef struct {
+    uint16_t cmd;
+    uint8_t count; // 0 marks a free entry
+    uint32_t seq; // Wire order of the request's latest transmission
+    uint32_t expires; // Latest transmission plus the longest reply time
+} ChameleonEngineDuplicate;
+
+// Completion collected under the lock and delivered after releasing it
+typedef struct {
+    ChameleonEngineCallback callback;
+    void* context;
+    ChameleonEngineResult result;
+    bool bulk;
+} ChameleonEngineCompletion;
+
+struct ChameleonEngine {
+    ChameleonFrameDecoder* decoder;
+    FuriMutex* mutex;
+    FuriMutex* tx_mutex; // Serializes frames, keeps submit order equal to wire order
+    FuriTimer* timer; // Armed for the earliest pending deadline
+    FuriThread* thread; // Handles expired deadlines, timers only wake it
+
+    ChameleonEnginePending pending[CHAMELEON_ENGINE_MAX_REQUESTS];
+    ChameleonEngineDuplicate duplicates[CHAMELEON_ENGINE_MAX_REQUESTS];
+    uint32_t next_order;
+    uint32_t next_seq;
+    size_t active; // Queued and in flight
+    size_t completing; // Freed, callback not yet returned
+    size_t in_flight; // Sending and waiting
+    size_t bulk_in_flight;
+    uint8_t interactive_burst; // Interactive sends since bulk last got a turn
+
+    FuriSemaphore* idle; // Posted when the last callback has returned
+    bool idle_wanted;
+
+    FuriSemaphore* released; // Receive path blocks here while a response is lent
+    bool lent; // Guarded by mutex
+
+    // Set by chameleon_engine_reset, the receive path resets the decoder
+    // before feeding more bytes. Guarded by mutex.
+    bool rx_reset;
+
+    // Activity tracking, a job lingers on for a while after its last request
+    FuriTimer* activity_timer; // Armed while a job lingers
+    size_t bulk_active; // Bulk requests accepted whose callback has not returned
+    bool bulk_lingering;
+    uint32_t bulk_tick; // Last bulk callback returned
+    bool busy_lingering;
+    uint32_t busy_tick; // Last callback returned
+    ChameleonEngineActivityCallback activity_callback;
+    void* activity_context;
+
+    // Serializes activity callbacks, guards activity
+    FuriMutex* activity_mutex;
+    ChameleonEngineActivity activity;
+
+    ChameleonCommandSet capabilities;
+    bool capabilities_known;
+
+    ChameleonEngineLink link;
+    uint8_t retries;
+    ChameleonEngineEstimator estimators[ChameleonEngineLinkNum][ChameleonEngineRttClassNum];
+    ChameleonEngineStats stats;
+
+    ChameleonTransport transport; // Guarded by tx_mutex
+};
+
+// Blocking request state, lives on the caller's stack
+typedef struct {
+    ChameleonEngine* engine;
+    FuriSemaphore* done;
+    ChameleonEngineResult result;
+    ChameleonFrameView response;
+} ChameleonEngineWaiter;
+
+// Must be called with mutex held
+static void chameleon_engine_pending_free(ChameleonEngine* engine, ChameleonEnginePending* pending) {
+    if(pending->state != ChameleonEnginePendingQueued) {
+        furi_assert(engine->in_flight > 0);
+        engine->in_flight--;
+        if(pending->priority == ChameleonEnginePriorityBulk) {
+            furi_assert(engine->bulk_in_flight > 0);
+            engine->bulk_in_flight--;
+        }
+    }
+
+    pending->state = ChameleonEnginePendingFree;
+    furi_assert(engine->active > 0);
+    engine->active--;
+
+    // Every freed request owes its callback one call
+    engine->completing++;
+}
+
+// Must be called with mutex held, wait_ms is set while a job lingers
+static ChameleonEngineActivity
+    chameleon_engine_activity_locked(ChameleonEngine* engine, uint32_t* wait_ms) {
+    uint32_t now = furi_get_tick();
+    *wait_ms = 0;
+
+    if(engine->bulk_active > 0) {
+        return ChameleonEngineActivityBulk;
+    }
+
+    if(engine->bulk_lingering) {
+        uint32_t elapsed = now - engine->bulk_tick;
+        if(elapsed < CHAMELEON_ENGINE_BULK_LINGER_MS) {
+            *wait_ms = CHAMELEON_ENGINE_BULK_LINGER_MS - elapsed;
+            return ChameleonEngineActivityBulk;
+        }
+        engine->bulk_lingering = false;
+    }
+
+    if(engine->active > 0 || engine->completing > 0) {
+        return ChameleonEngineActivityInteractive;
+    }
+
+    if(engine->busy_lingering) {
+        uint32_t elapsed = now - engine->busy_tick;
+        if(elapsed < CHAMELEON_ENGINE_IDLE_AFTER_MS) {
+            *wait_ms = CHAMELEON_ENGINE_IDLE_AFTER_MS - elapsed;
+            return ChameleonEngineActivityInteractive;
+        }
+        engine->busy_lingering = false;
+    }
+
+    return ChameleonEngineActivityIdle;
+}
+
+// Report an activity change, the callback always sees the latest state
+static void chameleon_engine_activity_update(ChameleonEngine* engine) {
+    furi_mutex_acquire(engine->activity_mutex, FuriWaitForever);
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    uint32_t wait_ms;
+    ChameleonEngineActivity activity = chameleon_engine_activity_locked(engine, &wait_ms);
+
+    // An armed timer re-evaluates when it fires and waits out the rest
+    if(wait_ms > 0 && !furi_timer_is_running(engine->activity_timer)) {
+        furi_timer_start(engine->activity_timer, wait_ms);
+    }
+
+    ChameleonEngineActivityCallback callback = engine->activity_callback;
+    void* context = engine->activity_context;
+
+    furi_mutex_release(engine->mutex);
+
+    if(activity != engine->activity) {
+        engine->activity = activity;
+        if(callback) callback(activity, context);
+    }
+
+    furi_mutex_release(engine->activity_mutex);
+}
+
+// Timer callbacks must not block, the engine thread does the work
+static void chameleon_engine_activity_timer_callback(void* context) {
+    ChameleonEngine* engine = context;
+    furi_thread_flags_set(furi_thread_get_id(engine->thread), ChameleonEngineEventActivity);
+}
+
+// Account for callbacks that have returned, bulk_count of them bulk
+static void chameleon_engine_completed(ChameleonEngine* engine, size_t count, size_t bulk_count) {
+    if(count == 0) return;
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    furi_assert(engine->completing >= count);
+    engine->completing -= count;
+    furi_assert(engine->bulk_active >= bulk_count);
+    engine->bulk_active -= bulk_count;
+
+    // A job ends once nothing of it is left, it lingers from here
+    bool update = false;
+    if(bulk_count > 0 && engine->bulk_active == 0) {
+        engine->bulk_lingering = true;
+        engine->bulk_tick = furi_get_tick();
+        update = true;
+    }
+
+    if(engine->active == 0 && engine->completing == 0) {
+        engine->busy_lingering = true;
+        engine->busy_tick = furi_get_tick();
+        update = true;
+
+        if(engine->idle_wanted) {
+            engine->idle_wanted = false;
+            furi_semaphore_release(engine->idle);
+        }
+    }
+
+    furi_mutex_release(engine->mutex);
+
+    if(update) {
+        chameleon_engine_activity_update(engine);
+    }
+}
+
+// Must be called with mutex held
+static void chameleon_engine_complete(
+    ChameleonEngine* engine,
+    ChameleonEnginePending* pending,
+    ChameleonEngineResult result,
+    ChameleonEngineCompletion* completions,
+    size_t* count) {
+    completions[*count].callback = pending->callback;
+    completions[*count].context = pending->context;
+    completions[*count].result = result;
+    completions[*count].bulk = pending->priority == ChameleonEnginePriorityBulk;
+    (*count)++;
+    chameleon_engine_pending_free(engine, pending);
+}
+
+static void chameleon_engine_deliver(
+    ChameleonEngine* engine,
+    const ChameleonEngineCompletion* completions,
+    size_t count) {
+    size_t bulk_count = 0;
+    for(size_t i = 0; i < count; i++) {
+        completions[i].callback(completions[i].result, NULL, completions[i].context);
+        if(completions[i].bulk) bulk_count++;
+    }
+
+    chameleon_engine_completed(engine, count, bulk_count);
+}
+
+static ChameleonEngineRttClass
+    chameleon_engine_rtt_class(const ChameleonCommandDescriptor* descriptor) {
+    if(descriptor->timeout_ms > CHAMELEON_ENGINE_RTT_LONG_MS) {
+        return ChameleonEngineRttClassLong;
+    } else if(descriptor->cmd >= 2000 && descriptor->cmd < 4000) {
+        return ChameleonEngineRttClassRadio;
+    }
+
+    return ChameleonEngineRttClassDevice;
+}
+
+// Must be called with mutex held
+static void chameleon_engine_rtt_sample(
+    ChameleonEngine* engine,
+    const ChameleonEnginePending* pending,
+    uint32_t rtt) {
+    ChameleonEngineEstimator* estimator = &engine->estimators[pending->link][pending->rtt_class];
+
+    if(estimator->samples == 0) {
+        estimator->srtt8 = rtt << 3;
+        estimator->rttvar4 = rtt << 1;
+    } else {
+        int32_t error = (int32_t)rtt - (estimator->srtt8 >> 3);
+        estimator->srtt8 += error;
+        if(error < 0) error = -error;
+        estimator->rttvar4 += error - (estimator->rttvar4 >> 2);
+    }
+
+    estimator->samples++;
+    estimator->backoff = 0;
+}
+
+// Longest wait for any attempt, a reply arriving later counts as lost
+static uint32_t chameleon_engine_rto_max(const ChameleonEnginePending* pending) {
+    return pending->descriptor->timeout_ms * chameleon_engine_links[pending->link].rto_max_scale;
+}
+
+// Timeout of an attempt: srtt + 4 * rttvar, clamped to the link bounds and
+// doubled per retransmission and per timeout since the last sample. The
+// default timeout applies until sampled.
+// Must be called with mutex held
+static uint32_t chameleon_engine_rto(ChameleonEngine* engine, const ChameleonEnginePending* pending) {
+    const ChameleonEngineLinkProfile* profile = &chameleon_engine_links[pending->link];
+    const ChameleonEngineEstimator* estimator =
+        &engine->estimators[pending->link][pending->rtt_class];
+
+    uint32_t rto_max = chameleon_engine_rto_max(pending);
+    uint32_t rto_min = MIN((uint32_t)profile->rto_min_ms, rto_max);
+    uint32_t rto = pending->descriptor->timeout_ms;
+
+    if(estimator->samples > 0) {
+        rto = (estimator->srtt8 >> 3) + estimator->rttvar4;
+    }
+
+    // Saturates at rto_max rather than shifting bits out
+    uint32_t shift = MIN(pending->attempt + estimator->backoff, 31);
+    rto = CLAMP(rto, rto_max, rto_min);
+    rto = rto > (rto_max >> shift) ? rto_max : rto << shift;
+
+    return rto;
+}
+
+static void chameleon_engine_timer_arm(ChameleonEngine* engine);
+
+static bool
+    chameleon_engine_duplicate_live(const ChameleonEngineDuplicate* duplicate, uint32_t now) {
+    return duplicate->count > 0 && (int32_t)(now - duplicate->expires) < 0;
+}
+
+// Expect the late replies of a completed request, count of its transmissions
+// went unanswered. Each is a late reply or was lost, which cannot be told
+// apart, and either way none comes later than rto_max after the transmission.
+// Must be called with mutex held
+static void chameleon_engine_expect_duplicates(
+    ChameleonEngine* engine,
+    const ChameleonEnginePending* pending,
+    uint8_t count) {
+    uint32_t now = furi_get_tick();
+    uint32_t expires = pending->last_sent + chameleon_engine_rto_max(pending);
+    if(count == 0 || (int32_t)(now - expires) >= 0) return;
+
+    // A full table gives up the copies most likely lost, those expiring first
+    ChameleonEngineDuplicate* entry = NULL;
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEngineDuplicate* duplicate = &engine->duplicates[i];
+        if(!chameleon_engine_duplicate_live(duplicate, now)) {
+            entry = duplicate;
+            break;
+        }
+        if(!entry || (int32_t)(duplicate->expires - entry->expires) < 0) {
+            entry = duplicate;
+        }
+    }
+
+    entry->cmd = pending->cmd;
+    entry->count = count;
+    entry->seq = pending->last_seq;
+    entry->expires = expires;
+
+    // Wakes the engine thread to send held requests should the copies be lost
+    chameleon_engine_timer_arm(engine);
+}
+
+// Consume an expected copy of an earlier request's reply, oldest request first
+// Must be called with mutex held
+static bool chameleon_engine_take_duplicate(ChameleonEngine* engine, uint16_t cmd) {
+    uint32_t now = furi_get_tick();
+    ChameleonEngineDuplicate* oldest = NULL;
+
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEngineDuplicate* duplicate = &engine->duplicates[i];
+        if(chameleon_engine_duplicate_live(duplicate, now) && duplicate->cmd == cmd &&
+           (!oldest || (int32_t)(duplicate->seq - oldest->seq) < 0)) {
+            oldest = duplicate;
+        }
+    }
+
+    if(oldest) {
+        oldest->count--;
+    }
+
+    return oldest != NULL;
+}
+
+// The device answers in wire order. Once a request sent only once is answered,
+// every reply to transmissions before it has arrived or was lost.
+// Must be called with mutex held
+static void chameleon_engine_settle_duplicates(ChameleonEngine* engine, uint32_t seq) {
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEngineDuplicate* duplicate = &engine->duplicates[i];
+        if(duplicate->count > 0 && (int32_t)(duplicate->seq - seq) < 0) {
+            duplicate->count = 0;
+        }
+    }
+}
+
+// Check for replies still owed to an earlier request with this CMD
+// Must be called with mutex held
+static bool chameleon_engine_cmd_owed(ChameleonEngine* engine, uint16_t cmd, uint32_t now) {
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        const ChameleonEngineDuplicate* duplicate = &engine->duplicates[i];
+        if(chameleon_engine_duplicate_live(duplicate, now) && duplicate->cmd == cmd) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Check for another request with the same CMD on the wire
+// Must be called with mutex held
+static bool chameleon_engine_cmd_in_flight(
+    ChameleonEngine* engine,
+    const ChameleonEnginePending* pending) {
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        const ChameleonEnginePending* other = &engine->pending[i];
+        if(other != pending && other->cmd == pending->cmd &&
+           (other->state == ChameleonEnginePendingSending ||
+            other->state == ChameleonEnginePendingWaiting)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Must be called with mutex held
+static void chameleon_engine_timer_arm(ChameleonEngine* engine) {
+    uint32_t now = furi_get_tick();
+    bool armed = false;
+    uint32_t deadline = 0;
+
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEnginePending* pending = &engine->pending[i];
+        if(pending->state != ChameleonEnginePendingWaiting) continue;
+        if(!armed || (int32_t)(pending->deadline - deadline) < 0) {
+            deadline = pending->deadline;
+            armed = true;
+        }
+    }
+
+    // Requests held back for owed replies go out once those count as lost
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEngineDuplicate* duplicate = &engine->duplicates[i];
+        if(!chameleon_engine_duplicate_live(duplicate, now)) continue;
+        if(!armed || (int32_t)(duplicate->expires - deadline) < 0) {
+            deadline = duplicate->expires;
+            armed = true;
+        }
+    }
+
+    // A stale expiry finds nothing due and does not rearm, no need to stop
+    if(armed) {
+        int32_t remaining = (int32_t)(deadline - now);
+        furi_timer_start(engine->timer, remaining > 0 ? (uint32_t)remaining : 1);
+    }
+}
+
+static bool chameleon_engine_send(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len) {
+    uint8_t header[CHAMELEON_HEADER_LEN];
+
+    if(!chameleon_protocol_build_header(cmd, data_len, header)) {
+        FURI_LOG_E(TAG, "Failed to build command 0x%04X", cmd);
+        return false;
+    }
+
+    uint8_t trailer = chameleon_protocol_build_trailer(data, data_len);
+
+    return chameleon_transport_send(
+        &engine->transport, header, sizeof(header), data, data_len, &trailer, 1);
+}
+
+// Pick the next queued request for the window. Interactive requests go first,
+// bulk requests get a turn after CHAMELEON_ENGINE_INTERACTIVE_BURST interactive
+// ones and never take the last window slot.
+// Must be called with mutex held
+static ChameleonEnginePending* chameleon_engine_next(ChameleonEngine* engine) {
+    if(engine->in_flight >= CHAMELEON_ENGINE_WINDOW) return NULL;
+
+    ChameleonEnginePending* oldest[ChameleonEnginePriorityNum] = {NULL};
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEnginePending* pending = &engine->pending[i];
+        if(pending->state != ChameleonEnginePendingQueued) continue;
+
+        ChameleonEnginePending** slot = &oldest[pending->priority];
+        if(!*slot || (int32_t)(pending->order - (*slot)->order) < 0) {
+            *slot = pending;
+        }
+    }
+
+    // A request whose CMD still has replies owed waits for them, and keeps
+    // the requests of its priority behind it in order
+    uint32_t now = furi_get_tick();
+    for(size_t priority = 0; priority < ChameleonEnginePriorityNum; priority++) {
+        if(oldest[priority] && chameleon_engine_cmd_owed(engine, oldest[priority]->cmd, now)) {
+            oldest[priority] = NULL;
+        }
+    }
+
+    ChameleonEnginePending* interactive = oldest[ChameleonEnginePriorityInteractive];
+    ChameleonEnginePending* bulk = oldest[ChameleonEnginePriorityBulk];
+    if(bulk && engine->bulk_in_flight >= CHAMELEON_ENGINE_WINDOW - 1) {
+        bulk = NULL;
+    }
+
+    if(interactive && (!bulk || engine->interactive_burst < CHAMELEON_ENGINE_INTERACTIVE_BURST)) {
+        if(bulk) engine->interactive_burst++;
+        return interactive;
+    }
+
+    engine->interactive_burst = 0;
+    return bulk;
+}
+
+// Send queued requests while the window has room. Requests that fail to send
+// are collected for completion after tx_mutex is released.
+// Must be called with tx_mutex held
+static void chameleon_engine_dispatch(
+    ChameleonEngine* engine,
+    ChameleonEngineCompletion* completions,
+    size_t* count) {
+    while(true) {
+        furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+        ChameleonEnginePending* pending = chameleon_engine_next(engine);
+        if(!pending) {
+            furi_mutex_release(engine->mutex);
+            break;
+        }
+
+        uint32_t seq = engine->next_seq++;
+        pending->state = ChameleonEnginePendingSending;
+        pending->seq = seq;
+        pending->last_seq = seq;
+        engine->in_flight++;
+        if(pending->priority == ChameleonEnginePriorityBulk) {
+            engine->bulk_in_flight++;
+        }
+
+        furi_mutex_release(engine->mutex);
+
+        // Entries are only refilled under tx_mutex, the payload stays put
+        bool sent =
+            chameleon_engine_send(engine, pending->cmd, pending->payload, pending->payload_len);
+
+        furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+        // The response may already have completed the request while sending
+        if(pending->state == ChameleonEnginePendingSending && pending->seq == seq) {
+            if(sent) {
+                pending->state = ChameleonEnginePendingWaiting;
+                pending->sent = furi_get_tick();
+                pending->last_sent = pending->sent;
+                pending->deadline = pending->sent + chameleon_engine_rto(engine, pending);
+                chameleon_engine_timer_arm(engine);
+            } else {
+                FURI_LOG_E(TAG, "%s: send failed", pending->descriptor->name);
+                chameleon_engine_complete(
+                    engine, pending, ChameleonEngineResultSendFailed, completions, count);
+            }
+        }
+
+        furi_mutex_release(engine->mutex);
+    }
+}
+
+static void chameleon_engine_timer_callback(void* context) {
+    ChameleonEngine* engine = context;
+    furi_thread_flags_set(furi_thread_get_id(engine->thread), ChameleonEngineEventTimeout);
+}
+
+// Time out or retransmit requests past their deadline, runs on the engine thread
+static void chameleon_engine_expire(ChameleonEngine* engine) {
+    // Each entry completes at most once, expired or failed to send
+    ChameleonEngineCompletion completions[CHAMELEON_ENGINE_MAX_REQUESTS];
+    size_t count = 0;
+    uint32_t retransmit = 0; // Bit per pending entry
+
+    // Retransmissions are frames like any other, keep them in wire order
+    furi_mutex_acquire(engine->tx_mutex, FuriWaitForever);
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    uint32_t now = furi_get_tick();
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEnginePending* pending = &engine->pending[i];
+        if(pending->state != ChameleonEnginePendingWaiting ||
+           (int32_t)(now - pending->deadline) < 0) {
+            continue;
+        }
+
+        // Replies to a retransmitted request arrive ahead of those to requests
+        // sent after it, but cannot be told apart from those sent before
+        if(pending->retriable && pending->attempt < engine->retries &&
+           !chameleon_engine_cmd_in_flight(engine, pending)) {
+            pending->attempt++;
+            pending->last_seq = engine->next_seq++;
+            pending->last_sent = now;
+            pending->deadline = now + chameleon_engine_rto(engine, pending);
+            engine->stats.retransmits++;
+            retransmit |= 1UL << i;
+            continue;
+        }
+
+        FURI_LOG_W(TAG, "Timeout waiting for %s response", pending->descriptor->name);
+        engine->stats.timeouts++;
+        chameleon_engine_expect_duplicates(engine, pending, pending->attempt + 1);
+
+        // Back off later requests as well, the estimate was too low
+        ChameleonEngineEstimator* estimator =
+            &engine->estimators[pending->link][pending->rtt_class];
+        if(estimator->backoff < CHAMELEON_ENGINE_BACKOFF_MAX) {
+            estimator->backoff++;
+        }
+
+        chameleon_engine_complete(
+            engine, pending, ChameleonEngineResultTimeout, completions, &count);
+    }
+
+    chameleon_engine_timer_arm(engine);
+
+    furi_mutex_release(engine->mutex);
+
+    // Holding tx_mutex keeps entries from being reused, a response completing
+    // one meanwhile only frees it and the payload stays intact
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        if(!(retransmit & (1UL << i))) continue;
+
+        ChameleonEnginePending* pending = &engine->pending[i];
+        FURI_LOG_D(TAG, "Retransmitting %s (%u)", pending->descriptor->name, pending->attempt);
+        chameleon_engine_send(engine, pending->cmd, pending->payload, pending->payload_len);
+    }
+
+    // Timeouts free window slots for queued requests
+    chameleon_engine_dispatch(engine, completions, &count);
+
+    furi_mutex_release(engine->tx_mutex);
+
+    chameleon_engine_deliver(engine, completions, count);
+}
+
+static int32_t chameleon_engine_thread(void* context) {
+    ChameleonEngine* engine = context;
+
+    while(true) {
+        uint32_t events =
+            furi_thread_flags_wait(CHAMELEON_ENGINE_EVENTS_ALL, FuriFlagWaitAny, FuriWaitForever);
+        furi_check(!(events & FuriFlagError));
+
+        if(events & ChameleonEngineEventStop) break;
+
+        if(events & ChameleonEngineEventTimeout) {
+            chameleon_engine_expire(engine);
+        }
+
+        if(events & ChameleonEngineEventActivity) {
+            chameleon_engine_activity_update(engine);
+        }
+    }
+
+    return 0;
+}
+
+// Send what the window has room for, outside any lock
+static void chameleon_engine_refill(ChameleonEngine* engine) {
+    ChameleonEngineCompletion completions[CHAMELEON_ENGINE_MAX_REQUESTS];
+    size_t count = 0;
+
+    furi_mutex_acquire(engine->tx_mutex, FuriWaitForever);
+    chameleon_engine_dispatch(engine, completions, &count);
+    furi_mutex_release(engine->tx_mutex);
+
+    chameleon_engine_deliver(engine, completions, count);
+}
+
+static void chameleon_engine_frame_callback(const ChameleonFrameView* view, void* context) {
+    ChameleonEngine* engine = context;
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    if(chameleon_engine_take_duplicate(engine, view->cmd)) {
+        engine->stats.duplicates++;
+        furi_mutex_release(engine->mutex);
+        FURI_LOG_D(TAG, "Dropped duplicate response for CMD 0x%04X", view->cmd);
+
+        // Requests with this CMD may have been waiting for it
+        chameleon_engine_refill(engine);
+        return;
+    }
+
+    ChameleonEnginePending* match = NULL;
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEnginePending* pending = &engine->pending[i];
+        if((pending->state == ChameleonEnginePendingSending ||
+            pending->state == ChameleonEnginePendingWaiting) &&
+           pending->cmd == view->cmd &&
+           (!match || (int32_t)(pending->seq - match->seq) < 0)) {
+            match = pending;
+        }
+    }
+
+    if(!match) {
+        engine->stats.unexpected++;
+        furi_mutex_release(engine->mutex);
+        FURI_LOG_W(TAG, "Unexpected response for CMD 0x%04X", view->cmd);
+        return;
+    }
+
+    // Karn: a retransmitted request's response cannot be attributed to one attempt
+    if(match->attempt == 0 && match->state == ChameleonEnginePendingWaiting) {
+        chameleon_engine_rtt_sample(engine, match, furi_get_tick() - match->sent);
+    }
+    if(match->attempt == 0) {
+        chameleon_engine_settle_duplicates(engine, match->seq);
+    }
+    chameleon_engine_expect_duplicates(engine, match, match->attempt);
+    engine->stats.completed++;
+
+    ChameleonEngineCallback callback = match->callback;
+    void* callback_context = match->context;
+    bool bulk = match->priority == ChameleonEnginePriorityBulk;
+    chameleon_engine_pending_free(engine, match);
+
+    furi_mutex_release(engine->mutex);
+
+    // Refill the window at this frame boundary before the callback runs, a
+    // blocking request may hold the receive path until it is released
+    chameleon_engine_refill(engine);
+
+    ChameleonEngineResult result = ChameleonEngineResultOk;
+
+    const ChameleonCommandDescriptor* descriptor = chameleon_protocol_get_command(view->cmd);
+    if(chameleon_protocol_status_is_success(view->status) &&
+       (view->data_len < descriptor->response_min || view->data_len > descriptor->response_max)) {
+        FURI_LOG_E(
+            TAG,
+            "%s: response length %u outside %u..%u",
+            descriptor->name,
+            view->data_len,
+            descriptor->response_min,
+            descriptor->response_max);
+        result = ChameleonEngineResultInvalid;
+    }
+
+    callback(result, result == ChameleonEngineResultOk ? view : NULL, callback_context);
+
+    chameleon_engine_completed(engine, 1, bulk ? 1 : 0);
+}
+
+ChameleonEngine* chameleon_engine_alloc() {
+    ChameleonEngine* engine = malloc(sizeof(ChameleonEngine));
+    memset(engine, 0, sizeof(ChameleonEngine));
+
+    engine->decoder = chameleon_frame_decoder_alloc();
+    chameleon_frame_decoder_set_callback(engine->decoder, chameleon_engine_frame_callback, engine);
+
+    engine->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    engine->tx_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    engine->timer = furi_timer_alloc(chameleon_engine_timer_callback, FuriTimerTypeOnce, engine);
+    engine->idle = furi_semaphore_alloc(1, 0);
+    engine->released = furi_semaphore_alloc(1, 0);
+    engine->activity_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    engine->activity_timer =
+        furi_timer_alloc(chameleon_engine_activity_timer_callback, FuriTimerTypeOnce, engine);
+
+    engine->thread = furi_thread_alloc();
+    furi_thread_set_name(engine->thread, "ChameleonEngine");
+    furi_thread_set_stack_size(engine->thread, 2048);
+    furi_thread_set_context(engine->thread, engine);
+    furi_thread_set_callback(engine->thread, chameleon_engine_thread);
+    furi_thread_start(engine->thread);
+
+    engine->link = ChameleonEngineLinkUsb;
+    engine->retries = CHAMELEON_ENGINE_DEFAULT_RETRIES;
+
+    return engine;
+}
+
+void chameleon_engine_free(ChameleonEngine* engine) {
+    furi_assert(engine);
+
+    furi_timer_stop(engine->timer);
+    furi_timer_free(engine->timer);
+    furi_timer_stop(engine->activity_timer);
+    furi_timer_free(engine->activity_timer);
+
+    // The timers are gone, nothing wakes the thread but the stop
+    furi_thread_flags_set(furi_thread_get_id(engine->thread), ChameleonEngineEventStop);
+    furi_thread_join(engine->thread);
+    furi_thread_free(engine->thread);
+
+    // Checked once the thread cannot be delivering an expiry any more
+    furi_assert(engine->active == 0 && engine->completing == 0);
+
+    furi_mutex_free(engine->activity_mutex);
+
+    furi_semaphore_free(engine->released);
+    furi_semaphore_free(engine->idle);
+    furi_mutex_free(engine->tx_mutex);
+    furi_mutex_free(engine->mutex);
+    chameleon_frame_decoder_free(engine->decoder);
+
+    free(engine);
+}
+
+static void chameleon_engine_transport_rx_callback(
+    const uint8_t* data,
+    size_t length,
+    void* context) {
+    chameleon_engine_feed(context, data, length);
+}
+
+void chameleon_engine_set_transport(ChameleonEngine* engine, const ChameleonTransport* transport) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->tx_mutex, FuriWaitForever);
+
+    if(chameleon_transport_is_bound(&engine->transport)) {
+        chameleon_transport_set_rx_callback(&engine->transport, NULL, NULL);
+        chameleon_transport_set_frame_callback(&engine->transport, NULL, NULL);
+    }
+
+    chameleon_transport_init(
+        &engine->transport,
+        transport ? transport->interface : NULL,
+        transport ? transport->instance : NULL);
+
+    // Frames checked by the transport skip the decoder
+    if(transport && chameleon_transport_delivers_frames(&engine->transport)) {
+        chameleon_transport_set_frame_callback(
+            &engine->transport, chameleon_engine_frame_callback, engine);
+    } else if(transport) {
+        chameleon_transport_set_rx_callback(
+            &engine->transport, chameleon_engine_transport_rx_callback, engine);
+    }
+
+    furi_mutex_release(engine->tx_mutex);
+}
+
+void chameleon_engine_reset(ChameleonEngine* engine) {
+    furi_assert(engine);
+    ChameleonEngineCompletion cancelled[CHAMELEON_ENGINE_MAX_REQUESTS];
+    size_t count = 0;
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    // The decoder belongs to the receive path, which may be feeding it now
+    engine->rx_reset = true;
+    engine->capabilities_known = false;
+    memset(engine->duplicates, 0, sizeof(engine->duplicates));
+
+    // A request being written is dropped too, its send finds the entry freed
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        ChameleonEnginePending* pending = &engine->pending[i];
+        if(pending->state != ChameleonEnginePendingFree) {
+            chameleon_engine_complete(
+                engine, pending, ChameleonEngineResultCancelled, cancelled, &count);
+        }
+    }
+    engine->interactive_burst = 0;
+
+    furi_mutex_release(engine->mutex);
+
+    chameleon_engine_deliver(engine, cancelled, count);
+}
+
+void chameleon_engine_set_link(ChameleonEngine* engine, ChameleonEngineLink link) {
+    furi_assert(engine);
+    furi_assert(link < ChameleonEngineLinkNum);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    engine->link = link;
+    furi_mutex_release(engine->mutex);
+}
+
+void chameleon_engine_set_retries(ChameleonEngine* engine, uint8_t retries) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    engine->retries = MIN(retries, CHAMELEON_ENGINE_MAX_RETRIES);
+    furi_mutex_release(engine->mutex);
+}
+
+void chameleon_engine_set_activity_callback(
+    ChameleonEngine* engine,
+    ChameleonEngineActivityCallback callback,
+    void* context) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    engine->activity_callback = callback;
+    engine->activity_context = context;
+    furi_mutex_release(engine->mutex);
+}
+
+ChameleonEngineActivity chameleon_engine_get_activity(ChameleonEngine* engine) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->activity_mutex, FuriWaitForever);
+    ChameleonEngineActivity activity = engine->activity;
+    furi_mutex_release(engine->activity_mutex);
+
+    return activity;
+}
+
+void chameleon_engine_get_rtt(
+    ChameleonEngine* engine,
+    ChameleonEngineLink link,
+    ChameleonEngineRttClass rtt_class,
+    ChameleonEngineRtt* rtt) {
+    furi_assert(engine);
+    furi_assert(link < ChameleonEngineLinkNum);
+    furi_assert(rtt_class < ChameleonEngineRttClassNum);
+    furi_assert(rtt);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    const ChameleonEngineEstimator* estimator = &engine->estimators[link][rtt_class];
+    const ChameleonEngineLinkProfile* profile = &chameleon_engine_links[link];
+
+    rtt->samples = estimator->samples;
+    rtt->srtt_ms = estimator->srtt8 >> 3;
+    rtt->rttvar_ms = estimator->rttvar4 >> 2;
+    rtt->rto_ms = MAX(rtt->srtt_ms + (uint32_t)estimator->rttvar4, (uint32_t)profile->rto_min_ms);
+
+    furi_mutex_release(engine->mutex);
+}
+
+void chameleon_engine_get_stats(ChameleonEngine* engine, ChameleonEngineStats* stats) {
+    furi_assert(engine);
+    furi_assert(stats);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    *stats = engine->stats;
+    furi_mutex_release(engine->mutex);
+}
+
+void chameleon_engine_set_capabilities(
+    ChameleonEngine* engine,
+    const ChameleonCommandSet* capabilities) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    if(capabilities) {
+        engine->capabilities = *capabilities;
+    }
+    engine->capabilities_known = capabilities != NULL;
+    furi_mutex_release(engine->mutex);
+}
+
+// Must be called with mutex held
+static bool chameleon_engine_supports_locked(ChameleonEngine* engine, uint16_t cmd) {
+    return !engine->capabilities_known ||
+           chameleon_command_set_contains(&engine->capabilities, cmd);
+}
+
+bool chameleon_engine_supports(ChameleonEngine* engine, uint16_t cmd) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    bool supported = chameleon_engine_supports_locked(engine, cmd);
+    furi_mutex_release(engine->mutex);
+
+    return supported;
+}
+
+void chameleon_engine_feed(ChameleonEngine* engine, const uint8_t* data, size_t length) {
+    furi_assert(engine);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    bool reset = engine->rx_reset;
+    engine->rx_reset = false;
+    furi_mutex_release(engine->mutex);
+
+    if(reset) {
+        chameleon_frame_decoder_reset(engine->decoder);
+    }
+
+    chameleon_frame_decoder_feed(engine->decoder, data, length);
+}
+
+static bool chameleon_engine_enqueue(
+    ChameleonEngine* engine,
+    ChameleonEnginePriority priority,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonEngineCallback callback,
+    void* context) {
+    furi_assert(engine);
+    furi_assert(callback);
+
+    const ChameleonCommandDescriptor* descriptor = chameleon_protocol_get_command(cmd);
+    if(!descriptor) {
+        FURI_LOG_E(TAG, "Unknown command 0x%04X", cmd);
+        return false;
+    }
+
+    if(data_len < descriptor->request_min || data_len > descriptor->request_max) {
+        FURI_LOG_E(
+            TAG,
+            "%s: request length %u outside %u..%u",
+            descriptor->name,
+            data_len,
+            descriptor->request_min,
+            descriptor->request_max);
+        return false;
+    }
+
+    furi_mutex_acquire(engine->tx_mutex, FuriWaitForever);
+
+    if(!chameleon_transport_is_bound(&engine->transport)) {
+        furi_mutex_release(engine->tx_mutex);
+        FURI_LOG_E(TAG, "Not connected");
+        return false;
+    }
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+
+    // Fail fast instead of waiting out the timeout on a command that cannot succeed
+    if(!chameleon_engine_supports_locked(engine, cmd)) {
+        furi_mutex_release(engine->mutex);
+        furi_mutex_release(engine->tx_mutex);
+        FURI_LOG_W(TAG, "%s not supported by device", descriptor->name);
+        return false;
+    }
+
+    ChameleonEnginePending* pending = NULL;
+    for(size_t i = 0; i < CHAMELEON_ENGINE_MAX_REQUESTS; i++) {
+        if(engine->pending[i].state == ChameleonEnginePendingFree) {
+            pending = &engine->pending[i];
+            break;
+        }
+    }
+
+    if(pending) {
+        pending->state = ChameleonEnginePendingQueued;
+        pending->priority = priority;
+        pending->cmd = cmd;
+        pending->order = engine->next_order++;
+        pending->callback = callback;
+        pending->context = context;
+        pending->descriptor = descriptor;
+        pending->link = engine->link;
+        pending->rtt_class = chameleon_engine_rtt_class(descriptor);
+        pending->attempt = 0;
+
+        // Only idempotent requests are safe to repeat
+        pending->retriable = descriptor->flags & CHAMELEON_COMMAND_FLAG_IDEMPOTENT;
+        pending->payload_len = data_len;
+        if(data_len <= CHAMELEON_ENGINE_INLINE_PAYLOAD_MAX) {
+            if(data_len) memcpy(pending->inline_payload, data, data_len);
+            pending->payload = pending->inline_payload;
+        } else {
+            pending->payload = data;
+        }
+
+        engine->active++;
+        if(priority == ChameleonEnginePriorityBulk) engine->bulk_active++;
+        engine->stats.submitted++;
+    }
+
+    furi_mutex_release(engine->mutex);
+
+    if(!pending) {
+        furi_mutex_release(engine->tx_mutex);
+        FURI_LOG_E(TAG, "%s: too many pending requests", descriptor->name);
+        return false;
+    }
+
+    ChameleonEngineCompletion completions[CHAMELEON_ENGINE_MAX_REQUESTS];
+    size_t count = 0;
+
+    chameleon_engine_dispatch(engine, completions, &count);
+
+    furi_mutex_release(engine->tx_mutex);
+
+    chameleon_engine_activity_update(engine);
+
+    chameleon_engine_deliver(engine, completions, count);
+
+    return true;
+}
+
+bool chameleon_engine_submit(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonEngineCallback callback,
+    void* context) {
+    return chameleon_engine_enqueue(
+        engine, ChameleonEnginePriorityInteractive, cmd, data, data_len, callback, context);
+}
+
+bool chameleon_engine_submit_bulk(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonEngineCallback callback,
+    void* context) {
+    return chameleon_engine_enqueue(
+        engine, ChameleonEnginePriorityBulk, cmd, data, data_len, callback, context);
+}
+
+bool chameleon_engine_wait_idle(ChameleonEngine* engine, uint32_t timeout_ms) {
+    furi_assert(engine);
+    uint32_t start = furi_get_tick();
+
+    while(true) {
+        furi_mutex_acquire(engine->mutex, FuriWaitForever);
+        bool idle = engine->active == 0 && engine->completing == 0;
+        if(!idle) engine->idle_wanted = true;
+        furi_mutex_release(engine->mutex);
+
+        if(idle) return true;
+
+        uint32_t elapsed = furi_get_tick() - start;
+        if(elapsed >= timeout_ms) return false;
+
+        // A post left over from an earlier wait only causes one more pass
+        furi_semaphore_acquire(engine->idle, timeout_ms - elapsed);
+    }
+}
+
+static void chameleon_engine_request_callback(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context) {
+    ChameleonEngineWaiter* waiter = context;
+    ChameleonEngine* engine = waiter->engine;
+
+    waiter->result = result;
+    if(result == ChameleonEngineResultOk) {
+        waiter->response = *response;
+
+        furi_mutex_acquire(engine->mutex, FuriWaitForever);
+        engine->lent = true;
+        furi_mutex_release(engine->mutex);
+    }
+
+    furi_semaphore_release(waiter->done);
+
+    // The view points into the decoder buffer, keep it intact until released
+    if(result == ChameleonEngineResultOk) {
+        furi_semaphore_acquire(engine->released, FuriWaitForever);
+    }
+}
+
+bool chameleon_engine_request(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonFrameView* response) {
+    furi_assert(engine);
+    furi_assert(response);
+
+    ChameleonEngineWaiter waiter = {
+        .engine = engine,
+        .done = furi_semaphore_alloc(1, 0),
+    };
+
+    bool submitted =
+        chameleon_engine_submit(engine, cmd, data, data_len, chameleon_engine_request_callback, &waiter);
+
+    // Every submitted request completes, by response, timeout or reset
+    if(submitted) {
+        furi_semaphore_acquire(waiter.done, FuriWaitForever);
+    }
+
+    furi_semaphore_free(waiter.done);
+
+    if(!submitted || waiter.result != ChameleonEngineResultOk) {
+        return false;
+    }
+
+    *response = waiter.response;
+    return true;
+}
+
+void chameleon_engine_release(ChameleonEngine* engine, const ChameleonFrameView* response) {
+    furi_assert(engine);
+    furi_assert(response);
+
+    furi_mutex_acquire(engine->mutex, FuriWaitForever);
+    furi_assert(engine->lent);
+    engine->lent = false;
+    furi_mutex_release(engine->mutex);
+
+    furi_semaphore_release(engine->released);
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../chameleon_protocol/chameleon_protocol.h"
+#include "../chameleon_transport/chameleon_transport.h"
+
+// Maximum number of requests accepted at the same time, queued or in flight
+#define CHAMELEON_ENGINE_MAX_REQUESTS 16
+
+// Maximum number of requests in flight. Bulk requests use at most one less,
+// an interactive request never waits behind a full window of bulk frames.
+#define CHAMELEON_ENGINE_WINDOW 4
+
+// Interactive requests sent before a waiting bulk request gets its turn
+#define CHAMELEON_ENGINE_INTERACTIVE_BURST 4
+
+// Retransmissions of an idempotent request before it times out
+#define CHAMELEON_ENGINE_DEFAULT_RETRIES 2
+#define CHAMELEON_ENGINE_MAX_RETRIES 8
+
+// Largest request payload copied on submit, larger payloads are referenced
+#define CHAMELEON_ENGINE_INLINE_PAYLOAD_MAX 48
+
+// Commands with a longer default timeout are dominated by device work and
+// get their own RTT estimate
+#define CHAMELEON_ENGINE_RTT_LONG_MS 5000
+
+// Time without bulk requests before a bulk job counts as finished, keeps a
+// job issued one request after another from flapping
+#define CHAMELEON_ENGINE_BULK_LINGER_MS 250
+
+// Time without requests before the engine counts as idle
+#define CHAMELEON_ENGINE_IDLE_AFTER_MS 5000
+
+// Request engine instance
+//
+// Sends commands back to back without waiting for earlier responses,
+// reassembles received bytes into frames and completes each request when its
+// response arrives. Responses are matched by CMD, oldest request first.
+// Requests beyond the window are queued by priority and sent at frame
+// boundaries as responses come in.
+typedef struct ChameleonEngine ChameleonEngine;
+
+// Link the engine sends over, round trip times are tracked per link
+typedef enum {
+    ChameleonEngineLinkUsb,
+    ChameleonEngineLinkBle,
+    ChameleonEngineLinkNum,
+} ChameleonEngineLink;
+
+// Command classes with separate round trip estimates
+typedef enum {
+    ChameleonEngineRttClassDevice, // Device and emulator management, answered by the MCU
+    ChameleonEngineRttClassRadio, // Reader commands, include an RF exchange with a tag
+    ChameleonEngineRttClassLong, // Default timeout above CHAMELEON_ENGINE_RTT_LONG_MS
+    ChameleonEngineRttClassNum,
+} ChameleonEngineRttClass;
+
+// Scheduling class of a request
+typedef enum {
+    ChameleonEnginePriorityInteractive, // User initiated, sent ahead of bulk requests
+    ChameleonEnginePriorityBulk, // Long transfers, get a share of the window
+    ChameleonEnginePriorityNum,
+} ChameleonEnginePriority;
+
+// What the engine is busy with, for links that trade latency for power
+typedef enum {
+    ChameleonEngineActivityIdle, // No request for CHAMELEON_ENGINE_IDLE_AFTER_MS
+    ChameleonEngineActivityInteractive, // Interactive requests only
+    ChameleonEngineActivityBulk, // A bulk job is running
+    ChameleonEngineActivityNum,
+} ChameleonEngineActivity;
+
+// Round trip estimate of one link and command class
+typedef struct {
+    uint32_t samples;
+    uint32_t srtt_ms; // Smoothed round trip time
+    uint32_t rttvar_ms; // Round trip time variation
+    uint32_t rto_ms; // Timeout of a first transmission
+} ChameleonEngineRtt;
+
+// Engine counters since alloc
+typedef struct {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t timeouts;
+    uint32_t retransmits;
+    uint32_t unexpected; // Responses no pending request was waiting for
+    uint32_t duplicates; // Late responses to timed out or retransmitted requests, dropped
+} ChameleonEngineStats;
+
+// Request completion result
+typedef enum {
+    ChameleonEngineResultOk, // Response received, status is left to the caller
+    ChameleonEngineResultTimeout, // No response within the command timeout
+    ChameleonEngineResultInvalid, // Success status with a malformed payload
+    ChameleonEngineResultCancelled, // Dropped by chameleon_engine_reset
+    ChameleonEngineResultSendFailed, // Frame could not be written to the link
+} ChameleonEngineResult;
+
+// Completion callback, called exactly once per submitted request
+//
+// Runs on the receive thread for responses, on the engine's own thread for
+// timeouts and on any thread that sends queued requests for send failures,
+// keep it short. The response is only valid for ChameleonEngineResultOk
+// and only until the callback returns, it points into the receive buffer.
+typedef void (*ChameleonEngineCallback)(
+    ChameleonEngineResult result,
+    const ChameleonFrameView* response,
+    void* context);
+
+// Activity change callback. Calls are serialized and the last one reports the
+// current activity. Runs on the submitting thread when a job starts and on
+// the engine's thread when one ends, keep it short and do not submit from it.
+typedef void (*ChameleonEngineActivityCallback)(ChameleonEngineActivity activity, void* context);
+
+// Create and destroy engine
+ChameleonEngine* chameleon_engine_alloc();
+void chameleon_engine_free(ChameleonEngine* engine);
+
+// Bind the engine to a transport, NULL unbinds. Frames are sent through it
+// and its receive callback feeds the engine. Receiving is started and
+// stopped by the owner of the transport.
+void chameleon_engine_set_transport(ChameleonEngine* engine, const ChameleonTransport* transport);
+
+// Cancel all pending requests, including one being written, and drop any
+// partially received frame before the next bytes are fed. Call on
+// (re)connect and disconnect.
+void chameleon_engine_reset(ChameleonEngine* engine);
+
+// Select the link used for round trip estimates of subsequent requests
+void chameleon_engine_set_link(ChameleonEngine* engine, ChameleonEngineLink link);
+
+// Set retransmissions per idempotent request, 0 disables retries. Clamped to
+// CHAMELEON_ENGINE_MAX_RETRIES.
+void chameleon_engine_set_retries(ChameleonEngine* engine, uint8_t retries);
+
+// Set the activity change callback, NULL disables it
+void chameleon_engine_set_activity_callback(
+    ChameleonEngine* engine,
+    ChameleonEngineActivityCallback callback,
+    void* context);
+
+// Get the activity last reported to the callback
+ChameleonEngineActivity chameleon_engine_get_activity(ChameleonEngine* engine);
+
+// Get round trip estimate and counters
+void chameleon_engine_get_rtt(
+    ChameleonEngine* engine,
+    ChameleonEngineLink link,
+    ChameleonEngineRttClass rtt_class,
+    ChameleonEngineRtt* rtt);
+void chameleon_engine_get_stats(ChameleonEngine* engine, ChameleonEngineStats* stats);
+
+// Limit submits to the commands the device reports, NULL accepts every
+// command. Cleared by chameleon_engine_reset.
+void chameleon_engine_set_capabilities(
+    ChameleonEngine* engine,
+    const ChameleonCommandSet* capabilities);
+
+// Check whether the device supports a command, true while capabilities are unknown
+bool chameleon_engine_supports(ChameleonEngine* engine, uint16_t cmd);
+
+// Feed received bytes, chunks may hold partial or multiple frames. Bound
+// transports that deliver whole frames bypass this.
+void chameleon_engine_feed(ChameleonEngine* engine, const uint8_t* data, size_t length);
+
+// Queue an interactive command and return without waiting for the response.
+// Payloads up to CHAMELEON_ENGINE_INLINE_PAYLOAD_MAX are copied, larger ones
+// must stay valid until the callback runs. The response timeout follows the
+// round trip estimate of the link and command class, idempotent requests are
+// retransmitted with exponential backoff before timing out. A request is not
+// retransmitted while another one with the same CMD is in flight, it times
+// out instead. While replies to retransmitted copies of an earlier request
+// are still owed, requests with its CMD wait in the queue for at most the
+// maximum timeout. Returns false if the request is invalid, the queue is
+// full, the engine is not connected or the device does not support the
+// command, the callback is not called in that case.
+bool chameleon_engine_submit(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonEngineCallback callback,
+    void* context);
+
+// Queue a bulk command, same as chameleon_engine_submit otherwise. Bulk
+// requests yield to interactive ones at frame boundaries.
+bool chameleon_engine_submit_bulk(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonEngineCallback callback,
+    void* context);
+
+// Wait until every submitted request has completed and its callback returned
+bool chameleon_engine_wait_idle(ChameleonEngine* engine, uint32_t timeout_ms);
+
+// Send a command and block until its response arrives or the descriptor
+// timeout expires. On success the response is a view into the receive buffer,
+// lent to the caller until chameleon_engine_release. Response length bounds
+// are checked for success statuses, the status itself is left to the caller.
+bool chameleon_engine_request(
+    ChameleonEngine* engine,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    ChameleonFrameView* response);
+
+// Return a lent response buffer to the receive path
+void chameleon_engine_release(ChameleonEngine* engine, const ChameleonFrameView* response);
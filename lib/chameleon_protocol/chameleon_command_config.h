@@ -0,0 +1,42 @@
+// Command descriptor table, see ChameleonCommandDescriptor
+//
+// ADD_COMMAND(name, id, request_min, request_max, response_min, response_max, timeout_ms, flags)
+//   name  - suffix of the CMD_* define
+//   id    - suffix of the ChameleonCommand* table index
+//   sizes - DATA length bounds of the request and of a successful response
+
+// Device Management
+ADD_COMMAND(GET_APP_VERSION, GetAppVersion, 0, 0, 2, 2, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(CHANGE_DEVICE_MODE, ChangeDeviceMode, 1, 1, 0, 0, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(GET_DEVICE_MODE, GetDeviceMode, 0, 0, 1, 1, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(SET_ACTIVE_SLOT, SetActiveSlot, 1, 1, 0, 0, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(SET_SLOT_TAG_TYPE, SetSlotTagType, 3, 3, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(SET_SLOT_ENABLE, SetSlotEnable, 3, 3, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(SET_SLOT_TAG_NICK, SetSlotTagNick, 1, 33, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(GET_DEVICE_CHIP_ID, GetDeviceChipId, 0, 0, 8, 8, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(GET_GIT_VERSION, GetGitVersion, 0, 0, 0, CHAMELEON_MAX_DATA_LEN, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(GET_SLOT_INFO, GetSlotInfo, 0, 0, CHAMELEON_SLOT_INFO_LEN, CHAMELEON_SLOT_INFO_LEN, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(DELETE_SLOT_SENSE_TYPE, DeleteSlotSenseType, 2, 2, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(GET_DEVICE_MODEL, GetDeviceModel, 0, 0, 1, 1, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(GET_DEVICE_CAPABILITIES, GetDeviceCapabilities, 0, 0, 0, CHAMELEON_MAX_DATA_LEN, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+
+// HF (High Frequency)
+ADD_COMMAND(HF14A_SCAN, Hf14aScan, 0, 0, 0, CHAMELEON_MAX_DATA_LEN, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(MF1_DETECT_SUPPORT, Mf1DetectSupport, 0, 0, 0, 1, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(MF1_AUTH_ONE_KEY_BLOCK, Mf1AuthOneKeyBlock, 8, 8, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(MF1_READ_ONE_BLOCK, Mf1ReadOneBlock, 8, 8, 16, 16, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(MF1_WRITE_ONE_BLOCK, Mf1WriteOneBlock, 24, 24, 0, 0, 2000, 0)
+ADD_COMMAND(MF1_CHECK_KEYS_OF_SECTORS, Mf1CheckKeysOfSectors, 16, CHAMELEON_MAX_DATA_LEN, 0, CHAMELEON_MAX_DATA_LEN, 10000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+
+// LF (Low Frequency)
+ADD_COMMAND(EM410X_SCAN, Em410xScan, 0, 0, 5, 5, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(HIDPROX_SCAN, HidproxScan, 0, 0, 0, CHAMELEON_MAX_DATA_LEN, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+
+// Emulator Config
+ADD_COMMAND(MF1_WRITE_EMU_BLOCK_DATA, Mf1WriteEmuBlockData, 17, CHAMELEON_MAX_DATA_LEN, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(MF1_READ_EMU_BLOCK_DATA, Mf1ReadEmuBlockData, 2, 2, 16, CHAMELEON_MAX_DATA_LEN, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(MF1_GET_EMULATOR_CONFIG, Mf1GetEmulatorConfig, 0, 0, 0, CHAMELEON_MAX_DATA_LEN, 1000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+
+// LF Emulator
+ADD_COMMAND(EM410X_SET_EMU_ID, Em410xSetEmuId, 5, 5, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
+ADD_COMMAND(HIDPROX_SET_EMU_ID, HidproxSetEmuId, 1, CHAMELEON_MAX_DATA_LEN, 0, 0, 2000, CHAMELEON_COMMAND_FLAG_IDEMPOTENT)
@@ -9,6 +9,36 @@ struct ChameleonProtocol {
     void* send_context;
 };
 
+struct ChameleonFrameDecoder {
+    uint8_t buffer[CHAMELEON_MAX_FRAME_LEN];
+    size_t fill;         // Bytes of the current frame in buffer
+    size_t expected_len; // Total frame length, valid once the header is complete
+    uint32_t data_sum;   // Running sum of DATA|LRC3 bytes received so far
+
+    ChameleonFrameDecoderCallback callback;
+    void* context;
+
+    ChameleonFrameDecoderStats stats;
+};
+
+// Generate command descriptor table
+#define ADD_COMMAND(                                                                            \
+    _name, _id, _request_min, _request_max, _response_min, _response_max, _timeout_ms, _flags) \
+    [ChameleonCommand##_id] = {                                                                 \
+        .name = #_name,                                                                         \
+        .cmd = CMD_##_name,                                                                     \
+        .request_min = _request_min,                                                            \
+        .request_max = _request_max,                                                            \
+        .response_min = _response_min,                                                          \
+        .response_max = _response_max,                                                          \
+        .timeout_ms = _timeout_ms,                                                              \
+        .flags = _flags,                                                                        \
+    },
+const ChameleonCommandDescriptor chameleon_commands[ChameleonCommandNum] = {
+#include "chameleon_command_config.h"
+};
+#undef ADD_COMMAND
+
 ChameleonProtocol* chameleon_protocol_alloc() {
     ChameleonProtocol* protocol = malloc(sizeof(ChameleonProtocol));
     memset(protocol, 0, sizeof(ChameleonProtocol));
@@ -29,59 +59,134 @@ void chameleon_protocol_set_send_callback(
     protocol->send_context = context;
 }
 
-uint8_t chameleon_protocol_calculate_lrc(const uint8_t* data, size_t len) {
+// Byte sums are computed a 32-bit word at a time (SWAR): bytes 0/2 and 1/3 of
+// each word are added into two 16-bit lanes of one accumulator. A lane gains at
+// most 2 * 255 per word, so it is folded every 128 words before it can overflow.
+#define CHAMELEON_SWAR_LANE_MASK 0x00FF00FFU
+#define CHAMELEON_SWAR_BLOCK_WORDS 128
+
+static inline uint32_t chameleon_protocol_swar_lanes(uint32_t word) {
+    return (word & CHAMELEON_SWAR_LANE_MASK) + ((word >> 8) & CHAMELEON_SWAR_LANE_MASK);
+}
+
+static inline uint32_t chameleon_protocol_swar_fold(uint32_t lanes) {
+    return (lanes & 0xFFFF) + (lanes >> 16);
+}
+
+// Sum of all bytes
+static uint32_t chameleon_protocol_sum(const uint8_t* src, size_t len) {
     uint32_t sum = 0;
-    for(size_t i = 0; i < len; i++) {
-        sum += data[i];
+
+    while(len >= 4) {
+        size_t words = MIN(len / 4, (size_t)CHAMELEON_SWAR_BLOCK_WORDS);
+        uint32_t lanes = 0;
+        for(size_t i = 0; i < words; i++) {
+            uint32_t word;
+            memcpy(&word, src, 4);
+            lanes += chameleon_protocol_swar_lanes(word);
+            src += 4;
+        }
+        sum += chameleon_protocol_swar_fold(lanes);
+        len -= words * 4;
     }
-    return (uint8_t)(~sum + 1); // Two's complement
+
+    while(len--) {
+        sum += *src++;
+    }
+
+    return sum;
 }
 
-bool chameleon_protocol_build_frame(
-    ChameleonProtocol* protocol,
-    uint16_t cmd,
-    const uint8_t* data,
-    uint16_t data_len,
-    uint8_t* frame_buffer,
-    size_t* frame_len) {
+// Copy bytes and return their sum in a single pass
+static uint32_t chameleon_protocol_copy_sum(uint8_t* dst, const uint8_t* src, size_t len) {
+    uint32_t sum = 0;
 
-    UNUSED(protocol);
+    while(len >= 4) {
+        size_t words = MIN(len / 4, (size_t)CHAMELEON_SWAR_BLOCK_WORDS);
+        uint32_t lanes = 0;
+        for(size_t i = 0; i < words; i++) {
+            uint32_t word;
+            memcpy(&word, src, 4);
+            memcpy(dst, &word, 4);
+            lanes += chameleon_protocol_swar_lanes(word);
+            src += 4;
+            dst += 4;
+        }
+        sum += chameleon_protocol_swar_fold(lanes);
+        len -= words * 4;
+    }
 
+    while(len--) {
+        sum += *src;
+        *dst++ = *src++;
+    }
+
+    return sum;
+}
+
+uint8_t chameleon_protocol_calculate_lrc(const uint8_t* data, size_t len) {
+    uint32_t sum = chameleon_protocol_sum(data, len);
+    return (uint8_t)(~sum + 1); // Two's complement
+}
+
+bool chameleon_protocol_build_header(uint16_t cmd, uint16_t data_len, uint8_t* header) {
     if(data_len > CHAMELEON_MAX_DATA_LEN) {
         FURI_LOG_E(TAG, "Data length %u exceeds maximum %u", data_len, CHAMELEON_MAX_DATA_LEN);
         return false;
     }
 
-    size_t idx = 0;
-
     // SOF and LRC1
-    frame_buffer[idx++] = CHAMELEON_SOF;
-    frame_buffer[idx++] = CHAMELEON_LRC1;
+    header[0] = CHAMELEON_SOF;
+    header[1] = CHAMELEON_LRC1;
 
     // CMD (Big Endian)
-    frame_buffer[idx++] = (cmd >> 8) & 0xFF;
-    frame_buffer[idx++] = cmd & 0xFF;
+    header[2] = (cmd >> 8) & 0xFF;
+    header[3] = cmd & 0xFF;
 
     // STATUS (always 0x0000 for client->device)
-    frame_buffer[idx++] = 0x00;
-    frame_buffer[idx++] = 0x00;
+    header[4] = 0x00;
+    header[5] = 0x00;
 
     // LEN (Big Endian)
-    frame_buffer[idx++] = (data_len >> 8) & 0xFF;
-    frame_buffer[idx++] = data_len & 0xFF;
+    header[6] = (data_len >> 8) & 0xFF;
+    header[7] = data_len & 0xFF;
 
-    // Calculate LRC2 (over CMD|STATUS|LEN)
-    frame_buffer[idx] = chameleon_protocol_calculate_lrc(&frame_buffer[2], 6);
-    idx++;
+    // LRC2 (over CMD|STATUS|LEN)
+    header[8] = chameleon_protocol_calculate_lrc(&header[2], 6);
 
-    // DATA
+    return true;
+}
+
+uint8_t chameleon_protocol_build_trailer(const uint8_t* data, uint16_t data_len) {
+    // LRC3 (over DATA)
+    return data_len > 0 && data != NULL ? chameleon_protocol_calculate_lrc(data, data_len) : 0;
+}
+
+bool chameleon_protocol_build_frame(
+    ChameleonProtocol* protocol,
+    uint16_t cmd,
+    const uint8_t* data,
+    uint16_t data_len,
+    uint8_t* frame_buffer,
+    size_t* frame_len) {
+
+    UNUSED(protocol);
+
+    if(!chameleon_protocol_build_header(cmd, data_len, frame_buffer)) {
+        return false;
+    }
+
+    size_t idx = CHAMELEON_HEADER_LEN;
+
+    // DATA, summed for LRC3 while it is copied
+    uint32_t data_sum = 0;
     if(data_len > 0 && data != NULL) {
-        memcpy(&frame_buffer[idx], data, data_len);
+        data_sum = chameleon_protocol_copy_sum(&frame_buffer[idx], data, data_len);
         idx += data_len;
     }
 
-    // Calculate LRC3 (over DATA)
-    frame_buffer[idx] = chameleon_protocol_calculate_lrc(&frame_buffer[9], data_len);
+    // LRC3 (over DATA)
+    frame_buffer[idx] = (uint8_t)(~data_sum + 1);
     idx++;
 
     *frame_len = idx;
@@ -91,16 +196,11 @@ bool chameleon_protocol_build_frame(
     return true;
 }
 
-bool chameleon_protocol_parse_frame(
-    ChameleonProtocol* protocol,
+// Validate everything but LRC3 and fill the view
+static bool chameleon_protocol_parse_header(
     const uint8_t* frame_data,
     size_t frame_len,
-    uint16_t* cmd,
-    uint16_t* status,
-    uint8_t* data,
-    uint16_t* data_len) {
-
-    UNUSED(protocol);
+    ChameleonFrameView* view) {
 
     if(frame_len < CHAMELEON_FRAME_OVERHEAD) {
         FURI_LOG_E(TAG, "Frame too short: %zu bytes", frame_len);
@@ -114,13 +214,13 @@ bool chameleon_protocol_parse_frame(
     }
 
     // Extract CMD (Big Endian)
-    *cmd = ((uint16_t)frame_data[2] << 8) | frame_data[3];
+    view->cmd = ((uint16_t)frame_data[2] << 8) | frame_data[3];
 
     // Extract STATUS (Big Endian)
-    *status = ((uint16_t)frame_data[4] << 8) | frame_data[5];
+    view->status = ((uint16_t)frame_data[4] << 8) | frame_data[5];
 
     // Extract LEN (Big Endian)
-    *data_len = ((uint16_t)frame_data[6] << 8) | frame_data[7];
+    view->data_len = ((uint16_t)frame_data[6] << 8) | frame_data[7];
 
     // Verify LRC2
     uint8_t expected_lrc2 = chameleon_protocol_calculate_lrc(&frame_data[2], 6);
@@ -130,29 +230,122 @@ bool chameleon_protocol_parse_frame(
     }
 
     // Check frame length
-    size_t expected_len = CHAMELEON_FRAME_OVERHEAD + *data_len;
+    size_t expected_len = CHAMELEON_FRAME_OVERHEAD + view->data_len;
     if(frame_len != expected_len) {
         FURI_LOG_E(TAG, "Frame length mismatch: expected %zu, got %zu", expected_len, frame_len);
         return false;
     }
 
-    // Extract data if present
-    if(*data_len > 0) {
-        memcpy(data, &frame_data[9], *data_len);
+    view->data = &frame_data[9];
 
-        // Verify LRC3
-        uint8_t expected_lrc3 = chameleon_protocol_calculate_lrc(&frame_data[9], *data_len);
-        if(frame_data[9 + *data_len] != expected_lrc3) {
-            FURI_LOG_E(TAG, "LRC3 mismatch: expected %02X, got %02X", expected_lrc3, frame_data[9 + *data_len]);
-            return false;
-        }
+    return true;
+}
+
+// DATA|LRC3 sums to zero for a valid frame
+static bool chameleon_protocol_check_lrc3(const ChameleonFrameView* view, uint32_t data_sum) {
+    uint8_t lrc3 = view->data[view->data_len];
+    if((uint8_t)(data_sum + lrc3) != 0) {
+        FURI_LOG_E(TAG, "LRC3 mismatch: expected %02X, got %02X", (uint8_t)(~data_sum + 1), lrc3);
+        return false;
     }
 
-    FURI_LOG_D(TAG, "Parsed frame: CMD=%04X, STATUS=%04X, LEN=%u", *cmd, *status, *data_len);
+    FURI_LOG_D(
+        TAG, "Parsed frame: CMD=%04X, STATUS=%04X, LEN=%u", view->cmd, view->status, view->data_len);
 
     return true;
 }
 
+bool chameleon_protocol_parse_frame_view(
+    const uint8_t* frame_data,
+    size_t frame_len,
+    ChameleonFrameView* view) {
+
+    if(!chameleon_protocol_parse_header(frame_data, frame_len, view)) {
+        return false;
+    }
+
+    return chameleon_protocol_check_lrc3(view, chameleon_protocol_sum(view->data, view->data_len));
+}
+
+bool chameleon_protocol_parse_frame(
+    ChameleonProtocol* protocol,
+    const uint8_t* frame_data,
+    size_t frame_len,
+    uint16_t* cmd,
+    uint16_t* status,
+    uint8_t* data,
+    uint16_t* data_len) {
+
+    UNUSED(protocol);
+
+    ChameleonFrameView view;
+    if(!chameleon_protocol_parse_header(frame_data, frame_len, &view)) {
+        return false;
+    }
+
+    *cmd = view.cmd;
+    *status = view.status;
+    *data_len = view.data_len;
+
+    // Extract data, summed for LRC3 while it is copied
+    uint32_t data_sum = 0;
+    if(view.data_len > 0) {
+        data_sum = chameleon_protocol_copy_sum(data, view.data, view.data_len);
+    }
+
+    return chameleon_protocol_check_lrc3(&view, data_sum);
+}
+
+const ChameleonCommandDescriptor* chameleon_protocol_get_command(uint16_t cmd) {
+    // Generate lookup, compiled to a jump table or binary search
+#define ADD_COMMAND(name, id, ...) \
+    case CMD_##name:               \
+        return &chameleon_commands[ChameleonCommand##id];
+    switch(cmd) {
+#include "chameleon_command_config.h"
+    default:
+        return NULL;
+    }
+#undef ADD_COMMAND
+}
+
+bool chameleon_protocol_status_is_success(uint16_t status) {
+    return status == STATUS_SUCCESS || status == STATUS_HF_TAG_OK || status == STATUS_LF_TAG_OK;
+}
+
+// Map CMD to group and bit, false if the set cannot represent it
+static bool chameleon_command_set_index(uint16_t cmd, size_t* group, size_t* bit) {
+    if(cmd < 1000) return false;
+
+    *group = cmd / 1000 - 1;
+    *bit = cmd % 1000;
+
+    return *group < CHAMELEON_COMMAND_SET_GROUPS && *bit < CHAMELEON_COMMAND_SET_GROUP_BITS;
+}
+
+void chameleon_command_set_from_list(ChameleonCommandSet* set, const uint8_t* data, uint16_t data_len) {
+    size_t group, bit;
+
+    memset(set, 0, sizeof(ChameleonCommandSet));
+
+    for(size_t i = 0; i + 1 < data_len; i += 2) {
+        uint16_t cmd = (data[i] << 8) | data[i + 1];
+        if(chameleon_command_set_index(cmd, &group, &bit)) {
+            set->bits[group][bit / 32] |= 1UL << (bit % 32);
+        }
+    }
+}
+
+bool chameleon_command_set_contains(const ChameleonCommandSet* set, uint16_t cmd) {
+    size_t group, bit;
+
+    if(!chameleon_command_set_index(cmd, &group, &bit)) {
+        return true;
+    }
+
+    return (set->bits[group][bit / 32] >> (bit % 32)) & 1;
+}
+
 bool chameleon_protocol_validate_frame(const uint8_t* frame_data, size_t frame_len) {
     if(frame_len < CHAMELEON_FRAME_OVERHEAD) {
         return false;
@@ -194,3 +387,144 @@ bool chameleon_protocol_build_cmd_with_data(
     size_t* len) {
     return chameleon_protocol_build_frame(protocol, cmd, data, data_len, buffer, len);
 }
+
+ChameleonFrameDecoder* chameleon_frame_decoder_alloc() {
+    ChameleonFrameDecoder* decoder = malloc(sizeof(ChameleonFrameDecoder));
+    memset(decoder, 0, sizeof(ChameleonFrameDecoder));
+    return decoder;
+}
+
+void chameleon_frame_decoder_free(ChameleonFrameDecoder* decoder) {
+    furi_assert(decoder);
+    free(decoder);
+}
+
+void chameleon_frame_decoder_set_callback(
+    ChameleonFrameDecoder* decoder,
+    ChameleonFrameDecoderCallback callback,
+    void* context) {
+    furi_assert(decoder);
+    decoder->callback = callback;
+    decoder->context = context;
+}
+
+void chameleon_frame_decoder_reset(ChameleonFrameDecoder* decoder) {
+    furi_assert(decoder);
+    decoder->fill = 0;
+    decoder->expected_len = 0;
+    decoder->data_sum = 0;
+}
+
+void chameleon_frame_decoder_get_stats(ChameleonFrameDecoder* decoder, ChameleonFrameDecoderStats* stats) {
+    furi_assert(decoder);
+    furi_assert(stats);
+    *stats = decoder->stats;
+}
+
+// Check the header bytes received so far; each byte is checked once, when the
+// prefix first becomes long enough to cover it
+static bool chameleon_frame_decoder_check_header(ChameleonFrameDecoder* decoder, size_t checked) {
+    const uint8_t* header = decoder->buffer;
+
+    if(checked < 2 && decoder->fill >= 2 && header[1] != CHAMELEON_LRC1) {
+        return false;
+    }
+
+    if(checked < CHAMELEON_HEADER_LEN && decoder->fill >= CHAMELEON_HEADER_LEN) {
+        size_t expected_len = chameleon_protocol_get_expected_frame_len(header);
+        if(expected_len == 0 || expected_len > CHAMELEON_MAX_FRAME_LEN) {
+            return false;
+        }
+
+        // CMD|STATUS|LEN|LRC2 sums to zero for a valid header
+        uint8_t sum = 0;
+        for(size_t i = 2; i < CHAMELEON_HEADER_LEN; i++) {
+            sum += header[i];
+        }
+        if(sum != 0) {
+            return false;
+        }
+
+        decoder->expected_len = expected_len;
+        decoder->data_sum = 0;
+    }
+
+    return true;
+}
+
+// Drop the current SOF and restart from the next SOF candidate inside the
+// partial header. At most CHAMELEON_HEADER_LEN - 1 bytes are searched.
+static void chameleon_frame_decoder_resync(ChameleonFrameDecoder* decoder) {
+    const uint8_t* next = memchr(&decoder->buffer[1], CHAMELEON_SOF, decoder->fill - 1);
+    size_t skip = next ? (size_t)(next - decoder->buffer) : decoder->fill;
+
+    decoder->stats.bytes_skipped += skip;
+    decoder->fill -= skip;
+    memmove(decoder->buffer, &decoder->buffer[skip], decoder->fill);
+    decoder->expected_len = 0;
+}
+
+void chameleon_frame_decoder_feed(ChameleonFrameDecoder* decoder, const uint8_t* data, size_t length) {
+    furi_assert(decoder);
+    furi_assert(data || length == 0);
+
+    while(length > 0) {
+        if(decoder->fill == 0) {
+            // Hunt for SOF
+            const uint8_t* sof = memchr(data, CHAMELEON_SOF, length);
+            if(!sof) {
+                decoder->stats.bytes_skipped += length;
+                return;
+            }
+
+            size_t skip = sof - data;
+            decoder->stats.bytes_skipped += skip;
+            decoder->buffer[decoder->fill++] = CHAMELEON_SOF;
+            data += skip + 1;
+            length -= skip + 1;
+        } else if(decoder->fill < CHAMELEON_HEADER_LEN) {
+            // Complete the header
+            size_t checked = decoder->fill;
+            size_t chunk = MIN(CHAMELEON_HEADER_LEN - decoder->fill, length);
+            memcpy(&decoder->buffer[decoder->fill], data, chunk);
+            decoder->fill += chunk;
+            data += chunk;
+            length -= chunk;
+
+            // A resync may leave a shorter, unchecked prefix behind
+            while(decoder->fill > 0 && !chameleon_frame_decoder_check_header(decoder, checked)) {
+                decoder->stats.header_errors++;
+                chameleon_frame_decoder_resync(decoder);
+                checked = decoder->fill > 0 ? 1 : 0;
+            }
+        } else {
+            // DATA and LRC3
+            size_t chunk = MIN(decoder->expected_len - decoder->fill, length);
+            decoder->data_sum += chameleon_protocol_copy_sum(&decoder->buffer[decoder->fill], data, chunk);
+            decoder->fill += chunk;
+            data += chunk;
+            length -= chunk;
+
+            if(decoder->fill == decoder->expected_len) {
+                // DATA|LRC3 sums to zero for a valid frame
+                if((uint8_t)decoder->data_sum == 0) {
+                    decoder->stats.frames++;
+                    if(decoder->callback) {
+                        const uint8_t* header = decoder->buffer;
+                        ChameleonFrameView view = {
+                            .cmd = ((uint16_t)header[2] << 8) | header[3],
+                            .status = ((uint16_t)header[4] << 8) | header[5],
+                            .data_len = decoder->fill - CHAMELEON_FRAME_OVERHEAD,
+                            .data = &header[CHAMELEON_HEADER_LEN],
+                        };
+                        decoder->callback(&view, decoder->context);
+                    }
+                } else {
+                    FURI_LOG_W(TAG, "Dropping frame with bad LRC3, %zu bytes", decoder->fill);
+                    decoder->stats.data_errors++;
+                }
+                chameleon_frame_decoder_reset(decoder);
+            }
+        }
+    }
+}
@@ -9,6 +9,8 @@
 #define CHAMELEON_LRC1 0xEF
 #define CHAMELEON_MAX_DATA_LEN 512
 #define CHAMELEON_FRAME_OVERHEAD 10
+#define CHAMELEON_HEADER_LEN 9 // SOF|LRC1|CMD|STATUS|LEN|LRC2
+#define CHAMELEON_MAX_FRAME_LEN (CHAMELEON_FRAME_OVERHEAD + CHAMELEON_MAX_DATA_LEN)
 
 // Command IDs - Device Management (1000-1037)
 #define CMD_GET_APP_VERSION 1000
@@ -39,6 +41,7 @@
 
 // Command IDs - Emulator Config 4000-4030
 #define CMD_MF1_WRITE_EMU_BLOCK_DATA 4000
+#define CMD_MF1_READ_EMU_BLOCK_DATA 4008
 #define CMD_MF1_GET_EMULATOR_CONFIG 4009
 
 // Command IDs - LF Emulator 5000-5003
@@ -49,6 +52,7 @@
 #define STATUS_SUCCESS 0x0000
 #define STATUS_HF_TAG_OK 0x0200
 #define STATUS_LF_TAG_OK 0x0300
+#define STATUS_LF_TAG_NO 0x0301
 #define STATUS_HF_TAG_NO 0x0201
 #define STATUS_MF_ERR_AUTH 0x0206
 #define STATUS_FLASH_READ_FAIL 0x0401
@@ -56,6 +60,47 @@
 #define STATUS_INVALID_CMD 0x0001
 #define STATUS_INVALID_PARAM 0x0002
 
+// GET_SLOT_INFO response layout: per slot number, HF type, LF type,
+// HF enabled, LF enabled and a 32 byte nickname
+#define CHAMELEON_SLOT_COUNT 8
+#define CHAMELEON_SLOT_NICK_LEN 32
+#define CHAMELEON_SLOT_INFO_ENTRY_LEN (5 + CHAMELEON_SLOT_NICK_LEN)
+#define CHAMELEON_SLOT_INFO_LEN (CHAMELEON_SLOT_COUNT * CHAMELEON_SLOT_INFO_ENTRY_LEN)
+
+// Command descriptor flags
+#define CHAMELEON_COMMAND_FLAG_IDEMPOTENT (1 << 0) // Safe to retransmit
+
+// Static per-command properties, see chameleon_command_config.h
+typedef struct {
+    const char* name;
+    uint16_t cmd;
+    uint16_t request_min;  // DATA length bounds of a request
+    uint16_t request_max;
+    uint16_t response_min; // DATA length bounds of a successful response
+    uint16_t response_max;
+    uint16_t timeout_ms;   // Default response timeout
+    uint8_t flags;
+} ChameleonCommandDescriptor;
+
+// Generate descriptor table index and total number
+#define ADD_COMMAND(name, id, ...) ChameleonCommand##id,
+typedef enum {
+#include "chameleon_command_config.h"
+    ChameleonCommandNum,
+} ChameleonCommand;
+#undef ADD_COMMAND
+
+extern const ChameleonCommandDescriptor chameleon_commands[ChameleonCommandNum];
+
+// Command ID set, one bit per CMD. IDs are grouped by thousands (1xxx device,
+// 2xxx HF reader, 3xxx LF reader, 4xxx HF emulator, 5xxx LF emulator).
+#define CHAMELEON_COMMAND_SET_GROUPS 5
+#define CHAMELEON_COMMAND_SET_GROUP_BITS 128
+
+typedef struct {
+    uint32_t bits[CHAMELEON_COMMAND_SET_GROUPS][CHAMELEON_COMMAND_SET_GROUP_BITS / 32];
+} ChameleonCommandSet;
+
 // Frame structure
 typedef struct {
     uint8_t sof;      // 0x11
@@ -68,6 +113,14 @@ typedef struct {
     uint8_t lrc3;     // Checksum of data
 } __attribute__((packed)) ChameleonFrame;
 
+// Parsed frame, data points into the frame buffer it was parsed from
+typedef struct {
+    uint16_t cmd;
+    uint16_t status;
+    uint16_t data_len;
+    const uint8_t* data;
+} ChameleonFrameView;
+
 // Protocol instance
 typedef struct ChameleonProtocol ChameleonProtocol;
 
@@ -93,6 +146,11 @@ bool chameleon_protocol_build_frame(
     uint8_t* frame_buffer,
     size_t* frame_len);
 
+// Scatter-gather frame building: the caller sends header, payload and trailer
+// as separate segments so the payload never has to be staged in a frame buffer
+bool chameleon_protocol_build_header(uint16_t cmd, uint16_t data_len, uint8_t* header);
+uint8_t chameleon_protocol_build_trailer(const uint8_t* data, uint16_t data_len);
+
 // Frame parsing
 bool chameleon_protocol_parse_frame(
     ChameleonProtocol* protocol,
@@ -103,6 +161,12 @@ bool chameleon_protocol_parse_frame(
     uint8_t* data,
     uint16_t* data_len);
 
+// Frame parsing without copying, view->data stays valid as long as frame_data
+bool chameleon_protocol_parse_frame_view(
+    const uint8_t* frame_data,
+    size_t frame_len,
+    ChameleonFrameView* view);
+
 // LRC calculation
 uint8_t chameleon_protocol_calculate_lrc(const uint8_t* data, size_t len);
 
@@ -117,8 +181,55 @@ bool chameleon_protocol_build_cmd_with_data(
     uint8_t* buffer,
     size_t* len);
 
+// Command descriptor lookup, NULL for commands not in the table
+const ChameleonCommandDescriptor* chameleon_protocol_get_command(uint16_t cmd);
+
+// Status codes that carry a successful response
+bool chameleon_protocol_status_is_success(uint16_t status);
+
+// Build set from a GET_DEVICE_CAPABILITIES response, a list of big-endian u16 IDs
+void chameleon_command_set_from_list(ChameleonCommandSet* set, const uint8_t* data, uint16_t data_len);
+
+// Check set membership, IDs outside the representable range are reported as contained
+bool chameleon_command_set_contains(const ChameleonCommandSet* set, uint16_t cmd);
+
 // Validate frame
 bool chameleon_protocol_validate_frame(const uint8_t* frame_data, size_t frame_len);
 
 // Get frame length from header
 size_t chameleon_protocol_get_expected_frame_len(const uint8_t* header);
+
+// Streaming frame decoder
+//
+// Accepts arbitrary byte chunks (split or coalesced frames) and invokes the
+// callback once per complete, checksum-valid frame. Every byte is examined
+// once; on a bad header only the remaining header bytes are searched for the
+// next SOF, and a frame with a bad LRC3 is dropped as a whole.
+typedef struct ChameleonFrameDecoder ChameleonFrameDecoder;
+
+// Called with a view into the decoder buffer. The buffer is not touched again
+// until the callback returns, so a consumer may lend it out by blocking here.
+typedef void (*ChameleonFrameDecoderCallback)(const ChameleonFrameView* view, void* context);
+
+typedef struct {
+    uint32_t frames;        // Complete frames delivered
+    uint32_t header_errors; // Headers rejected (LRC1, LRC2 or LEN)
+    uint32_t data_errors;   // Frames dropped on LRC3 mismatch
+    uint32_t bytes_skipped; // Bytes discarded while hunting for SOF
+} ChameleonFrameDecoderStats;
+
+ChameleonFrameDecoder* chameleon_frame_decoder_alloc();
+void chameleon_frame_decoder_free(ChameleonFrameDecoder* decoder);
+
+void chameleon_frame_decoder_set_callback(
+    ChameleonFrameDecoder* decoder,
+    ChameleonFrameDecoderCallback callback,
+    void* context);
+
+// Drop any partially received frame
+void chameleon_frame_decoder_reset(ChameleonFrameDecoder* decoder);
+
+// Feed received bytes, callback fires for every frame completed by this chunk
+void chameleon_frame_decoder_feed(ChameleonFrameDecoder* decoder, const uint8_t* data, size_t length);
+
+void chameleon_frame_decoder_get_stats(ChameleonFrameDecoder* decoder, ChameleonFrameDecoderStats* stats);
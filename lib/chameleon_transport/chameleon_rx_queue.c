@@ -0,0 +1,177 @@
+#include "chameleon_rx_queue.h"
+#include <furi.h>
+#include <string.h>
+
+#define TAG "ChameleonRxQueue"
+
+// Bytes discarded at a time to make room for newer ones
+#define CHAMELEON_RX_QUEUE_DISCARD_SIZE 64
+
+typedef enum {
+    ChameleonRxQueueEventRx = (1 << 0), // Bytes in the stream for the worker
+    ChameleonRxQueueEventStop = (1 << 1),
+} ChameleonRxQueueEvent;
+
+#define CHAMELEON_RX_QUEUE_EVENTS_ALL (ChameleonRxQueueEventRx | ChameleonRxQueueEventStop)
+
+struct ChameleonRxQueue {
+    FuriThread* worker_thread; // Reads stream and runs the callback
+    FuriStreamBuffer* stream;
+    FuriMutex* mutex; // Serializes stream readers, the worker and drop-oldest discards
+    const char* worker_name;
+
+    ChameleonTransportRxCallback callback;
+    void* context;
+    ChameleonRxOverflow overflow;
+    uint32_t overflow_timeout_ms;
+    ChameleonRxStats stats; // Guarded by mutex
+};
+
+static int32_t chameleon_rx_queue_worker_thread(void* context) {
+    ChameleonRxQueue* queue = context;
+    uint8_t buffer[CHAMELEON_RX_QUEUE_CHUNK_SIZE];
+
+    while(true) {
+        uint32_t events = furi_thread_flags_wait(
+            CHAMELEON_RX_QUEUE_EVENTS_ALL, FuriFlagWaitAny, FuriWaitForever);
+        furi_check(!(events & FuriFlagError));
+
+        if(events & ChameleonRxQueueEventStop) break;
+
+        while(true) {
+            furi_mutex_acquire(queue->mutex, FuriWaitForever);
+            size_t received = furi_stream_buffer_receive(queue->stream, buffer, sizeof(buffer), 0);
+            furi_mutex_release(queue->mutex);
+
+            if(received == 0) break;
+
+            if(queue->callback) {
+                queue->callback(buffer, received, queue->context);
+            }
+        }
+    }
+
+    return 0;
+}
+
+ChameleonRxQueue* chameleon_rx_queue_alloc(size_t size, const char* worker_name) {
+    ChameleonRxQueue* queue = malloc(sizeof(ChameleonRxQueue));
+    memset(queue, 0, sizeof(ChameleonRxQueue));
+
+    queue->stream = furi_stream_buffer_alloc(size, 1);
+    queue->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    queue->worker_name = worker_name;
+    queue->overflow = ChameleonRxOverflowBlock;
+
+    return queue;
+}
+
+void chameleon_rx_queue_free(ChameleonRxQueue* queue) {
+    furi_assert(queue);
+
+    chameleon_rx_queue_stop(queue);
+
+    furi_mutex_free(queue->mutex);
+    furi_stream_buffer_free(queue->stream);
+    free(queue);
+}
+
+void chameleon_rx_queue_set_callback(
+    ChameleonRxQueue* queue,
+    ChameleonTransportRxCallback callback,
+    void* context) {
+    furi_assert(queue);
+    queue->callback = callback;
+    queue->context = context;
+}
+
+void chameleon_rx_queue_set_overflow(
+    ChameleonRxQueue* queue,
+    ChameleonRxOverflow overflow,
+    uint32_t timeout_ms) {
+    furi_assert(queue);
+    furi_assert(!queue->worker_thread);
+    queue->overflow = overflow;
+    queue->overflow_timeout_ms = timeout_ms;
+}
+
+void chameleon_rx_queue_start(ChameleonRxQueue* queue) {
+    furi_assert(queue);
+    furi_assert(!queue->worker_thread);
+
+    // The worker is stopped, nothing left of the previous session matters
+    furi_stream_buffer_reset(queue->stream);
+
+    queue->worker_thread = furi_thread_alloc();
+    furi_thread_set_name(queue->worker_thread, queue->worker_name);
+    furi_thread_set_stack_size(queue->worker_thread, 3072);
+    furi_thread_set_context(queue->worker_thread, queue);
+    furi_thread_set_callback(queue->worker_thread, chameleon_rx_queue_worker_thread);
+    furi_thread_start(queue->worker_thread);
+}
+
+void chameleon_rx_queue_stop(ChameleonRxQueue* queue) {
+    furi_assert(queue);
+
+    if(!queue->worker_thread) {
+        return;
+    }
+
+    furi_thread_flags_set(furi_thread_get_id(queue->worker_thread), ChameleonRxQueueEventStop);
+    furi_thread_join(queue->worker_thread);
+    furi_thread_free(queue->worker_thread);
+    queue->worker_thread = NULL;
+}
+
+void chameleon_rx_queue_push(ChameleonRxQueue* queue, const uint8_t* data, size_t length) {
+    furi_assert(queue);
+    furi_assert(queue->worker_thread);
+    size_t written;
+
+    if(queue->overflow == ChameleonRxOverflowDropOldest) {
+        furi_mutex_acquire(queue->mutex, FuriWaitForever);
+
+        // Discard from the head to make room, the worker cannot read meanwhile
+        size_t spaces = furi_stream_buffer_spaces_available(queue->stream);
+        size_t discard = length > spaces ? length - spaces : 0;
+        while(discard > 0) {
+            uint8_t scratch[CHAMELEON_RX_QUEUE_DISCARD_SIZE];
+            size_t chunk =
+                furi_stream_buffer_receive(queue->stream, scratch, MIN(discard, sizeof(scratch)), 0);
+            if(chunk == 0) break;
+            queue->stats.dropped += chunk;
+            discard -= chunk;
+        }
+
+        written = furi_stream_buffer_send(queue->stream, data, length, 0);
+
+        furi_mutex_release(queue->mutex);
+    } else {
+        uint32_t timeout = queue->overflow == ChameleonRxOverflowBlock ? queue->overflow_timeout_ms :
+                                                                         0;
+        written = furi_stream_buffer_send(queue->stream, data, length, timeout);
+    }
+
+    size_t available = furi_stream_buffer_bytes_available(queue->stream);
+
+    furi_mutex_acquire(queue->mutex, FuriWaitForever);
+    queue->stats.received += length;
+    queue->stats.dropped += length - written;
+    queue->stats.high_water = MAX(queue->stats.high_water, available);
+    furi_mutex_release(queue->mutex);
+
+    if(written < length) {
+        FURI_LOG_W(TAG, "RX overflow, dropped %zu bytes", length - written);
+    }
+
+    furi_thread_flags_set(furi_thread_get_id(queue->worker_thread), ChameleonRxQueueEventRx);
+}
+
+void chameleon_rx_queue_get_stats(ChameleonRxQueue* queue, ChameleonRxStats* stats) {
+    furi_assert(queue);
+    furi_assert(stats);
+
+    furi_mutex_acquire(queue->mutex, FuriWaitForever);
+    *stats = queue->stats;
+    furi_mutex_release(queue->mutex);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "chameleon_transport.h"
+
+// Bytes handed to the callback at a time
+#define CHAMELEON_RX_QUEUE_CHUNK_SIZE 256
+
+// Receive queue between a backend's reading thread and the consumer
+//
+// The reading thread pushes bytes as they come off the link, a worker thread
+// hands them to the receive callback. A slow consumer fills the buffer
+// instead of stalling the link, the overflow policy decides what happens
+// once it is full.
+typedef struct ChameleonRxQueue ChameleonRxQueue;
+
+// What to do when received bytes do not fit into the buffer
+typedef enum {
+    ChameleonRxOverflowDropOldest, // Discard buffered bytes to make room
+    ChameleonRxOverflowDropNewest, // Discard the bytes that do not fit
+    ChameleonRxOverflowBlock, // Stall the reading thread until room frees up or the timeout passes
+} ChameleonRxOverflow;
+
+// Receive counters since alloc
+typedef struct {
+    uint32_t received;
+    uint32_t dropped;
+    size_t high_water; // Most bytes ever waiting in the buffer
+} ChameleonRxStats;
+
+// Create and destroy queue, the worker thread takes the given name
+ChameleonRxQueue* chameleon_rx_queue_alloc(size_t size, const char* worker_name);
+void chameleon_rx_queue_free(ChameleonRxQueue* queue);
+
+// Set receive callback, runs on the worker thread
+void chameleon_rx_queue_set_callback(
+    ChameleonRxQueue* queue,
+    ChameleonTransportRxCallback callback,
+    void* context);
+
+// Set the overflow policy, the timeout only applies to ChameleonRxOverflowBlock.
+// Call while stopped.
+void chameleon_rx_queue_set_overflow(
+    ChameleonRxQueue* queue,
+    ChameleonRxOverflow overflow,
+    uint32_t timeout_ms);
+
+// Start/stop the worker, start drops anything left from the previous session
+void chameleon_rx_queue_start(ChameleonRxQueue* queue);
+void chameleon_rx_queue_stop(ChameleonRxQueue* queue);
+
+// Queue received bytes, from one reading thread while started
+void chameleon_rx_queue_push(ChameleonRxQueue* queue, const uint8_t* data, size_t length);
+
+void chameleon_rx_queue_get_stats(ChameleonRxQueue* queue, ChameleonRxStats* stats);
@@ -0,0 +1,102 @@
+#include "chameleon_transport.h"
+#include <furi.h>
+#include <string.h>
+
+#define TAG "ChameleonTransport"
+
+void chameleon_transport_init(
+    ChameleonTransport* transport,
+    const ChameleonTransportInterface* interface,
+    void* instance) {
+    furi_assert(transport);
+    furi_assert(!interface || instance);
+
+    transport->interface = interface;
+    transport->instance = instance;
+}
+
+bool chameleon_transport_is_bound(const ChameleonTransport* transport) {
+    furi_assert(transport);
+    return transport->interface != NULL;
+}
+
+bool chameleon_transport_send(
+    const ChameleonTransport* transport,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    furi_assert(transport);
+
+    if(!transport->interface) {
+        FURI_LOG_E(TAG, "Not connected");
+        return false;
+    }
+
+    return transport->interface->send(
+        transport->instance, header, header_len, payload, payload_len, trailer, trailer_len);
+}
+
+void chameleon_transport_start_rx(const ChameleonTransport* transport) {
+    furi_assert(transport);
+    furi_assert(transport->interface);
+    transport->interface->start_rx(transport->instance);
+}
+
+void chameleon_transport_stop_rx(const ChameleonTransport* transport) {
+    furi_assert(transport);
+    furi_assert(transport->interface);
+    transport->interface->stop_rx(transport->instance);
+}
+
+bool chameleon_transport_delivers_frames(const ChameleonTransport* transport) {
+    furi_assert(transport);
+    furi_assert(transport->interface);
+    return transport->interface->set_frame_callback != NULL;
+}
+
+void chameleon_transport_set_rx_callback(
+    const ChameleonTransport* transport,
+    ChameleonTransportRxCallback callback,
+    void* context) {
+    furi_assert(transport);
+    furi_assert(transport->interface);
+
+    if(transport->interface->set_rx_callback) {
+        transport->interface->set_rx_callback(transport->instance, callback, context);
+    }
+}
+
+void chameleon_transport_set_frame_callback(
+    const ChameleonTransport* transport,
+    ChameleonTransportFrameCallback callback,
+    void* context) {
+    furi_assert(transport);
+    furi_assert(transport->interface);
+
+    if(transport->interface->set_frame_callback) {
+        transport->interface->set_frame_callback(transport->instance, callback, context);
+    }
+}
+
+size_t chameleon_transport_get_mtu(const ChameleonTransport* transport) {
+    furi_assert(transport);
+    furi_assert(transport->interface);
+    return transport->interface->get_mtu(transport->instance);
+}
+
+void chameleon_transport_get_stats(
+    const ChameleonTransport* transport,
+    ChameleonTransportStats* stats) {
+    furi_assert(transport);
+    furi_assert(stats);
+
+    if(!transport->interface) {
+        memset(stats, 0, sizeof(ChameleonTransportStats));
+        return;
+    }
+
+    transport->interface->get_stats(transport->instance, stats);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../chameleon_protocol/chameleon_protocol.h"
+
+// Callback for received bytes, chunks may hold partial or multiple frames
+typedef void (*ChameleonTransportRxCallback)(const uint8_t* data, size_t length, void* context);
+
+// Callback for received frames of backends that reassemble them, one checked
+// frame per call
+typedef void (*ChameleonTransportFrameCallback)(const ChameleonFrameView* view, void* context);
+
+// Transport counters since alloc, zero where a backend does not track them
+typedef struct {
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t rx_dropped;
+    size_t rx_high_water; // Most received bytes ever waiting for the consumer
+} ChameleonTransportStats;
+
+// Backend operations, each takes the backend instance as its first argument
+typedef struct {
+    const char* name;
+
+    // Send one frame given as header/payload/trailer segments (any may be empty)
+    bool (*send)(
+        void* instance,
+        const uint8_t* header,
+        size_t header_len,
+        const uint8_t* payload,
+        size_t payload_len,
+        const uint8_t* trailer,
+        size_t trailer_len);
+
+    void (*start_rx)(void* instance);
+    void (*stop_rx)(void* instance);
+
+    // Backends provide one of these. Byte streams leave framing to the
+    // consumer, a backend that reassembles frames itself hands them over
+    // whole so they are not decoded twice.
+    void (*set_rx_callback)(void* instance, ChameleonTransportRxCallback callback, void* context);
+    void (*set_frame_callback)(
+        void* instance,
+        ChameleonTransportFrameCallback callback,
+        void* context);
+
+    // Largest unit the link moves at once, frames are split at this size
+    size_t (*get_mtu)(void* instance);
+
+    void (*get_stats)(void* instance, ChameleonTransportStats* stats);
+} ChameleonTransportInterface;
+
+// Backend operations bound to an instance, copied by value
+typedef struct {
+    const ChameleonTransportInterface* interface;
+    void* instance;
+} ChameleonTransport;
+
+// Bind a backend instance
+void chameleon_transport_init(
+    ChameleonTransport* transport,
+    const ChameleonTransportInterface* interface,
+    void* instance);
+
+// Check whether a backend is bound
+bool chameleon_transport_is_bound(const ChameleonTransport* transport);
+
+// Send one frame as header/payload/trailer segments, false if unbound
+bool chameleon_transport_send(
+    const ChameleonTransport* transport,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len);
+
+// Start/stop receiving
+void chameleon_transport_start_rx(const ChameleonTransport* transport);
+void chameleon_transport_stop_rx(const ChameleonTransport* transport);
+
+// Check whether the backend delivers whole frames instead of bytes
+bool chameleon_transport_delivers_frames(const ChameleonTransport* transport);
+
+// Set receive callbacks, each does nothing on backends without it
+void chameleon_transport_set_rx_callback(
+    const ChameleonTransport* transport,
+    ChameleonTransportRxCallback callback,
+    void* context);
+void chameleon_transport_set_frame_callback(
+    const ChameleonTransport* transport,
+    ChameleonTransportFrameCallback callback,
+    void* context);
+
+// Get link MTU and counters
+size_t chameleon_transport_get_mtu(const ChameleonTransport* transport);
+void chameleon_transport_get_stats(
+    const ChameleonTransport* transport,
+    ChameleonTransportStats* stats);
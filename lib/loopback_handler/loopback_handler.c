@@ -0,0 +1,238 @@
+#include "loopback_handler.h"
+#include <furi.h>
+#include <string.h>
+
+#define TAG "LoopbackHandler"
+
+typedef enum {
+    LoopbackHandlerEventTx = (1 << 0),
+    LoopbackHandlerEventStop = (1 << 1),
+} LoopbackHandlerEvent;
+
+#define LOOPBACK_HANDLER_EVENTS_ALL (LoopbackHandlerEventTx | LoopbackHandlerEventStop)
+
+struct LoopbackHandler {
+    FuriThread* thread;
+    FuriStreamBuffer* tx_stream;
+    FuriMutex* mutex; // Keeps frames contiguous and guards the counters
+
+    LoopbackHandlerRxCallback rx_callback;
+    void* rx_context;
+    LoopbackHandlerDeviceCallback device_callback;
+    void* device_context;
+
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    bool running;
+};
+
+static int32_t loopback_handler_thread(void* context) {
+    LoopbackHandler* handler = context;
+    uint8_t buffer[LOOPBACK_MTU];
+
+    while(true) {
+        uint32_t events = furi_thread_flags_wait(
+            LOOPBACK_HANDLER_EVENTS_ALL, FuriFlagWaitAny, FuriWaitForever);
+        furi_check(!(events & FuriFlagError));
+
+        if(events & LoopbackHandlerEventStop) break;
+
+        while(true) {
+            size_t length = furi_stream_buffer_receive(handler->tx_stream, buffer, sizeof(buffer), 0);
+            if(length == 0) break;
+
+            if(handler->device_callback) {
+                handler->device_callback(buffer, length, handler->device_context);
+            } else {
+                loopback_handler_inject(handler, buffer, length);
+            }
+        }
+    }
+
+    return 0;
+}
+
+LoopbackHandler* loopback_handler_alloc() {
+    LoopbackHandler* handler = malloc(sizeof(LoopbackHandler));
+    memset(handler, 0, sizeof(LoopbackHandler));
+
+    handler->tx_stream = furi_stream_buffer_alloc(LOOPBACK_BUFFER_SIZE, 1);
+    handler->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+
+    return handler;
+}
+
+void loopback_handler_free(LoopbackHandler* handler) {
+    furi_assert(handler);
+
+    loopback_handler_stop_rx(handler);
+
+    furi_mutex_free(handler->mutex);
+    furi_stream_buffer_free(handler->tx_stream);
+    free(handler);
+}
+
+void loopback_handler_set_rx_callback(
+    LoopbackHandler* handler,
+    LoopbackHandlerRxCallback callback,
+    void* context) {
+    furi_assert(handler);
+    handler->rx_callback = callback;
+    handler->rx_context = context;
+}
+
+void loopback_handler_set_device_callback(
+    LoopbackHandler* handler,
+    LoopbackHandlerDeviceCallback callback,
+    void* context) {
+    furi_assert(handler);
+    furi_assert(!handler->running);
+    handler->device_callback = callback;
+    handler->device_context = context;
+}
+
+bool loopback_handler_send_segments(
+    LoopbackHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    furi_assert(handler);
+    furi_assert(header || header_len == 0);
+    furi_assert(payload || payload_len == 0);
+    furi_assert(trailer || trailer_len == 0);
+
+    size_t total = header_len + payload_len + trailer_len;
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+
+    if(furi_stream_buffer_spaces_available(handler->tx_stream) < total) {
+        furi_mutex_release(handler->mutex);
+        FURI_LOG_E(TAG, "TX queue full");
+        return false;
+    }
+
+    const uint8_t* segment_data[] = {header, payload, trailer};
+    const size_t segment_len[] = {header_len, payload_len, trailer_len};
+    for(size_t i = 0; i < COUNT_OF(segment_data); i++) {
+        if(segment_len[i]) {
+            furi_stream_buffer_send(handler->tx_stream, segment_data[i], segment_len[i], 0);
+        }
+    }
+    handler->tx_bytes += total;
+
+    if(handler->running) {
+        furi_thread_flags_set(furi_thread_get_id(handler->thread), LoopbackHandlerEventTx);
+    }
+
+    furi_mutex_release(handler->mutex);
+
+    return true;
+}
+
+void loopback_handler_inject(LoopbackHandler* handler, const uint8_t* data, size_t length) {
+    furi_assert(handler);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->rx_bytes += length;
+    furi_mutex_release(handler->mutex);
+
+    if(handler->rx_callback) {
+        handler->rx_callback(data, length, handler->rx_context);
+    }
+}
+
+void loopback_handler_start_rx(LoopbackHandler* handler) {
+    furi_assert(handler);
+
+    if(handler->running) {
+        FURI_LOG_W(TAG, "RX already running");
+        return;
+    }
+
+    handler->thread = furi_thread_alloc();
+    furi_thread_set_name(handler->thread, "LoopbackThread");
+    furi_thread_set_stack_size(handler->thread, 2048);
+    furi_thread_set_context(handler->thread, handler);
+    furi_thread_set_callback(handler->thread, loopback_handler_thread);
+    furi_thread_start(handler->thread);
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->running = true;
+    furi_mutex_release(handler->mutex);
+
+    // Deliver anything sent before the thread was running
+    furi_thread_flags_set(furi_thread_get_id(handler->thread), LoopbackHandlerEventTx);
+}
+
+void loopback_handler_stop_rx(LoopbackHandler* handler) {
+    furi_assert(handler);
+
+    if(!handler->running) {
+        return;
+    }
+
+    // Senders stop waking the thread before it goes away
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    handler->running = false;
+    furi_mutex_release(handler->mutex);
+
+    furi_thread_flags_set(furi_thread_get_id(handler->thread), LoopbackHandlerEventStop);
+    furi_thread_join(handler->thread);
+    furi_thread_free(handler->thread);
+    handler->thread = NULL;
+}
+
+static bool loopback_handler_transport_send(
+    void* instance,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    return loopback_handler_send_segments(
+        instance, header, header_len, payload, payload_len, trailer, trailer_len);
+}
+
+static void loopback_handler_transport_start_rx(void* instance) {
+    loopback_handler_start_rx(instance);
+}
+
+static void loopback_handler_transport_stop_rx(void* instance) {
+    loopback_handler_stop_rx(instance);
+}
+
+static void loopback_handler_transport_set_rx_callback(
+    void* instance,
+    ChameleonTransportRxCallback callback,
+    void* context) {
+    loopback_handler_set_rx_callback(instance, callback, context);
+}
+
+static size_t loopback_handler_transport_get_mtu(void* instance) {
+    UNUSED(instance);
+    return LOOPBACK_MTU;
+}
+
+static void loopback_handler_transport_get_stats(void* instance, ChameleonTransportStats* stats) {
+    LoopbackHandler* handler = instance;
+    memset(stats, 0, sizeof(ChameleonTransportStats));
+
+    furi_mutex_acquire(handler->mutex, FuriWaitForever);
+    stats->tx_bytes = handler->tx_bytes;
+    stats->rx_bytes = handler->rx_bytes;
+    furi_mutex_release(handler->mutex);
+}
+
+const ChameleonTransportInterface loopback_handler_transport = {
+    .name = "Loopback",
+    .send = loopback_handler_transport_send,
+    .start_rx = loopback_handler_transport_start_rx,
+    .stop_rx = loopback_handler_transport_stop_rx,
+    .set_rx_callback = loopback_handler_transport_set_rx_callback,
+    .get_mtu = loopback_handler_transport_get_mtu,
+    .get_stats = loopback_handler_transport_get_stats,
+};
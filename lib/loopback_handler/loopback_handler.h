@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../chameleon_transport/chameleon_transport.h"
+
+// Bytes queued between sender and device side
+#define LOOPBACK_BUFFER_SIZE 4096
+
+// Largest chunk handed to the device callback at once
+#define LOOPBACK_MTU 64
+
+// In-memory transport for host tests and benchmarks
+//
+// Sent bytes are handed to a device callback on the loopback thread, the
+// device answers through loopback_handler_inject. Without a device callback
+// sent bytes are echoed back.
+typedef struct LoopbackHandler LoopbackHandler;
+
+// Callback for received data, runs on the thread calling loopback_handler_inject
+typedef void (*LoopbackHandlerRxCallback)(const uint8_t* data, size_t length, void* context);
+
+// Callback for bytes arriving at the device side, runs on the loopback thread
+typedef void (*LoopbackHandlerDeviceCallback)(const uint8_t* data, size_t length, void* context);
+
+// Create and destroy loopback handler
+LoopbackHandler* loopback_handler_alloc();
+void loopback_handler_free(LoopbackHandler* handler);
+
+// Set callbacks, the device callback only while RX is stopped
+void loopback_handler_set_rx_callback(
+    LoopbackHandler* handler,
+    LoopbackHandlerRxCallback callback,
+    void* context);
+void loopback_handler_set_device_callback(
+    LoopbackHandler* handler,
+    LoopbackHandlerDeviceCallback callback,
+    void* context);
+
+// Queue one frame given as header/payload/trailer segments (any may be empty)
+bool loopback_handler_send_segments(
+    LoopbackHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len);
+
+// Deliver device bytes to the receive callback
+void loopback_handler_inject(LoopbackHandler* handler, const uint8_t* data, size_t length);
+
+// Start/stop the loopback thread
+void loopback_handler_start_rx(LoopbackHandler* handler);
+void loopback_handler_stop_rx(LoopbackHandler* handler);
+
+// Transport operations, the instance is a LoopbackHandler
+extern const ChameleonTransportInterface loopback_handler_transport;
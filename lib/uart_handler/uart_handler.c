@@ -1,53 +1,165 @@
 #include "uart_handler.h"
 #include <furi.h>
+#include <furi_hal_usb.h>
 #include <furi_hal_usb_cdc.h>
 #include <string.h>
 
 #define TAG "UartHandler"
 
+typedef enum {
+    UartHandlerEventRx = (1 << 0), // CDC packet ready
+    UartHandlerEventStop = (1 << 1),
+    UartHandlerEventTx = (1 << 2), // Packets queued in tx_packets
+    UartHandlerEventTxDone = (1 << 3), // IN packet taken by the host
+} UartHandlerEvent;
+
+#define UART_HANDLER_EVENTS_ALL (UartHandlerEventRx | UartHandlerEventStop)
+#define UART_HANDLER_TX_EVENTS_ALL (UartHandlerEventTx | UartHandlerEventStop)
+
+#define UART_HANDLER_TX_PACKETS (UART_TX_BUFFER_SIZE / CDC_DATA_SZ)
+
+// One endpoint packet, frames are split into these as they are queued
+typedef struct {
+    uint8_t data[CDC_DATA_SZ];
+    size_t length;
+} UartHandlerPacket;
+
 struct UartHandler {
-    FuriThread* rx_thread;
-    FuriStreamBuffer* rx_stream;
-    UartHandlerRxCallback rx_callback;
-    void* rx_context;
+    FuriThread* rx_thread; // Drains the CDC endpoint into rx_queue
+    ChameleonRxQueue* rx_queue; // Runs the rx callback on its worker thread
+
+    FuriThread* tx_thread; // Sends tx_packets in order
+    UartHandlerPacket tx_packets[UART_HANDLER_TX_PACKETS]; // Ring of packets
+    size_t tx_head; // Next packet to fill, guarded by tx_mutex
+    size_t tx_tail; // Next packet to send, owned by the TX thread
+    FuriSemaphore* tx_free; // Packets senders may fill, posted as each is sent
+    FuriSemaphore* tx_ready; // Packets the TX thread may send
+    FuriMutex* tx_mutex; // Keeps frames from different senders contiguous
+    uint32_t tx_bytes; // Guarded by tx_mutex
+
+    FuriHalUsbInterface* usb_prev; // Config restored on deinit
+
+    // Threads woken from the USB interrupt, NULL while not running
+    FuriThreadId rx_thread_id;
+    FuriThreadId tx_thread_id;
+
     bool initialized;
     bool running;
 };
 
+// Called from the USB interrupt when an OUT packet is ready
+static void uart_handler_cdc_rx_callback(void* context) {
+    UartHandler* handler = context;
+    if(handler->rx_thread_id) {
+        furi_thread_flags_set(handler->rx_thread_id, UartHandlerEventRx);
+    }
+}
+
+// Called from the USB interrupt when the host has taken an IN packet
+static void uart_handler_cdc_tx_callback(void* context) {
+    UartHandler* handler = context;
+    if(handler->tx_thread_id) {
+        furi_thread_flags_set(handler->tx_thread_id, UartHandlerEventTxDone);
+    }
+}
+
+static CdcCallbacks uart_handler_cdc_callbacks = {
+    .tx_ep_callback = uart_handler_cdc_tx_callback,
+    .rx_ep_callback = uart_handler_cdc_rx_callback,
+    .state_callback = NULL,
+    .ctrl_line_callback = NULL,
+    .config_callback = NULL,
+};
+
 static int32_t uart_handler_rx_thread(void* context) {
     UartHandler* handler = context;
-    uint8_t buffer[UART_RX_BUFFER_SIZE];
+    uint8_t buffer[CDC_DATA_SZ];
 
     FURI_LOG_I(TAG, "RX thread started");
 
-    while(handler->running) {
-        // Read from USB CDC (interface 0)
-        size_t received = furi_hal_cdc_receive(0, buffer, sizeof(buffer));
+    while(true) {
+        uint32_t events =
+            furi_thread_flags_wait(UART_HANDLER_EVENTS_ALL, FuriFlagWaitAny, FuriWaitForever);
+        furi_check(!(events & FuriFlagError));
 
-        if(received > 0) {
-            FURI_LOG_D(TAG, "Received %zu bytes", received);
+        if(events & UartHandlerEventStop) break;
 
-            // Write to stream buffer
-            furi_stream_buffer_send(handler->rx_stream, buffer, received, FuriWaitForever);
+        // One flag may stand for several packets, read until the endpoint is empty
+        while(true) {
+            int32_t received = furi_hal_cdc_receive(UART_CDC_CHANNEL, buffer, sizeof(buffer));
+            if(received <= 0) break;
 
-            // Call callback if set
-            if(handler->rx_callback) {
-                handler->rx_callback(buffer, received, handler->rx_context);
-            }
+            FURI_LOG_D(TAG, "Received %zu bytes", (size_t)received);
+            chameleon_rx_queue_push(handler->rx_queue, buffer, received);
         }
-
-        furi_delay_ms(10);
     }
 
     FURI_LOG_I(TAG, "RX thread stopped");
     return 0;
 }
 
+// Send one packet and wait until the host takes it, false once asked to stop
+static bool uart_handler_tx_packet(uint8_t* packet, size_t length) {
+    furi_thread_flags_clear(UartHandlerEventTxDone);
+    furi_hal_cdc_send(UART_CDC_CHANNEL, packet, length);
+
+    uint32_t events = furi_thread_flags_wait(
+        UartHandlerEventTxDone | UartHandlerEventStop, FuriFlagWaitAny, UART_TX_TIMEOUT_MS);
+    if(events & FuriFlagError) {
+        FURI_LOG_W(TAG, "TX timeout, host not reading");
+        return true;
+    }
+
+    return !(events & UartHandlerEventStop);
+}
+
+static int32_t uart_handler_tx_thread(void* context) {
+    UartHandler* handler = context;
+    bool running = true;
+
+    FURI_LOG_I(TAG, "TX thread started");
+
+    while(running) {
+        uint32_t events =
+            furi_thread_flags_wait(UART_HANDLER_TX_EVENTS_ALL, FuriFlagWaitAny, FuriWaitForever);
+        furi_check(!(events & FuriFlagError));
+
+        if(events & UartHandlerEventStop) break;
+
+        // Send until the ring is empty, a stop ends it between two packets
+        size_t last_len = 0;
+        while(running && furi_semaphore_acquire(handler->tx_ready, 0) == FuriStatusOk) {
+            UartHandlerPacket* packet = &handler->tx_packets[handler->tx_tail];
+            running = uart_handler_tx_packet(packet->data, packet->length);
+
+            // Senders may refill the packet as soon as it is released
+            last_len = packet->length;
+            handler->tx_tail = (handler->tx_tail + 1) % UART_HANDLER_TX_PACKETS;
+            furi_semaphore_release(handler->tx_free);
+        }
+
+        // A transfer ending on a full packet needs a zero length packet to complete
+        if(running && last_len == CDC_DATA_SZ) {
+            uint8_t zlp = 0;
+            running = uart_handler_tx_packet(&zlp, 0);
+        }
+    }
+
+    FURI_LOG_I(TAG, "TX thread stopped");
+    return 0;
+}
+
 UartHandler* uart_handler_alloc() {
     UartHandler* handler = malloc(sizeof(UartHandler));
     memset(handler, 0, sizeof(UartHandler));
 
-    handler->rx_stream = furi_stream_buffer_alloc(UART_RX_BUFFER_SIZE, 1);
+    handler->rx_queue = chameleon_rx_queue_alloc(UART_RX_BUFFER_SIZE, "UartRxWorker");
+    chameleon_rx_queue_set_overflow(
+        handler->rx_queue, ChameleonRxOverflowBlock, UART_RX_BLOCK_TIMEOUT_MS);
+
+    handler->tx_free = furi_semaphore_alloc(UART_HANDLER_TX_PACKETS, UART_HANDLER_TX_PACKETS);
+    handler->tx_ready = furi_semaphore_alloc(UART_HANDLER_TX_PACKETS, 0);
+    handler->tx_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
 
     return handler;
 }
@@ -59,7 +171,10 @@ void uart_handler_free(UartHandler* handler) {
         uart_handler_deinit(handler);
     }
 
-    furi_stream_buffer_free(handler->rx_stream);
+    furi_mutex_free(handler->tx_mutex);
+    furi_semaphore_free(handler->tx_ready);
+    furi_semaphore_free(handler->tx_free);
+    chameleon_rx_queue_free(handler->rx_queue);
     free(handler);
 }
 
@@ -73,8 +188,26 @@ bool uart_handler_init(UartHandler* handler) {
 
     FURI_LOG_I(TAG, "Initializing UART/USB CDC");
 
-    // USB CDC is automatically initialized by Flipper OS
-    // We just need to ensure it's available
+    // Channel 0 belongs to the CLI, take a channel of our own like the
+    // USB-UART bridge does instead of replacing the CLI's callbacks
+    handler->usb_prev = furi_hal_usb_get_config();
+    if(!furi_hal_usb_set_config(&usb_cdc_dual, NULL)) {
+        FURI_LOG_E(TAG, "USB is locked");
+        return false;
+    }
+
+    handler->tx_thread = furi_thread_alloc();
+    furi_thread_set_name(handler->tx_thread, "UartTxThread");
+    furi_thread_set_stack_size(handler->tx_thread, 1024);
+    furi_thread_set_context(handler->tx_thread, handler);
+    furi_thread_set_callback(handler->tx_thread, uart_handler_tx_thread);
+    furi_thread_start(handler->tx_thread);
+
+    FURI_CRITICAL_ENTER();
+    handler->tx_thread_id = furi_thread_get_id(handler->tx_thread);
+    FURI_CRITICAL_EXIT();
+
+    furi_hal_cdc_set_callbacks(UART_CDC_CHANNEL, &uart_handler_cdc_callbacks, handler);
 
     handler->initialized = true;
 
@@ -93,6 +226,28 @@ void uart_handler_deinit(UartHandler* handler) {
 
     handler->initialized = false;
 
+    // No more wakeups once the threads are gone
+    furi_hal_cdc_set_callbacks(UART_CDC_CHANNEL, NULL, NULL);
+
+    FURI_CRITICAL_ENTER();
+    handler->tx_thread_id = NULL;
+    FURI_CRITICAL_EXIT();
+
+    // Frames still queued are dropped with the connection
+    furi_thread_flags_set(furi_thread_get_id(handler->tx_thread), UartHandlerEventStop);
+    furi_thread_join(handler->tx_thread);
+    furi_thread_free(handler->tx_thread);
+    handler->tx_thread = NULL;
+
+    while(furi_semaphore_acquire(handler->tx_ready, 0) == FuriStatusOk) {
+        furi_semaphore_release(handler->tx_free);
+    }
+    handler->tx_tail = handler->tx_head;
+
+    // Gives the CLI back its single port config
+    furi_hal_usb_set_config(handler->usb_prev, NULL);
+    handler->usb_prev = NULL;
+
     FURI_LOG_I(TAG, "UART/USB CDC deinitialized");
 }
 
@@ -101,23 +256,110 @@ void uart_handler_set_rx_callback(
     UartHandlerRxCallback callback,
     void* context) {
     furi_assert(handler);
-    handler->rx_callback = callback;
-    handler->rx_context = context;
+    chameleon_rx_queue_set_callback(handler->rx_queue, callback, context);
+}
+
+void uart_handler_set_overflow(
+    UartHandler* handler,
+    ChameleonRxOverflow overflow,
+    uint32_t timeout_ms) {
+    furi_assert(handler);
+    furi_assert(!handler->running);
+    chameleon_rx_queue_set_overflow(handler->rx_queue, overflow, timeout_ms);
+}
+
+void uart_handler_get_rx_stats(UartHandler* handler, ChameleonRxStats* stats) {
+    furi_assert(handler);
+    chameleon_rx_queue_get_stats(handler->rx_queue, stats);
 }
 
 bool uart_handler_send(UartHandler* handler, const uint8_t* data, size_t length) {
+    return uart_handler_send_segments(handler, data, length, NULL, 0, NULL, 0);
+}
+
+bool uart_handler_send_segments(
+    UartHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
     furi_assert(handler);
-    furi_assert(data);
+    furi_assert(header || header_len == 0);
+    furi_assert(payload || payload_len == 0);
+    furi_assert(trailer || trailer_len == 0);
 
     if(!handler->initialized) {
         FURI_LOG_E(TAG, "Not initialized");
         return false;
     }
 
-    FURI_LOG_D(TAG, "Sending %zu bytes", length);
+    size_t total = header_len + payload_len + trailer_len;
+    size_t packets = (total + CDC_DATA_SZ - 1) / CDC_DATA_SZ;
+    if(packets > UART_HANDLER_TX_PACKETS) {
+        FURI_LOG_E(TAG, "Frame of %zu bytes exceeds TX buffer", total);
+        return false;
+    }
+
+    FURI_LOG_D(TAG, "Queueing %zu bytes", total);
+
+    furi_mutex_acquire(handler->tx_mutex, FuriWaitForever);
 
-    // Send via USB CDC (interface 0)
-    furi_hal_cdc_send(0, (uint8_t*)data, length);
+    // Only queue whole frames, sleep until the TX thread has sent enough
+    uint32_t start = furi_get_tick();
+    size_t reserved = 0;
+    while(reserved < packets) {
+        uint32_t elapsed = furi_get_tick() - start;
+        if(elapsed >= UART_TX_TIMEOUT_MS ||
+           furi_semaphore_acquire(handler->tx_free, UART_TX_TIMEOUT_MS - elapsed) !=
+               FuriStatusOk) {
+            break;
+        }
+        reserved++;
+    }
+
+    if(reserved < packets) {
+        while(reserved--) {
+            furi_semaphore_release(handler->tx_free);
+        }
+        furi_mutex_release(handler->tx_mutex);
+        FURI_LOG_E(TAG, "TX queue full");
+        return false;
+    }
+
+    // Segments go straight into endpoint packets, frames share none
+    const uint8_t* segment_data[] = {header, payload, trailer};
+    const size_t segment_len[] = {header_len, payload_len, trailer_len};
+    UartHandlerPacket* packet = &handler->tx_packets[handler->tx_head];
+    packet->length = 0;
+
+    for(size_t i = 0; i < COUNT_OF(segment_data); i++) {
+        size_t offset = 0;
+        while(offset < segment_len[i]) {
+            size_t chunk = MIN(segment_len[i] - offset, CDC_DATA_SZ - packet->length);
+            memcpy(&packet->data[packet->length], &segment_data[i][offset], chunk);
+            packet->length += chunk;
+            offset += chunk;
+
+            if(packet->length == CDC_DATA_SZ) {
+                handler->tx_head = (handler->tx_head + 1) % UART_HANDLER_TX_PACKETS;
+                furi_semaphore_release(handler->tx_ready);
+                packet = &handler->tx_packets[handler->tx_head];
+                packet->length = 0;
+            }
+        }
+    }
+
+    if(packet->length > 0) {
+        handler->tx_head = (handler->tx_head + 1) % UART_HANDLER_TX_PACKETS;
+        furi_semaphore_release(handler->tx_ready);
+    }
+    handler->tx_bytes += total;
+
+    furi_mutex_release(handler->tx_mutex);
+
+    furi_thread_flags_set(furi_thread_get_id(handler->tx_thread), UartHandlerEventTx);
 
     return true;
 }
@@ -137,6 +379,9 @@ void uart_handler_start_rx(UartHandler* handler) {
 
     handler->running = true;
 
+    // The worker has to be running before the first push
+    chameleon_rx_queue_start(handler->rx_queue);
+
     handler->rx_thread = furi_thread_alloc();
     furi_thread_set_name(handler->rx_thread, "UartRxThread");
     furi_thread_set_stack_size(handler->rx_thread, 2048);
@@ -144,6 +389,13 @@ void uart_handler_start_rx(UartHandler* handler) {
     furi_thread_set_callback(handler->rx_thread, uart_handler_rx_thread);
     furi_thread_start(handler->rx_thread);
 
+    FURI_CRITICAL_ENTER();
+    handler->rx_thread_id = furi_thread_get_id(handler->rx_thread);
+    FURI_CRITICAL_EXIT();
+
+    // Pick up anything that arrived before the thread was listening
+    furi_thread_flags_set(handler->rx_thread_id, UartHandlerEventRx);
+
     FURI_LOG_I(TAG, "RX started");
 }
 
@@ -156,11 +408,75 @@ void uart_handler_stop_rx(UartHandler* handler) {
 
     handler->running = false;
 
+    // No more wakeups once the thread is gone
+    FURI_CRITICAL_ENTER();
+    handler->rx_thread_id = NULL;
+    FURI_CRITICAL_EXIT();
+
     if(handler->rx_thread) {
+        furi_thread_flags_set(furi_thread_get_id(handler->rx_thread), UartHandlerEventStop);
         furi_thread_join(handler->rx_thread);
         furi_thread_free(handler->rx_thread);
         handler->rx_thread = NULL;
     }
 
+    chameleon_rx_queue_stop(handler->rx_queue);
+
     FURI_LOG_I(TAG, "RX stopped");
 }
+
+static bool uart_handler_transport_send(
+    void* instance,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len) {
+    return uart_handler_send_segments(
+        instance, header, header_len, payload, payload_len, trailer, trailer_len);
+}
+
+static void uart_handler_transport_start_rx(void* instance) {
+    uart_handler_start_rx(instance);
+}
+
+static void uart_handler_transport_stop_rx(void* instance) {
+    uart_handler_stop_rx(instance);
+}
+
+static void uart_handler_transport_set_rx_callback(
+    void* instance,
+    ChameleonTransportRxCallback callback,
+    void* context) {
+    uart_handler_set_rx_callback(instance, callback, context);
+}
+
+static size_t uart_handler_transport_get_mtu(void* instance) {
+    UNUSED(instance);
+    return CDC_DATA_SZ;
+}
+
+static void uart_handler_transport_get_stats(void* instance, ChameleonTransportStats* stats) {
+    UartHandler* handler = instance;
+    ChameleonRxStats rx_stats;
+    uart_handler_get_rx_stats(handler, &rx_stats);
+
+    furi_mutex_acquire(handler->tx_mutex, FuriWaitForever);
+    stats->tx_bytes = handler->tx_bytes;
+    furi_mutex_release(handler->tx_mutex);
+
+    stats->rx_bytes = rx_stats.received;
+    stats->rx_dropped = rx_stats.dropped;
+    stats->rx_high_water = rx_stats.high_water;
+}
+
+const ChameleonTransportInterface uart_handler_transport = {
+    .name = "USB",
+    .send = uart_handler_transport_send,
+    .start_rx = uart_handler_transport_start_rx,
+    .stop_rx = uart_handler_transport_stop_rx,
+    .set_rx_callback = uart_handler_transport_set_rx_callback,
+    .get_mtu = uart_handler_transport_get_mtu,
+    .get_stats = uart_handler_transport_get_stats,
+};
@@ -5,33 +5,76 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "../chameleon_transport/chameleon_transport.h"
+#include "../chameleon_transport/chameleon_rx_queue.h"
+
 // UART configuration for USB communication
 #define UART_BAUD_RATE 115200
+
+// CDC channel of the dual port USB config the handler switches to while
+// initialized, channel 0 stays with the Flipper CLI
+#define UART_CDC_CHANNEL 1
 #define UART_RX_BUFFER_SIZE 1024
 
+// Default time the USB side waits for room before dropping bytes
+#define UART_RX_BLOCK_TIMEOUT_MS 50
+
+// Bytes of endpoint packets waiting for the TX thread, at least one maximum
+// size frame
+#define UART_TX_BUFFER_SIZE 2048
+
+// Time to wait for the host to take a packet, or for room in the TX queue
+#define UART_TX_TIMEOUT_MS 100
+
 // UART handler instance
 typedef struct UartHandler UartHandler;
 
-// Callback for received data
+// Callback for received data, runs on the RX worker thread
 typedef void (*UartHandlerRxCallback)(const uint8_t* data, size_t length, void* context);
 
 // Create and destroy UART handler
 UartHandler* uart_handler_alloc();
 void uart_handler_free(UartHandler* handler);
 
-// Initialize UART (USB CDC)
+// Initialize UART (USB CDC), switches USB to the dual port config and back
+// on deinit. Fails while USB is locked by another application.
 bool uart_handler_init(UartHandler* handler);
 void uart_handler_deinit(UartHandler* handler);
 
 // Set receive callback
 void uart_handler_set_rx_callback(UartHandler* handler, UartHandlerRxCallback callback, void* context);
 
-// Send data
+// Set the overflow policy of the RX buffer, the timeout only applies to
+// ChameleonRxOverflowBlock, which stops reading USB meanwhile. Call while RX
+// is stopped.
+void uart_handler_set_overflow(
+    UartHandler* handler,
+    ChameleonRxOverflow overflow,
+    uint32_t timeout_ms);
+
+// Get receive counters
+void uart_handler_get_rx_stats(UartHandler* handler, ChameleonRxStats* stats);
+
+// Split data into endpoint packets for the TX thread, returns once queued or
+// false when the TX thread frees no room within UART_TX_TIMEOUT_MS
 bool uart_handler_send(UartHandler* handler, const uint8_t* data, size_t length);
 
+// Send one frame given as header/payload/trailer segments (any may be empty)
+bool uart_handler_send_segments(
+    UartHandler* handler,
+    const uint8_t* header,
+    size_t header_len,
+    const uint8_t* payload,
+    size_t payload_len,
+    const uint8_t* trailer,
+    size_t trailer_len);
+
 // Check connection status
 bool uart_handler_is_connected(UartHandler* handler);
 
 // Start/stop receiving
 void uart_handler_start_rx(UartHandler* handler);
 void uart_handler_stop_rx(UartHandler* handler);
+
+// Transport operations, the instance is a UartHandler
+extern const ChameleonTransportInterface uart_handler_transport;
@@ -1,11 +1,19 @@
 #include "../chameleon_app_i.h"
 
-#define BLE_CONNECT_CUSTOM_EVENT_BASE 1000
+// Submenu items send device ids, scene events come after them
+#define BLE_CONNECT_CUSTOM_EVENT_BASE BLE_HANDLER_DEVICE_ID_LIMIT
 
 typedef enum {
     BleConnectEventAnimationDone = BLE_CONNECT_CUSTOM_EVENT_BASE,
 } BleConnectEvent;
 
+// Scene state, the list stays put while a connect runs in the background
+typedef enum {
+    BleConnectStateList,
+    BleConnectStateConnecting,
+    BleConnectStateDone,
+} BleConnectState;
+
 static void chameleon_scene_ble_connect_submenu_callback(void* context, uint32_t index) {
     ChameleonApp* app = context;
     view_dispatcher_send_custom_event(app->view_dispatcher, index);
@@ -16,66 +24,94 @@ static void chameleon_scene_ble_connect_animation_callback(void* context) {
     view_dispatcher_send_custom_event(app->view_dispatcher, BleConnectEventAnimationDone);
 }
 
-void chameleon_scene_ble_connect_on_enter(void* context) {
-    ChameleonApp* app = context;
+// List found devices nearest first. The scan keeps adding and reordering
+// them, a kept selection follows its device, otherwise the nearest is selected.
+static void chameleon_scene_ble_connect_list_devices(ChameleonApp* app, bool keep_selection) {
     Submenu* submenu = app->submenu;
+    uint32_t selected = submenu_get_selected_item(submenu);
 
     submenu_reset(submenu);
 
-    // Add found devices to submenu
-    size_t device_count = ble_handler_get_device_count(app->ble_handler);
-    for(size_t i = 0; i < device_count; i++) {
-        const char* device_name = ble_handler_get_device_name(app->ble_handler, i);
-        submenu_add_item(submenu, device_name, i, chameleon_scene_ble_connect_submenu_callback, app);
+    BleHandlerDevice device;
+    char label[BLE_HANDLER_DEVICE_NAME_MAX_LEN + 16];
+    for(size_t rank = 0; ble_handler_get_device(app->ble_handler, rank, &device); rank++) {
+        if(rank == 0 && !keep_selection) {
+            selected = device.id;
+        }
+        snprintf(label, sizeof(label), "%s %d dBm", device.name, device.rssi);
+        submenu_add_item(
+            submenu, label, device.id, chameleon_scene_ble_connect_submenu_callback, app);
     }
 
+    submenu_set_selected_item(submenu, selected);
+}
+
+void chameleon_scene_ble_connect_on_enter(void* context) {
+    ChameleonApp* app = context;
+
+    scene_manager_set_scene_state(
+        app->scene_manager, ChameleonSceneBleConnect, BleConnectStateList);
+    chameleon_scene_ble_connect_list_devices(app, false);
+
     view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
 }
 
 bool chameleon_scene_ble_connect_on_event(void* context, SceneManagerEvent event) {
     ChameleonApp* app = context;
     bool consumed = false;
+    uint32_t state = scene_manager_get_scene_state(app->scene_manager, ChameleonSceneBleConnect);
+
+    if(event.type == SceneManagerEventTypeBack && state == BleConnectStateConnecting) {
+        // The connect finishes or times out on its own
+        consumed = true;
+    } else if(event.type == SceneManagerEventTypeBack) {
+        // Going back to the scan scene would bring us straight here again
+        ble_handler_stop_scan(app->ble_handler);
+        scene_manager_search_and_switch_to_previous_scene(
+            app->scene_manager, ChameleonSceneMainMenu);
+        consumed = true;
+    } else if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == ChameleonCustomEventBleDevicesChanged) {
+            if(state == BleConnectStateList) {
+                chameleon_scene_ble_connect_list_devices(app, true);
+            }
+            consumed = true;
+        } else if(event.event == ChameleonCustomEventOperationSuccess) {
+            scene_manager_set_scene_state(
+                app->scene_manager, ChameleonSceneBleConnect, BleConnectStateDone);
+
+            // Show the fun animation of chameleon and dolphin at the bar!
+            chameleon_animation_view_set_callback(
+                app->animation_view, chameleon_scene_ble_connect_animation_callback, app);
 
-    if(event.type == SceneManagerEventTypeCustom) {
-        if(event.event == BleConnectEventAnimationDone) {
-            // Animation finished, go back to main menu
+            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewAnimation);
+            chameleon_animation_view_start(app->animation_view);
+            consumed = true;
+        } else if(event.event == ChameleonCustomEventOperationFailure) {
+            scene_manager_set_scene_state(
+                app->scene_manager, ChameleonSceneBleConnect, BleConnectStateDone);
+            app->connection_status = ChameleonStatusError;
+            chameleon_app_show_popup(app, "Error", "Failed to connect", 2000);
+            consumed = true;
+        } else if(event.event == BleConnectEventAnimationDone ||
+           event.event == ChameleonCustomEventPopupDone) {
+            // Animation or error popup finished, go back to main menu
             scene_manager_search_and_switch_to_previous_scene(app->scene_manager, ChameleonSceneMainMenu);
             consumed = true;
-        } else if(event.event < BLE_CONNECT_CUSTOM_EVENT_BASE) {
-            // Device selected (index)
-            size_t device_index = event.event;
+        } else if(event.event < BLE_CONNECT_CUSTOM_EVENT_BASE && state == BleConnectStateList) {
+            // Device selected (id), connecting takes seconds when it is far
+            size_t device_id = event.event;
+
+            scene_manager_set_scene_state(
+                app->scene_manager, ChameleonSceneBleConnect, BleConnectStateConnecting);
 
             popup_reset(app->popup);
             popup_set_header(app->popup, "Connecting...", 64, 10, AlignCenter, AlignTop);
             popup_set_text(app->popup, "BLE Connection", 64, 32, AlignCenter, AlignCenter);
             view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
 
-            furi_delay_ms(1000);
-
-            if(ble_handler_connect(app->ble_handler, device_index)) {
-                // Set RX callback for BLE
-                ble_handler_set_rx_callback(app->ble_handler, chameleon_app_rx_callback, app);
-                
-                // Update connection state
-                app->connection_type = ChameleonConnectionBLE;
-                app->connection_status = ChameleonStatusConnected;
-
-                // Show the fun animation of chameleon and dolphin at the bar!
-                chameleon_animation_view_set_callback(
-                    app->animation_view,
-                    chameleon_scene_ble_connect_animation_callback,
-                    app);
-
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewAnimation);
-                chameleon_animation_view_start(app->animation_view);
-            } else {
-                popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-                popup_set_text(app->popup, "Failed to connect", 64, 32, AlignCenter, AlignCenter);
-                app->connection_status = ChameleonStatusError;
-
-                furi_delay_ms(2000);
-                scene_manager_search_and_switch_to_previous_scene(app->scene_manager, ChameleonSceneMainMenu);
-            }
+            chameleon_app_connect_ble_device_async(
+                app, device_id, chameleon_app_operation_event_callback, app);
 
             consumed = true;
         }
@@ -86,6 +122,7 @@ bool chameleon_scene_ble_connect_on_event(void* context, SceneManagerEvent event
 
 void chameleon_scene_ble_connect_on_exit(void* context) {
     ChameleonApp* app = context;
+    chameleon_app_ble_connect_wait(app);
     submenu_reset(app->submenu);
     popup_reset(app->popup);
     chameleon_animation_view_stop(app->animation_view);
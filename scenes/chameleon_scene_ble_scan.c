@@ -4,20 +4,24 @@ typedef enum {
     BleScanEventAnimationDone = 0,
 } BleScanEvent;
 
+// Scene state, which animation is playing
+typedef enum {
+    BleScanStateReconnecting, // Popup shown while the last device is tried
+    BleScanStateScanning,
+    BleScanStateError,
+    BleScanStateConnected,
+} BleScanState;
+
 static void chameleon_scene_ble_scan_animation_callback(void* context) {
     ChameleonApp* app = context;
     view_dispatcher_send_custom_event(app->view_dispatcher, BleScanEventAnimationDone);
 }
 
-void chameleon_scene_ble_scan_on_enter(void* context) {
-    ChameleonApp* app = context;
+static void chameleon_scene_ble_scan_start(ChameleonApp* app) {
+    scene_manager_set_scene_state(app->scene_manager, ChameleonSceneBleScan, BleScanStateScanning);
 
     // Show scanning animation
     chameleon_animation_view_set_type(app->animation_view, ChameleonAnimationScan);
-    chameleon_animation_view_set_callback(
-        app->animation_view,
-        chameleon_scene_ble_scan_animation_callback,
-        app);
 
     view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewAnimation);
     chameleon_animation_view_start(app->animation_view);
@@ -26,12 +30,60 @@ void chameleon_scene_ble_scan_on_enter(void* context) {
     chameleon_app_connect_ble(app);
 }
 
+void chameleon_scene_ble_scan_on_enter(void* context) {
+    ChameleonApp* app = context;
+
+    chameleon_animation_view_set_callback(
+        app->animation_view,
+        chameleon_scene_ble_scan_animation_callback,
+        app);
+
+    // The last device is usually still around, skip the scan when it answers
+    if(chameleon_app_reconnect_ble_async(app, chameleon_app_operation_event_callback, app)) {
+        scene_manager_set_scene_state(
+            app->scene_manager, ChameleonSceneBleScan, BleScanStateReconnecting);
+
+        popup_reset(app->popup);
+        popup_set_header(app->popup, "Connecting...", 64, 10, AlignCenter, AlignTop);
+        popup_set_text(app->popup, "Last BLE device", 64, 32, AlignCenter, AlignCenter);
+        view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
+        return;
+    }
+
+    chameleon_scene_ble_scan_start(app);
+}
+
 bool chameleon_scene_ble_scan_on_event(void* context, SceneManagerEvent event) {
     ChameleonApp* app = context;
     bool consumed = false;
+    uint32_t state = scene_manager_get_scene_state(app->scene_manager, ChameleonSceneBleScan);
 
-    if(event.type == SceneManagerEventTypeCustom) {
-        if(event.event == BleScanEventAnimationDone) {
+    if(event.type == SceneManagerEventTypeBack && state == BleScanStateReconnecting) {
+        // The reconnect gives up on its own within a few seconds
+        consumed = true;
+    } else if(event.type == SceneManagerEventTypeCustom) {
+        if(event.event == ChameleonCustomEventOperationSuccess &&
+           state == BleScanStateReconnecting) {
+            scene_manager_set_scene_state(
+                app->scene_manager, ChameleonSceneBleScan, BleScanStateConnected);
+            chameleon_animation_view_set_type(app->animation_view, ChameleonAnimationHandshake);
+            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewAnimation);
+            chameleon_animation_view_start(app->animation_view);
+            consumed = true;
+        } else if(event.event == ChameleonCustomEventOperationFailure &&
+           state == BleScanStateReconnecting) {
+            chameleon_scene_ble_scan_start(app);
+            consumed = true;
+        } else if(event.event == ChameleonCustomEventBleDevicesChanged &&
+           state == BleScanStateScanning) {
+            // List the first Chameleon right away, the scan goes on there
+            scene_manager_next_scene(app->scene_manager, ChameleonSceneBleConnect);
+            consumed = true;
+        } else if(event.event == BleScanEventAnimationDone && state != BleScanStateScanning) {
+            // Handshake or error animation finished, return to main menu
+            scene_manager_search_and_switch_to_previous_scene(app->scene_manager, ChameleonSceneMainMenu);
+            consumed = true;
+        } else if(event.event == BleScanEventAnimationDone) {
             // Animation finished, check scan results
             size_t device_count = ble_handler_get_device_count(app->ble_handler);
 
@@ -40,12 +92,10 @@ bool chameleon_scene_ble_scan_on_event(void* context, SceneManagerEvent event) {
                 scene_manager_next_scene(app->scene_manager, ChameleonSceneBleConnect);
             } else {
                 // No devices found, show error animation then return
+                scene_manager_set_scene_state(
+                    app->scene_manager, ChameleonSceneBleScan, BleScanStateError);
                 chameleon_animation_view_set_type(app->animation_view, ChameleonAnimationError);
                 chameleon_animation_view_start(app->animation_view);
-                
-                // After error animation, return to main menu
-                furi_delay_ms(2000);
-                scene_manager_search_and_switch_to_previous_scene(app->scene_manager, ChameleonSceneMainMenu);
             }
             consumed = true;
         }
@@ -56,5 +106,7 @@ bool chameleon_scene_ble_scan_on_event(void* context, SceneManagerEvent event) {
 
 void chameleon_scene_ble_scan_on_exit(void* context) {
     ChameleonApp* app = context;
+    chameleon_app_ble_connect_wait(app);
+    popup_reset(app->popup);
     chameleon_animation_view_stop(app->animation_view);
 }
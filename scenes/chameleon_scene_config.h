@@ -10,4 +10,5 @@ ADD_SCENE(chameleon, slot_rename, SlotRename)
 ADD_SCENE(chameleon, tag_read, TagRead)
 ADD_SCENE(chameleon, tag_write, TagWrite)
 ADD_SCENE(chameleon, diagnostic, Diagnostic)
+ADD_SCENE(chameleon, link_bench, LinkBench)
 ADD_SCENE(chameleon, about, About)
@@ -1,40 +1,86 @@
 #include "../chameleon_app_i.h"
 
-void chameleon_scene_diagnostic_on_enter(void* context) {
-    ChameleonApp* app = context;
+static void chameleon_scene_diagnostic_show(ChameleonApp* app, bool loaded) {
     Widget* widget = app->widget;
+    ChameleonDeviceInfo info;
+    chameleon_app_copy_device_info(app, &info);
 
     widget_reset(widget);
 
-    // Get device info
-    chameleon_app_get_device_info(app);
-
-    char info_text[256];
-    snprintf(
-        info_text,
-        sizeof(info_text),
-        "Chameleon Ultra\nDiagnostic Info\n\n"
-        "Firmware: %d.%d\n"
-        "Model: %s\n"
-        "Mode: %s\n"
-        "Chip ID: %llX\n"
-        "Connection: %s",
-        app->device_info.major_version,
-        app->device_info.minor_version,
-        app->device_info.model == ChameleonModelUltra ? "Ultra" : "Lite",
-        app->device_info.mode == ChameleonModeReader ? "Reader" : "Emulator",
-        app->device_info.chip_id,
-        app->connection_type == ChameleonConnectionUSB ? "USB" : "Bluetooth");
+    char info_text[320];
+    if(!loaded || !info.valid) {
+        snprintf(
+            info_text,
+            sizeof(info_text),
+            "Chameleon Ultra\nDiagnostic Info\n\n"
+            "Device info unavailable\n"
+            "Connection: %s",
+            app->connection_type == ChameleonConnectionUSB ? "USB" : "Bluetooth");
+    } else {
+        snprintf(
+            info_text,
+            sizeof(info_text),
+            "Chameleon Ultra\nDiagnostic Info\n\n"
+            "Firmware: %d.%d\n"
+            "Git: %s\n"
+            "Model: %s\n"
+            "Mode: %s\n"
+            "Chip ID: %llX\n"
+            "Connection: %s",
+            info.major_version,
+            info.minor_version,
+            info.git_version,
+            info.model == ChameleonModelUltra ? "Ultra" : "Lite",
+            info.mode == ChameleonModeReader ? "Reader" : "Emulator",
+            info.chip_id,
+            app->connection_type == ChameleonConnectionUSB ? "USB" : "Bluetooth");
+    }
+
+    if(chameleon_transport_is_bound(&app->transport)) {
+        ChameleonTransportStats stats;
+        chameleon_transport_get_stats(&app->transport, &stats);
+
+        size_t used = strlen(info_text);
+        snprintf(
+            info_text + used,
+            sizeof(info_text) - used,
+            "\nTX: %lu B, RX: %lu B\nRX dropped %lu, peak %zu B",
+            stats.tx_bytes,
+            stats.rx_bytes,
+            stats.rx_dropped,
+            stats.rx_high_water);
+    }
 
     widget_add_text_scroll_element(widget, 0, 0, 128, 64, info_text);
 
     view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewWidget);
 }
 
+void chameleon_scene_diagnostic_on_enter(void* context) {
+    ChameleonApp* app = context;
+
+    widget_reset(app->widget);
+
+    // Get device info, cached after the first successful fetch
+    view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewLoading);
+
+    if(!chameleon_app_get_device_info_async(app, chameleon_app_operation_event_callback, app)) {
+        chameleon_scene_diagnostic_show(app, false);
+    }
+}
+
 bool chameleon_scene_diagnostic_on_event(void* context, SceneManagerEvent event) {
-    UNUSED(context);
-    UNUSED(event);
-    return false;
+    ChameleonApp* app = context;
+    bool consumed = false;
+
+    if(event.type == SceneManagerEventTypeCustom &&
+       (event.event == ChameleonCustomEventOperationSuccess ||
+        event.event == ChameleonCustomEventOperationFailure)) {
+        chameleon_scene_diagnostic_show(app, event.event == ChameleonCustomEventOperationSuccess);
+        consumed = true;
+    }
+
+    return consumed;
 }
 
 void chameleon_scene_diagnostic_on_exit(void* context) {
@@ -0,0 +1,135 @@
+#include "../chameleon_app_i.h"
+
+// Requests per run, enough for a p99 without keeping BLE busy for long
+#define LINK_BENCH_ITERATIONS 50
+
+#define LINK_BENCH_RUNS (ChameleonBenchCaseNum * 2)
+
+#define LINK_BENCH_TEXT_SIZE 1024
+
+// Even runs measure round trips, odd runs keep the window full
+static uint8_t chameleon_scene_link_bench_depth(uint32_t run) {
+    return run % 2 ? CHAMELEON_ENGINE_WINDOW : 1;
+}
+
+// Show results of the runs before the given one, the scene state
+static void chameleon_scene_link_bench_show(ChameleonApp* app, uint32_t run) {
+    char* text = malloc(LINK_BENCH_TEXT_SIZE);
+    size_t used = snprintf(
+        text,
+        LINK_BENCH_TEXT_SIZE,
+        "Link Benchmark\nTransport: %s\n",
+        chameleon_transport_is_bound(&app->transport) ? app->transport.interface->name : "None");
+
+    for(uint32_t i = 0; i < run && used < LINK_BENCH_TEXT_SIZE; i++) {
+        const ChameleonBenchResult* result = &app->bench_results[i];
+
+        used += snprintf(
+            text + used,
+            LINK_BENCH_TEXT_SIZE - used,
+            "\n%s, depth %u\n",
+            chameleon_bench_case_name(i / 2),
+            chameleon_scene_link_bench_depth(i));
+        if(used >= LINK_BENCH_TEXT_SIZE) break;
+
+        if(result->requests == 0) {
+            used += snprintf(
+                text + used,
+                LINK_BENCH_TEXT_SIZE - used,
+                result->errors ? " %lu failed\n" : " Not available\n",
+                result->errors);
+            continue;
+        }
+
+        used += snprintf(
+            text + used,
+            LINK_BENCH_TEXT_SIZE - used,
+            " min/avg %lu/%lu us\n"
+            " p50/p99 %lu/%lu us\n"
+            " %lu req/s, %lu B/s\n",
+            result->min_us,
+            result->avg_us,
+            result->p50_us,
+            result->p99_us,
+            result->requests_per_s,
+            result->bytes_per_s);
+        if(result->errors && used < LINK_BENCH_TEXT_SIZE) {
+            used += snprintf(
+                text + used, LINK_BENCH_TEXT_SIZE - used, " %lu failed\n", result->errors);
+        }
+    }
+
+    if(run < LINK_BENCH_RUNS && used < LINK_BENCH_TEXT_SIZE) {
+        snprintf(
+            text + used,
+            LINK_BENCH_TEXT_SIZE - used,
+            "\nRunning %s, depth %u...",
+            chameleon_bench_case_name(run / 2),
+            chameleon_scene_link_bench_depth(run));
+    }
+
+    widget_reset(app->widget);
+    widget_add_text_scroll_element(app->widget, 0, 0, 128, 64, text);
+    free(text);
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewWidget);
+}
+
+// Start the first run from the given one the device supports, returns
+// LINK_BENCH_RUNS once every run is done
+static uint32_t chameleon_scene_link_bench_start(ChameleonApp* app, uint32_t run) {
+    for(; run < LINK_BENCH_RUNS; run++) {
+        if(chameleon_bench_start(
+               app->bench,
+               run / 2,
+               LINK_BENCH_ITERATIONS,
+               chameleon_scene_link_bench_depth(run),
+               chameleon_app_operation_event_callback,
+               app)) {
+            break;
+        }
+        memset(&app->bench_results[run], 0, sizeof(ChameleonBenchResult));
+    }
+
+    scene_manager_set_scene_state(app->scene_manager, ChameleonSceneLinkBench, run);
+    return run;
+}
+
+void chameleon_scene_link_bench_on_enter(void* context) {
+    ChameleonApp* app = context;
+
+    app->bench = chameleon_bench_alloc(app->engine);
+
+    uint32_t run = chameleon_scene_link_bench_start(app, 0);
+    chameleon_scene_link_bench_show(app, run);
+}
+
+bool chameleon_scene_link_bench_on_event(void* context, SceneManagerEvent event) {
+    ChameleonApp* app = context;
+    bool consumed = false;
+
+    if(event.type == SceneManagerEventTypeCustom &&
+       (event.event == ChameleonCustomEventOperationSuccess ||
+        event.event == ChameleonCustomEventOperationFailure)) {
+        uint32_t run = scene_manager_get_scene_state(app->scene_manager, ChameleonSceneLinkBench);
+
+        if(run < LINK_BENCH_RUNS) {
+            chameleon_bench_get_result(app->bench, &app->bench_results[run]);
+            run = chameleon_scene_link_bench_start(app, run + 1);
+            chameleon_scene_link_bench_show(app, run);
+        }
+        consumed = true;
+    }
+
+    return consumed;
+}
+
+void chameleon_scene_link_bench_on_exit(void* context) {
+    ChameleonApp* app = context;
+
+    // Waits for requests still in flight
+    chameleon_bench_free(app->bench);
+    app->bench = NULL;
+
+    widget_reset(app->widget);
+}
@@ -6,6 +6,7 @@ typedef enum {
     SubmenuIndexReadTag,
     SubmenuIndexWriteTag,
     SubmenuIndexDiagnostic,
+    SubmenuIndexLinkBench,
     SubmenuIndexAbout,
 } SubmenuIndex;
 
@@ -14,9 +15,10 @@ static void chameleon_scene_main_menu_submenu_callback(void* context, uint32_t i
     view_dispatcher_send_custom_event(app->view_dispatcher, index);
 }
 
-void chameleon_scene_main_menu_on_enter(void* context) {
-    ChameleonApp* app = context;
+// Capabilities arrive after connecting, rebuilt when they do
+static void chameleon_scene_main_menu_build(ChameleonApp* app) {
     Submenu* submenu = app->submenu;
+    uint32_t selected = submenu_get_selected_item(submenu);
 
     submenu_reset(submenu);
 
@@ -27,31 +29,48 @@ void chameleon_scene_main_menu_on_enter(void* context) {
         chameleon_scene_main_menu_submenu_callback,
         app);
 
-    submenu_add_item(
-        submenu,
-        "Manage Slots",
-        SubmenuIndexSlots,
-        chameleon_scene_main_menu_submenu_callback,
-        app);
+    // Hide features the connected device reports it cannot do, while
+    // disconnected everything is shown and selecting it explains why
+    if(chameleon_app_supports(app, CMD_GET_SLOT_INFO)) {
+        submenu_add_item(
+            submenu,
+            "Manage Slots",
+            SubmenuIndexSlots,
+            chameleon_scene_main_menu_submenu_callback,
+            app);
+    }
 
-    submenu_add_item(
-        submenu,
-        "Read Tag",
-        SubmenuIndexReadTag,
-        chameleon_scene_main_menu_submenu_callback,
-        app);
+    if(chameleon_app_supports(app, CMD_HF14A_SCAN) ||
+       chameleon_app_supports(app, CMD_EM410X_SCAN)) {
+        submenu_add_item(
+            submenu,
+            "Read Tag",
+            SubmenuIndexReadTag,
+            chameleon_scene_main_menu_submenu_callback,
+            app);
+    }
+
+    if(chameleon_app_supports(app, CMD_MF1_WRITE_EMU_BLOCK_DATA) ||
+       chameleon_app_supports(app, CMD_EM410X_SET_EMU_ID)) {
+        submenu_add_item(
+            submenu,
+            "Write to Chameleon",
+            SubmenuIndexWriteTag,
+            chameleon_scene_main_menu_submenu_callback,
+            app);
+    }
 
     submenu_add_item(
         submenu,
-        "Write to Chameleon",
-        SubmenuIndexWriteTag,
+        "Diagnostic",
+        SubmenuIndexDiagnostic,
         chameleon_scene_main_menu_submenu_callback,
         app);
 
     submenu_add_item(
         submenu,
-        "Diagnostic",
-        SubmenuIndexDiagnostic,
+        "Link Benchmark",
+        SubmenuIndexLinkBench,
         chameleon_scene_main_menu_submenu_callback,
         app);
 
@@ -62,6 +81,14 @@ void chameleon_scene_main_menu_on_enter(void* context) {
         chameleon_scene_main_menu_submenu_callback,
         app);
 
+    // Stays on the item shown before, the first one if it was hidden
+    submenu_set_selected_item(submenu, selected);
+}
+
+void chameleon_scene_main_menu_on_enter(void* context) {
+    ChameleonApp* app = context;
+
+    chameleon_scene_main_menu_build(app);
     view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
 }
 
@@ -84,12 +111,7 @@ bool chameleon_scene_main_menu_on_event(void* context, SceneManagerEvent event)
             if(app->connection_status == ChameleonStatusConnected) {
                 scene_manager_next_scene(app->scene_manager, ChameleonSceneSlotList);
             } else {
-                // Show error popup
-                popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-                popup_set_text(app->popup, "Not connected\nto device", 64, 32, AlignCenter, AlignCenter);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-                furi_delay_ms(1500);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
+                chameleon_app_show_popup(app, "Error", "Not connected\nto device", 1500);
             }
             consumed = true;
             break;
@@ -97,11 +119,7 @@ bool chameleon_scene_main_menu_on_event(void* context, SceneManagerEvent event)
             if(app->connection_status == ChameleonStatusConnected) {
                 scene_manager_next_scene(app->scene_manager, ChameleonSceneTagRead);
             } else {
-                popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-                popup_set_text(app->popup, "Not connected\nto device", 64, 32, AlignCenter, AlignCenter);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-                furi_delay_ms(1500);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
+                chameleon_app_show_popup(app, "Error", "Not connected\nto device", 1500);
             }
             consumed = true;
             break;
@@ -109,11 +127,7 @@ bool chameleon_scene_main_menu_on_event(void* context, SceneManagerEvent event)
             if(app->connection_status == ChameleonStatusConnected) {
                 scene_manager_next_scene(app->scene_manager, ChameleonSceneTagWrite);
             } else {
-                popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-                popup_set_text(app->popup, "Not connected\nto device", 64, 32, AlignCenter, AlignCenter);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-                furi_delay_ms(1500);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
+                chameleon_app_show_popup(app, "Error", "Not connected\nto device", 1500);
             }
             consumed = true;
             break;
@@ -121,11 +135,15 @@ bool chameleon_scene_main_menu_on_event(void* context, SceneManagerEvent event)
             if(app->connection_status == ChameleonStatusConnected) {
                 scene_manager_next_scene(app->scene_manager, ChameleonSceneDiagnostic);
             } else {
-                popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-                popup_set_text(app->popup, "Not connected\nto device", 64, 32, AlignCenter, AlignCenter);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-                furi_delay_ms(1500);
-                view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
+                chameleon_app_show_popup(app, "Error", "Not connected\nto device", 1500);
+            }
+            consumed = true;
+            break;
+        case SubmenuIndexLinkBench:
+            if(app->connection_status == ChameleonStatusConnected) {
+                scene_manager_next_scene(app->scene_manager, ChameleonSceneLinkBench);
+            } else {
+                chameleon_app_show_popup(app, "Error", "Not connected\nto device", 1500);
             }
             consumed = true;
             break;
@@ -133,6 +151,19 @@ bool chameleon_scene_main_menu_on_event(void* context, SceneManagerEvent event)
             scene_manager_next_scene(app->scene_manager, ChameleonSceneAbout);
             consumed = true;
             break;
+        case ChameleonCustomEventPopupDone:
+            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
+            consumed = true;
+            break;
+        case ChameleonCustomEventCapabilitiesChanged:
+            chameleon_scene_main_menu_build(app);
+            consumed = true;
+            break;
+        case ChameleonCustomEventBleLinkLost:
+            chameleon_scene_main_menu_build(app);
+            chameleon_app_show_popup(app, "Disconnected", "BLE link lost", 1500);
+            consumed = true;
+            break;
         }
     }
 
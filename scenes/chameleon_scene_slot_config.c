@@ -19,28 +19,36 @@ void chameleon_scene_slot_config_on_enter(void* context) {
     submenu_reset(submenu);
 
     char header[32];
-    snprintf(header, sizeof(header), "Slot %d Configuration", app->active_slot);
-
-    submenu_add_item(
-        submenu,
-        "Activate Slot",
-        SubmenuIndexActivate,
-        chameleon_scene_slot_config_submenu_callback,
-        app);
-
-    submenu_add_item(
-        submenu,
-        "Rename Slot",
-        SubmenuIndexRename,
-        chameleon_scene_slot_config_submenu_callback,
-        app);
-
-    submenu_add_item(
-        submenu,
-        "Change Tag Type",
-        SubmenuIndexChangeType,
-        chameleon_scene_slot_config_submenu_callback,
-        app);
+    snprintf(
+        header, sizeof(header), "Slot %d Configuration", chameleon_app_get_active_slot(app));
+
+    // Only offer operations the device supports
+    if(chameleon_app_supports(app, CMD_SET_ACTIVE_SLOT)) {
+        submenu_add_item(
+            submenu,
+            "Activate Slot",
+            SubmenuIndexActivate,
+            chameleon_scene_slot_config_submenu_callback,
+            app);
+    }
+
+    if(chameleon_app_supports(app, CMD_SET_SLOT_TAG_NICK)) {
+        submenu_add_item(
+            submenu,
+            "Rename Slot",
+            SubmenuIndexRename,
+            chameleon_scene_slot_config_submenu_callback,
+            app);
+    }
+
+    if(chameleon_app_supports(app, CMD_SET_SLOT_TAG_TYPE)) {
+        submenu_add_item(
+            submenu,
+            "Change Tag Type",
+            SubmenuIndexChangeType,
+            chameleon_scene_slot_config_submenu_callback,
+            app);
+    }
 
     submenu_set_header(submenu, header);
 
@@ -54,16 +62,33 @@ bool chameleon_scene_slot_config_on_event(void* context, SceneManagerEvent event
     if(event.type == SceneManagerEventTypeCustom) {
         switch(event.event) {
         case SubmenuIndexActivate:
-            if(chameleon_app_set_active_slot(app, app->active_slot)) {
-                popup_set_header(app->popup, "Success", 64, 10, AlignCenter, AlignTop);
-                snprintf(app->text_buffer, sizeof(app->text_buffer), "Slot %d activated", app->active_slot);
-                popup_set_text(app->popup, app->text_buffer, 64, 32, AlignCenter, AlignCenter);
-            } else {
-                popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-                popup_set_text(app->popup, "Failed to activate", 64, 32, AlignCenter, AlignCenter);
+            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewLoading);
+            if(!chameleon_app_set_active_slot_async(
+                   app,
+                   chameleon_app_get_active_slot(app),
+                   chameleon_app_operation_event_callback,
+                   app)) {
+                chameleon_app_show_popup(app, "Error", "Failed to activate", 1500);
             }
-            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-            furi_delay_ms(1500);
+            consumed = true;
+            break;
+
+        case ChameleonCustomEventOperationSuccess:
+            snprintf(
+                app->text_buffer,
+                sizeof(app->text_buffer),
+                "Slot %d activated",
+                chameleon_app_get_active_slot(app));
+            chameleon_app_show_popup(app, "Success", app->text_buffer, 1500);
+            consumed = true;
+            break;
+
+        case ChameleonCustomEventOperationFailure:
+            chameleon_app_show_popup(app, "Error", "Failed to activate", 1500);
+            consumed = true;
+            break;
+
+        case ChameleonCustomEventPopupDone:
             view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
             consumed = true;
             break;
@@ -74,11 +99,8 @@ bool chameleon_scene_slot_config_on_event(void* context, SceneManagerEvent event
             break;
 
         case SubmenuIndexChangeType:
-            popup_set_header(app->popup, "Coming Soon", 64, 10, AlignCenter, AlignTop);
-            popup_set_text(app->popup, "Tag type change\nnot yet implemented", 64, 32, AlignCenter, AlignCenter);
-            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-            furi_delay_ms(1500);
-            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
+            chameleon_app_show_popup(
+                app, "Coming Soon", "Tag type change\nnot yet implemented", 1500);
             consumed = true;
             break;
         }
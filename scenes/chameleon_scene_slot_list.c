@@ -5,20 +5,20 @@ static void chameleon_scene_slot_list_submenu_callback(void* context, uint32_t i
     view_dispatcher_send_custom_event(app->view_dispatcher, index);
 }
 
-void chameleon_scene_slot_list_on_enter(void* context) {
-    ChameleonApp* app = context;
+static void chameleon_scene_slot_list_populate(ChameleonApp* app, bool loaded) {
     Submenu* submenu = app->submenu;
 
     submenu_reset(submenu);
 
-    // Get slot information from device
-    chameleon_app_get_slots_info(app);
-
     // Add slots to submenu
     for(uint8_t i = 0; i < 8; i++) {
         char slot_label[64];
-        if(strlen(app->slots[i].nickname) > 0) {
-            snprintf(slot_label, sizeof(slot_label), "Slot %d: %s", i, app->slots[i].nickname);
+        ChameleonSlot slot;
+        chameleon_app_copy_slot(app, i, &slot);
+        if(!loaded) {
+            snprintf(slot_label, sizeof(slot_label), "Slot %d (No data)", i);
+        } else if(strlen(slot.nickname) > 0) {
+            snprintf(slot_label, sizeof(slot_label), "Slot %d: %s", i, slot.nickname);
         } else {
             snprintf(slot_label, sizeof(slot_label), "Slot %d (Empty)", i);
         }
@@ -28,13 +28,32 @@ void chameleon_scene_slot_list_on_enter(void* context) {
     view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewSubmenu);
 }
 
+void chameleon_scene_slot_list_on_enter(void* context) {
+    ChameleonApp* app = context;
+
+    submenu_reset(app->submenu);
+
+    // Get slot information from device, the list is filled in on completion
+    view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewLoading);
+
+    if(!chameleon_app_get_slots_info_async(app, chameleon_app_operation_event_callback, app)) {
+        chameleon_scene_slot_list_populate(app, false);
+    }
+}
+
 bool chameleon_scene_slot_list_on_event(void* context, SceneManagerEvent event) {
     ChameleonApp* app = context;
     bool consumed = false;
 
     if(event.type == SceneManagerEventTypeCustom) {
-        app->active_slot = (uint8_t)event.event;
-        scene_manager_next_scene(app->scene_manager, ChameleonSceneSlotConfig);
+        if(event.event == ChameleonCustomEventOperationSuccess ||
+           event.event == ChameleonCustomEventOperationFailure) {
+            chameleon_scene_slot_list_populate(
+                app, event.event == ChameleonCustomEventOperationSuccess);
+        } else if(event.event < CHAMELEON_SLOT_COUNT) {
+            chameleon_app_select_slot(app, (uint8_t)event.event);
+            scene_manager_next_scene(app->scene_manager, ChameleonSceneSlotConfig);
+        }
         consumed = true;
     }
 
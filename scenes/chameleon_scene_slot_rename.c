@@ -1,8 +1,12 @@
 #include "../chameleon_app_i.h"
 
+typedef enum {
+    SlotRenameEventSave = 0,
+} SlotRenameEvent;
+
 static void chameleon_scene_slot_rename_text_input_callback(void* context) {
     ChameleonApp* app = context;
-    view_dispatcher_send_custom_event(app->view_dispatcher, 0);
+    view_dispatcher_send_custom_event(app->view_dispatcher, SlotRenameEventSave);
 }
 
 void chameleon_scene_slot_rename_on_enter(void* context) {
@@ -10,7 +14,9 @@ void chameleon_scene_slot_rename_on_enter(void* context) {
     TextInput* text_input = app->text_input;
 
     // Copy current nickname to buffer
-    strncpy(app->text_buffer, app->slots[app->active_slot].nickname, sizeof(app->text_buffer) - 1);
+    ChameleonSlot slot;
+    chameleon_app_copy_slot(app, chameleon_app_get_active_slot(app), &slot);
+    strncpy(app->text_buffer, slot.nickname, sizeof(app->text_buffer) - 1);
 
     text_input_reset(text_input);
     text_input_set_header_text(text_input, "Enter slot name:");
@@ -30,19 +36,32 @@ bool chameleon_scene_slot_rename_on_event(void* context, SceneManagerEvent event
     bool consumed = false;
 
     if(event.type == SceneManagerEventTypeCustom) {
-        // Save nickname
-        if(chameleon_app_set_slot_nickname(app, app->active_slot, app->text_buffer)) {
-            popup_set_header(app->popup, "Success", 64, 10, AlignCenter, AlignTop);
-            popup_set_text(app->popup, "Slot renamed", 64, 32, AlignCenter, AlignCenter);
-        } else {
-            popup_set_header(app->popup, "Error", 64, 10, AlignCenter, AlignTop);
-            popup_set_text(app->popup, "Failed to rename", 64, 32, AlignCenter, AlignCenter);
-        }
+        switch(event.event) {
+        case SlotRenameEventSave:
+            // Save nickname, the result arrives as an operation event
+            view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewLoading);
+            if(!chameleon_app_set_slot_nickname_async(
+                   app,
+                   chameleon_app_get_active_slot(app),
+                   app->text_buffer,
+                   chameleon_app_operation_event_callback,
+                   app)) {
+                chameleon_app_show_popup(app, "Error", "Failed to rename", 1500);
+            }
+            break;
 
-        view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
-        furi_delay_ms(1500);
+        case ChameleonCustomEventOperationSuccess:
+            chameleon_app_show_popup(app, "Success", "Slot renamed", 1500);
+            break;
 
-        scene_manager_previous_scene(app->scene_manager);
+        case ChameleonCustomEventOperationFailure:
+            chameleon_app_show_popup(app, "Error", "Failed to rename", 1500);
+            break;
+
+        case ChameleonCustomEventPopupDone:
+            scene_manager_previous_scene(app->scene_manager);
+            break;
+        }
         consumed = true;
     }
 
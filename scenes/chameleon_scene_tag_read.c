@@ -4,6 +4,12 @@ typedef enum {
     TagReadEventAnimationDone = 0,
 } TagReadEvent;
 
+// Scene state, which animation is playing
+typedef enum {
+    TagReadStateTransfer,
+    TagReadStateSuccess,
+} TagReadState;
+
 static void chameleon_scene_tag_read_animation_callback(void* context) {
     ChameleonApp* app = context;
     view_dispatcher_send_custom_event(app->view_dispatcher, TagReadEventAnimationDone);
@@ -12,6 +18,8 @@ static void chameleon_scene_tag_read_animation_callback(void* context) {
 void chameleon_scene_tag_read_on_enter(void* context) {
     ChameleonApp* app = context;
 
+    scene_manager_set_scene_state(app->scene_manager, ChameleonSceneTagRead, TagReadStateTransfer);
+
     // Show transfer animation for tag reading
     chameleon_animation_view_set_type(app->animation_view, ChameleonAnimationTransfer);
     chameleon_animation_view_set_callback(
@@ -28,14 +36,18 @@ bool chameleon_scene_tag_read_on_event(void* context, SceneManagerEvent event) {
     bool consumed = false;
 
     if(event.type == SceneManagerEventTypeCustom) {
-        if(event.event == TagReadEventAnimationDone) {
+        if(event.event == TagReadEventAnimationDone &&
+           scene_manager_get_scene_state(app->scene_manager, ChameleonSceneTagRead) ==
+               TagReadStateSuccess) {
+            // After success animation, return to previous scene
+            scene_manager_previous_scene(app->scene_manager);
+            consumed = true;
+        } else if(event.event == TagReadEventAnimationDone) {
             // Show success animation
+            scene_manager_set_scene_state(
+                app->scene_manager, ChameleonSceneTagRead, TagReadStateSuccess);
             chameleon_animation_view_set_type(app->animation_view, ChameleonAnimationSuccess);
             chameleon_animation_view_start(app->animation_view);
-            
-            // After success animation, return to previous scene
-            furi_delay_ms(2000);
-            scene_manager_previous_scene(app->scene_manager);
             consumed = true;
         }
     }
@@ -17,8 +17,6 @@ void chameleon_scene_usb_connect_on_enter(void* context) {
     popup_set_text(app->popup, "USB Connection", 64, 32, AlignCenter, AlignCenter);
     view_dispatcher_switch_to_view(app->view_dispatcher, ChameleonViewPopup);
 
-    furi_delay_ms(1000);
-
     // Attempt USB connection
     if(chameleon_app_connect_usb(app)) {
         app->connection_status = ChameleonStatusConnected;